@@ -0,0 +1,175 @@
+/*
+=============================================================================
+	File:	StaticWalkerBenchmark.cpp
+	Desc:	Compares TWalker (inlined callbacks) with Walker2 (virtual calls)
+			on traversal of objects stored in ObjectLists.
+=============================================================================
+*/
+#include <Core/Core_PCH.h>
+#pragma hdrstop
+#include <Core/Core.h>
+
+#include <Base/Object/TWalker.h>
+#include <Base/Object/IterativeWalker.h>
+#include "StaticWalkerBenchmark.h"
+
+// ten fields per object
+struct StaticWalkItem : CStruct
+{
+	UINT32	i0, i1, i2, i3, i4;
+	float	f0, f1, f2, f3, f4;
+public:
+	mxDECLARE_CLASS(StaticWalkItem, CStruct);
+	mxDECLARE_REFLECTION;
+};
+mxDEFINE_CLASS(StaticWalkItem);
+mxBEGIN_REFLECTION(StaticWalkItem)
+	mxMEMBER_FIELD( i0 ),
+	mxMEMBER_FIELD( i1 ),
+	mxMEMBER_FIELD( i2 ),
+	mxMEMBER_FIELD( i3 ),
+	mxMEMBER_FIELD( i4 ),
+	mxMEMBER_FIELD( f0 ),
+	mxMEMBER_FIELD( f1 ),
+	mxMEMBER_FIELD( f2 ),
+	mxMEMBER_FIELD( f3 ),
+	mxMEMBER_FIELD( f4 ),
+mxEND_REFLECTION;
+
+// objects are spread over several lists, like in real clumps
+enum { OBJECTS_PER_LIST = 64*1024 };
+
+// the same tiny visitor in both flavours: the walker's overhead dominates
+struct StaticFieldCounter : Reflection::StaticVisitorBase
+{
+	UINT32	m_numFields;
+	UINT64	m_checksum;
+public:
+	StaticFieldCounter()
+		: m_numFields( 0 ), m_checksum( 0 )
+	{}
+	bool Visit_Field( void * _memory, const mxField& _field, const Context& _context )
+	{
+		m_numFields++;
+		return true;
+	}
+	void Visit_POD( void * _memory, const mxType& _type, const Context& _context )
+	{
+		m_checksum += *static_cast< const UINT32* >( _memory );
+	}
+};
+
+class VirtualFieldCounter : public Reflection::AVisitor2
+{
+public:
+	UINT32	m_numFields;
+	UINT64	m_checksum;
+public:
+	VirtualFieldCounter()
+		: AVisitor2( Reflection::TypeHas_Everything, 0 )
+		, m_numFields( 0 ), m_checksum( 0 )
+	{}
+	virtual bool Visit_Field( void * _memory, const mxField& _field, const Context& _context ) override
+	{
+		m_numFields++;
+		return true;
+	}
+	virtual void Visit_POD( void * _memory, const mxType& _type, const Context& _context ) override
+	{
+		m_checksum += *static_cast< const UINT32* >( _memory );
+	}
+};
+
+static UINT64 TimeStaticWalk( const Clump& _clump, UINT32 &_numFields, UINT64 &_checksum )
+{
+	StaticFieldCounter	counter;
+	const UINT64 startTime = Reflection::GetTimeMicroseconds();
+
+	ObjectList::Head currentList = _clump.GetObjectLists();
+	while( currentList != NULL )
+	{
+		const mxClass& objectType = currentList->GetType();
+		ObjectList::IteratorBase it( *currentList );
+		while( it.IsValid() )
+		{
+			Reflection::StaticWalk( it.ToVoidPtr(), objectType, counter );
+			it.MoveToNext();
+		}
+		currentList = currentList->_next;
+	}
+
+	const UINT64 elapsed = Reflection::GetTimeMicroseconds() - startTime;
+	_numFields = counter.m_numFields;
+	_checksum = counter.m_checksum;
+	return elapsed;
+}
+
+static UINT64 TimeVirtualWalk( const Clump& _clump, UINT32 &_numFields, UINT64 &_checksum )
+{
+	VirtualFieldCounter	counter;
+	const UINT64 startTime = Reflection::GetTimeMicroseconds();
+
+	ObjectList::Head currentList = _clump.GetObjectLists();
+	while( currentList != NULL )
+	{
+		const mxClass& objectType = currentList->GetType();
+		ObjectList::IteratorBase it( *currentList );
+		while( it.IsValid() )
+		{
+			Reflection::Walker2::Visit( it.ToVoidPtr(), objectType, &counter );
+			it.MoveToNext();
+		}
+		currentList = currentList->_next;
+	}
+
+	const UINT64 elapsed = Reflection::GetTimeMicroseconds() - startTime;
+	_numFields = counter.m_numFields;
+	_checksum = counter.m_checksum;
+	return elapsed;
+}
+
+ERet RunStaticWalkerBenchmark( StaticWalkerBenchmarkResult &_result, UINT32 _numObjects )
+{
+	chkRET_X_IF_NOT(_numObjects > 0, ERR_INVALID_PARAMETER);
+
+	Clump	clump;
+	for( UINT32 firstObject = 0; firstObject < _numObjects; firstObject += OBJECTS_PER_LIST )
+	{
+		const UINT32 numListObjects = smallest( _numObjects - firstObject, (UINT32)OBJECTS_PER_LIST );
+
+		ObjectList* objectList = clump.CreateObjectList( StaticWalkItem::MetaClass(), numListObjects );
+		chkRET_X_IF_NIL(objectList, ERR_OUT_OF_MEMORY);
+
+		for( UINT32 i = 0; i < numListObjects; i++ )
+		{
+			StaticWalkItem & item = *static_cast< StaticWalkItem* >( objectList->Allocate() );
+			const UINT32 value = firstObject + i;
+			item.i0 = item.i1 = item.i2 = item.i3 = item.i4 = value;
+			item.f0 = item.f1 = item.f2 = item.f3 = item.f4 = (float) value;
+		}
+	}
+
+	// warm up the caches and the class plans
+	UINT32 numVisited = 0;
+	UINT64 checksum = 0;
+	TimeStaticWalk( clump, numVisited, checksum );
+	TimeVirtualWalk( clump, numVisited, checksum );
+
+	UINT32 numVisitedVirtual = 0;
+	UINT64 checksumVirtual = 0;
+	_result.microsecondsStatic = TimeStaticWalk( clump, numVisited, checksum );
+	_result.microsecondsVirtual = TimeVirtualWalk( clump, numVisitedVirtual, checksumVirtual );
+	_result.numObjects = _numObjects;
+	_result.numFields = numVisited;
+	mxASSERT(numVisited == numVisitedVirtual);
+	mxASSERT(checksum == checksumVirtual);
+
+	DBGOUT("ObjectList walk: %u objects, %u fields: %llu us with TWalker, %llu us with Walker2\n",
+		_result.numObjects, _result.numFields, _result.microsecondsStatic, _result.microsecondsVirtual);
+
+	return ALL_OK;
+}
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,26 @@
+/*
+=============================================================================
+	File:	StaticWalkerBenchmark.h
+	Desc:	Compares TWalker (inlined callbacks) with Walker2 (virtual calls)
+			on traversal of objects stored in ObjectLists.
+=============================================================================
+*/
+#pragma once
+
+#include <Base/Object/Reflection.h>
+
+struct StaticWalkerBenchmarkResult
+{
+	UINT32	numObjects;			// the number of objects visited in each run
+	UINT32	numFields;			// the number of fields visited in each run
+	UINT64	microsecondsStatic;	// Reflection::StaticWalk()
+	UINT64	microsecondsVirtual;// Reflection::Walker2::Visit()
+};
+
+// fills a clump with '_numObjects' objects (ten integer and float fields each)
+// and walks all object lists with the same visitor twice: through TWalker and through Walker2.
+ERet RunStaticWalkerBenchmark( StaticWalkerBenchmarkResult &_result, UINT32 _numObjects = 1000*1000 );
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
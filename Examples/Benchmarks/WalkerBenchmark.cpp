@@ -0,0 +1,143 @@
+/*
+=============================================================================
+	File:	WalkerBenchmark.cpp
+	Desc:	Measures the cost of per-field context tracking in Walker2.
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <Base/Object/Reflection.h>
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/IterativeWalker.h>
+#include "WalkerBenchmark.h"
+
+// ten fields per object
+struct BenchmarkItem : CStruct
+{
+	UINT32	i0, i1, i2, i3, i4;
+	float	f0, f1, f2, f3, f4;
+public:
+	mxDECLARE_CLASS(BenchmarkItem, CStruct);
+	mxDECLARE_REFLECTION;
+};
+mxDEFINE_CLASS(BenchmarkItem);
+mxBEGIN_REFLECTION(BenchmarkItem)
+	mxMEMBER_FIELD( i0 ),
+	mxMEMBER_FIELD( i1 ),
+	mxMEMBER_FIELD( i2 ),
+	mxMEMBER_FIELD( i3 ),
+	mxMEMBER_FIELD( i4 ),
+	mxMEMBER_FIELD( f0 ),
+	mxMEMBER_FIELD( f1 ),
+	mxMEMBER_FIELD( f2 ),
+	mxMEMBER_FIELD( f3 ),
+	mxMEMBER_FIELD( f4 ),
+mxEND_REFLECTION;
+
+// Walker2 asserts on arrays larger than 4 MiB in debug builds,
+// so the items are split into several arrays
+enum { ITEMS_PER_CHUNK = 64*1024 };	// 2.5 MiB
+
+struct BenchmarkChunk : CStruct
+{
+	TArray< BenchmarkItem >	items;
+public:
+	mxDECLARE_CLASS(BenchmarkChunk, CStruct);
+	mxDECLARE_REFLECTION;
+};
+mxDEFINE_CLASS(BenchmarkChunk);
+mxBEGIN_REFLECTION(BenchmarkChunk)
+	mxMEMBER_FIELD( items ),
+mxEND_REFLECTION;
+
+struct BenchmarkData : CStruct
+{
+	TArray< BenchmarkChunk >	chunks;
+public:
+	mxDECLARE_CLASS(BenchmarkData, CStruct);
+	mxDECLARE_REFLECTION;
+};
+mxDEFINE_CLASS(BenchmarkData);
+mxBEGIN_REFLECTION(BenchmarkData)
+	mxMEMBER_FIELD( chunks ),
+mxEND_REFLECTION;
+
+// a cheap visitor: the walker's overhead dominates
+class FieldCounter : public Reflection::AVisitor2
+{
+public:
+	UINT32	m_numFields;
+	UINT64	m_checksum;
+public:
+	FieldCounter( UINT32 _flags )
+		: AVisitor2( Reflection::TypeHas_Everything, _flags )
+		, m_numFields( 0 ), m_checksum( 0 )
+	{}
+	virtual bool Visit_Field( void * _memory, const mxField& _field, const Context& _context ) override
+	{
+		m_numFields++;
+		return true;
+	}
+	virtual void Visit_POD( void * _memory, const mxType& _type, const Context& _context ) override
+	{
+		m_checksum += *static_cast< const UINT32* >( _memory );
+	}
+};
+
+static UINT64 TimeWalk( BenchmarkData & _data, UINT32 _flags, UINT32 &_numFields )
+{
+	FieldCounter	counter( _flags );
+	const UINT64 startTime = Reflection::GetTimeMicroseconds();
+	Reflection::Walker2::Visit( &_data, BenchmarkData::MetaClass(), &counter );
+	const UINT64 elapsed = Reflection::GetTimeMicroseconds() - startTime;
+	_numFields = counter.m_numFields;
+	return elapsed;
+}
+
+ERet RunWalkerBenchmark( WalkerBenchmarkResult &_result, UINT32 _numFields )
+{
+	const UINT32 numItems = _numFields / 10;
+	chkRET_X_IF_NOT(numItems > 0, ERR_INVALID_PARAMETER);
+
+	const UINT32 numChunks = (numItems + ITEMS_PER_CHUNK - 1) / ITEMS_PER_CHUNK;
+
+	BenchmarkData	data;
+	mxDO(data.chunks.SetNum( numChunks ));
+	for( UINT32 chunkIndex = 0; chunkIndex < numChunks; chunkIndex++ )
+	{
+		const UINT32 firstItem = chunkIndex * ITEMS_PER_CHUNK;
+		const UINT32 numChunkItems = smallest( numItems - firstItem, (UINT32)ITEMS_PER_CHUNK );
+
+		BenchmarkChunk & chunk = data.chunks[ chunkIndex ];
+		mxDO(chunk.items.SetNum( numChunkItems ));
+		for( UINT32 i = 0; i < numChunkItems; i++ )
+		{
+			BenchmarkItem & item = chunk.items[i];
+			const UINT32 value = firstItem + i;
+			item.i0 = item.i1 = item.i2 = item.i3 = item.i4 = value;
+			item.f0 = item.f1 = item.f2 = item.f3 = item.f4 = (float) value;
+		}
+	}
+
+	// warm up the caches and the class plans
+	UINT32 numVisited = 0;
+	TimeWalk( data, 0, numVisited );
+
+	UINT32 numVisitedTracked = 0;
+	_result.microsecondsLazy = TimeWalk( data, 0, numVisited );
+	_result.microsecondsTracked = TimeWalk( data, Reflection::Visitor_TrackPath, numVisitedTracked );
+	// the array fields are visited as well
+	_result.numFields = numVisited - 1 - numChunks;
+	mxASSERT(numVisited == numVisitedTracked);
+
+	DBGOUT("Walker2: %u fields: %llu us without path tracking, %llu us with path tracking\n",
+		_result.numFields, _result.microsecondsLazy, _result.microsecondsTracked);
+
+	return ALL_OK;
+}
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
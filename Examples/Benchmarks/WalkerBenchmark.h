@@ -0,0 +1,24 @@
+/*
+=============================================================================
+	File:	WalkerBenchmark.h
+	Desc:	Measures the cost of per-field context tracking in Walker2.
+=============================================================================
+*/
+#pragma once
+
+#include <Base/Object/Reflection.h>
+
+struct WalkerBenchmarkResult
+{
+	UINT32	numFields;			// the number of fields visited in each run
+	UINT64	microsecondsLazy;	// without Visitor_TrackPath
+	UINT64	microsecondsTracked;// with Visitor_TrackPath
+};
+
+// walks arrays of objects with '_numFields' integer and float fields in total
+// with the same visitor twice: with and without per-field contexts.
+ERet RunWalkerBenchmark( WalkerBenchmarkResult &_result, UINT32 _numFields = 10*1000*1000 );
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,300 @@
+/*
+=============================================================================
+	File:	ImagePack.cpp
+	Desc:	Packed archive of many independently loadable memory images
+			with a sorted directory for random access.
+=============================================================================
+*/
+#include <Core/Core_PCH.h>
+#pragma hdrstop
+#include <algorithm>
+#include <Base/Util/FourCC.h>
+#include <Core/ImagePack.h>
+
+namespace Serialization
+{
+	static const UINT32 PACK_FOURCC = MCHAR4('P','A','C','K');
+	static const UINT32 PACK_VERSION = 1;
+
+	// directory entries are sorted by name hash, then by type id
+	static inline bool PackEntryLess( const PackEntry& a, const PackEntry& b )
+	{
+		return (a.nameHash < b.nameHash) || (a.nameHash == b.nameHash && a.classId < b.classId);
+	}
+
+	/*
+	-----------------------------------------------------------------------------
+		ImagePackWriter
+	-----------------------------------------------------------------------------
+	*/
+	ImagePackWriter::ImagePackWriter( AStreamWriter &_stream )
+		: m_stream( _stream )
+	{
+		m_bytesWritten = 0;
+	}
+
+	ImagePackWriter::~ImagePackWriter()
+	{
+	}
+
+	ERet ImagePackWriter::Begin()
+	{
+		chkRET_X_IF_NOT(m_bytesWritten == 0, ERR_INVALID_PARAMETER);
+
+		PackHeader	header;
+		mxZERO_OUT(header);
+		header.fourCC = PACK_FOURCC;
+		header.version = PACK_VERSION;
+		header.session = PtSessionInfo::CURRENT;
+
+		mxDO(m_stream.Write( &header, sizeof(header) ));
+		m_bytesWritten = sizeof(header);
+		return ALL_OK;
+	}
+
+	ERet ImagePackWriter::AddImage( const char* _name, const void* _o, const mxClass& _type )
+	{
+		mxASSERT_PTR(_name);
+		chkRET_X_IF_NOT(m_bytesWritten >= sizeof(PackHeader), ERR_INVALID_PARAMETER);
+
+		mxDO(this->AlignOutput());
+
+		CountingStreamWriter	counter( m_stream );
+		mxDO(SaveImage( _o, _type, counter ));
+		mxDO(counter.m_status);
+		chkRET_X_IF_NOT((UINT64)m_bytesWritten + counter.m_bytesWritten <= (UINT32)~0, ERR_FAILED_TO_WRITE_FILE);
+
+		PackEntry &newEntry = m_entries.Add();
+		mxZERO_OUT(newEntry);
+		newEntry.nameHash = GetDynamicStringHash( _name );
+		newEntry.classId = _type.GetTypeID();
+		newEntry.offset = m_bytesWritten;
+		newEntry.size = (UINT32) counter.m_bytesWritten;
+		strncpy( newEntry.name, _name, sizeof(newEntry.name) - 1 );
+
+		m_bytesWritten += (UINT32) counter.m_bytesWritten;
+		return ALL_OK;
+	}
+
+	ERet ImagePackWriter::Finish()
+	{
+		chkRET_X_IF_NOT(m_bytesWritten >= sizeof(PackHeader), ERR_INVALID_PARAMETER);
+
+		std::sort( m_entries.ToPtr(), m_entries.ToPtr() + m_entries.Num(), &PackEntryLess );
+
+		// different names may share a hash, but the (name, type) pairs must be unique
+		for( UINT32 i = 1; i < m_entries.Num(); i++ )
+		{
+			const PackEntry& curr = m_entries[ i ];
+			for( UINT32 k = i; k > 0 && !PackEntryLess( m_entries[ k-1 ], curr ); k-- )
+			{
+				const PackEntry& prev = m_entries[ k-1 ];
+				if( strncmp( prev.name, curr.name, sizeof(curr.name) ) == 0 ) {
+					ptWARN("Duplicate pack entries: '%s'\n", curr.name);
+					return ERR_INVALID_PARAMETER;
+				}
+			}
+		}
+
+		mxDO(this->AlignOutput());
+
+		PackFooter	footer;
+		footer.directoryOffset = m_bytesWritten;
+		footer.numEntries = m_entries.Num();
+		footer.fourCC = PACK_FOURCC;
+		footer._unused = 0;
+
+		if( m_entries.Num() ) {
+			mxDO(m_stream.Write( m_entries.ToPtr(), m_entries.Num() * sizeof(PackEntry) ));
+			m_bytesWritten += m_entries.Num() * sizeof(PackEntry);
+		}
+		mxDO(m_stream.Write( &footer, sizeof(footer) ));
+		m_bytesWritten += sizeof(footer);
+
+		return ALL_OK;
+	}
+
+	ERet ImagePackWriter::AlignOutput()
+	{
+		static const BYTE zeroes[ PACK_ALIGNMENT ] = { 0 };
+		const UINT32 alignedOffset = AlignUp( m_bytesWritten, PACK_ALIGNMENT );
+		const UINT32 sizeOfPadding = alignedOffset - m_bytesWritten;
+		if( sizeOfPadding > 0 ) {
+			mxDO(m_stream.Write( zeroes, sizeOfPadding ));
+			m_bytesWritten = alignedOffset;
+		}
+		return ALL_OK;
+	}
+
+	/*
+	-----------------------------------------------------------------------------
+		ImagePack
+	-----------------------------------------------------------------------------
+	*/
+	ImagePack::ImagePack()
+	{
+		m_entries = NULL;
+		m_numEntries = 0;
+		m_mode = LoadMode_Trusted;
+	}
+
+	ImagePack::~ImagePack()
+	{
+		this->Close();
+	}
+
+	ERet ImagePack::Open( const char* _fileName, ELoadMode _mode )
+	{
+		this->Close();
+
+		// images are patched where they lie, the changes are never written back
+		mxDO(m_file.Open( _fileName, FileMap_CopyOnWrite ));
+
+		const BYTE* fileData = static_cast< const BYTE* >( m_file.GetData() );
+		const UINT32 fileSize = m_file.GetSize();
+
+		if( fileSize < sizeof(PackHeader) + sizeof(PackFooter) ) {
+			this->Close();
+			return ERR_FAILED_TO_PARSE_DATA;
+		}
+
+		const PackHeader& header = *reinterpret_cast< const PackHeader* >( fileData );
+		if( header.fourCC != PACK_FOURCC || header.version != PACK_VERSION ) {
+			ptWARN("'%s' is not a valid image pack\n", _fileName);
+			this->Close();
+			return ERR_INCOMPATIBLE_VERSION;
+		}
+		if( !PtSessionInfo::AreCompatible( PtSessionInfo::CURRENT, header.session ) ) {
+			ptWARN("Image pack '%s' was built for another platform\n", _fileName);
+			this->Close();
+			return ERR_INCOMPATIBLE_VERSION;
+		}
+
+		const PackFooter& footer = *reinterpret_cast< const PackFooter* >( fileData + fileSize - sizeof(PackFooter) );
+		const UINT64 directoryEnd = (UINT64)footer.directoryOffset + (UINT64)footer.numEntries * sizeof(PackEntry);
+		if( footer.fourCC != PACK_FOURCC
+			|| !IsAlignedBy( footer.directoryOffset, PACK_ALIGNMENT )
+			|| directoryEnd > fileSize - sizeof(PackFooter) )
+		{
+			ptWARN("Image pack '%s' has a corrupted directory\n", _fileName);
+			this->Close();
+			return ERR_FAILED_TO_PARSE_DATA;
+		}
+
+		m_entries = reinterpret_cast< const PackEntry* >( fileData + footer.directoryOffset );
+		m_numEntries = footer.numEntries;
+		m_mode = _mode;
+
+		if( _mode == LoadMode_Validated )
+		{
+			for( UINT32 i = 0; i < m_numEntries; i++ )
+			{
+				const PackEntry& entry = m_entries[i];
+				if( (UINT64)entry.offset + entry.size > footer.directoryOffset
+					|| entry.offset < sizeof(PackHeader)
+					|| !IsAlignedBy( entry.offset, PACK_ALIGNMENT )
+					|| (i > 0 && PackEntryLess( entry, m_entries[i-1] )) )
+				{
+					ptWARN("Image pack '%s': bad entry %u\n", _fileName, i);
+					this->Close();
+					return ERR_FAILED_TO_PARSE_DATA;
+				}
+			}
+		}
+
+		mxDO(m_loadedObjects.SetNum( m_numEntries ));
+		for( UINT32 i = 0; i < m_numEntries; i++ ) {
+			m_loadedObjects[i] = NULL;
+		}
+
+		return ALL_OK;
+	}
+
+	void ImagePack::Close()
+	{
+		m_file.Close();
+		m_entries = NULL;
+		m_numEntries = 0;
+		m_loadedObjects.Empty();
+	}
+
+	const PackEntry& ImagePack::GetEntry( UINT32 _index ) const
+	{
+		mxASSERT(_index < m_numEntries);
+		return m_entries[ _index ];
+	}
+
+	int ImagePack::FindEntry( UINT32 _nameHash, TypeID _classId ) const
+	{
+		// binary search in the sorted directory
+		UINT32 lo = 0;
+		UINT32 hi = m_numEntries;
+		while( lo < hi )
+		{
+			const UINT32 mid = lo + (hi - lo) / 2;
+			const PackEntry& entry = m_entries[ mid ];
+			if( entry.nameHash < _nameHash || (entry.nameHash == _nameHash && entry.classId < _classId) ) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		if( lo < m_numEntries && m_entries[lo].nameHash == _nameHash && m_entries[lo].classId == _classId ) {
+			return lo;
+		}
+		return -1;
+	}
+
+	ERet ImagePack::LoadEntry( UINT32 _index, const mxClass& _type, void *&_o )
+	{
+		chkRET_X_IF_NOT(_index < m_numEntries, ERR_INVALID_PARAMETER);
+		const PackEntry& entry = m_entries[ _index ];
+		chkRET_X_IF_NOT(entry.classId == _type.GetTypeID(), ERR_OBJECT_OF_WRONG_TYPE);
+
+		// the relocations must be applied only once
+		if( m_loadedObjects[ _index ] != NULL ) {
+			_o = m_loadedObjects[ _index ];
+			return ALL_OK;
+		}
+
+		chkRET_X_IF_NOT(entry.size >= sizeof(ImageHeader), ERR_FAILED_TO_PARSE_DATA);
+		void* imageData = mxAddByteOffset( m_file.GetData(), entry.offset );
+
+		// relocate the image inside the (copy-on-write) mapping
+		void* o = NULL;
+		mxDO(LoadInPlace( _type, imageData, entry.size, o, m_mode ));
+
+		_o = o;
+		m_loadedObjects[ _index ] = o;
+		return ALL_OK;
+	}
+
+	ERet ImagePack::Load( const char* _name, const mxClass& _type, void *&_o )
+	{
+		const UINT32 nameHash = GetDynamicStringHash( _name );
+		const TypeID classId = _type.GetTypeID();
+		int index = this->FindEntry( nameHash, classId );
+
+		// the directory is keyed by name hashes, look for the requested image
+		// among the neighbouring entries with the same hash
+		// (names longer than the stored ones are compared by their prefixes)
+		while( index >= 0 && strncmp( m_entries[ index ].name, _name, sizeof(m_entries[ index ].name) - 1 ) != 0 )
+		{
+			const UINT32 next = index + 1;
+			const bool sameKey = next < m_numEntries
+				&& m_entries[ next ].nameHash == nameHash
+				&& m_entries[ next ].classId == classId;
+			index = sameKey ? next : -1;
+		}
+		if( index < 0 ) {
+			ptWARN("Image '%s' of type '%s' not found in pack\n", _name, _type.GetTypeName());
+			return ERR_INVALID_PARAMETER;
+		}
+		return this->LoadEntry( index, _type, _o );
+	}
+
+}//namespace Serialization
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
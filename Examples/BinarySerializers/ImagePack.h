@@ -0,0 +1,140 @@
+/*
+=============================================================================
+	File:	ImagePack.h
+	Desc:	Packed archive of many independently loadable memory images
+			with a sorted directory for random access.
+=============================================================================
+*/
+#pragma once
+
+#include <Core/Serialization.h>
+#include <Core/MappedFile.h>
+
+namespace Serialization
+{
+	//
+	// File layout:
+	//	PackHeader
+	//	image #0	(ImageHeader + payload + relocation tables, see SaveImage())
+	//	...
+	//	image #N-1
+	//	PackEntry[N]	(sorted by name hash and type id)
+	//	PackFooter
+	// The header, all images and the directory start at PACK_ALIGNMENT-aligned offsets.
+	//
+
+	enum { PACK_ALIGNMENT = 64 };
+
+	struct PackHeader
+	{
+		UINT32			fourCC;		// 4 PACK_FOURCC
+		UINT32			version;	// 4 PACK_VERSION
+		PtSessionInfo	session;	// 8 platform/engine info
+		BYTE			_pad[48];	// aligns images to 64 bytes
+	};
+	ASSERT_SIZEOF(PackHeader, PACK_ALIGNMENT);
+
+	// the directory entry describing a single image
+	struct PackEntry
+	{
+		UINT32	nameHash;	// 4 GetDynamicStringHash( name )
+		TypeID	classId;	// 4 type of stored object
+		UINT32	offset;		// 4 offset of the ImageHeader from the start of the file
+		UINT32	size;		// 4 size of the image, including the header and relocation tables
+		char	name[48];	// 48 (truncated) name, for resolving hash collisions and debugging
+	};
+	ASSERT_SIZEOF(PackEntry, PACK_ALIGNMENT);
+
+	struct PackFooter
+	{
+		UINT32	directoryOffset;	// 4 offset of the first PackEntry
+		UINT32	numEntries;			// 4 number of stored images
+		UINT32	fourCC;				// 4 PACK_FOURCC
+		UINT32	_unused;			// 4
+	};
+	ASSERT_SIZEOF(PackFooter, 16);
+
+	/*
+	-----------------------------------------------------------------------------
+		ImagePackWriter
+		writes images sequentially, the directory is appended in Finish()
+	-----------------------------------------------------------------------------
+	*/
+	class ImagePackWriter
+	{
+	public:
+		ImagePackWriter( AStreamWriter &_stream );
+		~ImagePackWriter();
+
+		ERet Begin();
+
+		// the (name, type) pair must be unique within the pack;
+		// different names may have the same hash
+		ERet AddImage( const char* _name, const void* _o, const mxClass& _type );
+
+		template< typename CLASS >
+		ERet AddImage( const char* _name, const CLASS& _o ) {
+			return this->AddImage( _name, &_o, CLASS::MetaClass() );
+		}
+
+		// sorts and writes the directory
+		ERet Finish();
+
+	private:
+		ERet AlignOutput();
+
+	private:
+		AStreamWriter &		m_stream;
+		UINT32				m_bytesWritten;
+		TArray< PackEntry >	m_entries;
+	};
+
+	/*
+	-----------------------------------------------------------------------------
+		ImagePack
+		maps the pack file into memory (copy-on-write) and fixes up
+		individual images where they lie (only the loaded images are read from the file);
+		finding an image takes O(log n).
+	-----------------------------------------------------------------------------
+	*/
+	class ImagePack
+	{
+	public:
+		ImagePack();
+		~ImagePack();
+
+		ERet Open( const char* _fileName, ELoadMode _mode = LoadMode_Trusted );
+		void Close();
+
+		UINT32 NumEntries() const { return m_numEntries; }
+		const PackEntry& GetEntry( UINT32 _index ) const;
+
+		// returns the first entry with the given hash and type or -1 if not found
+		int FindEntry( UINT32 _nameHash, TypeID _classId ) const;
+
+		// loads and fixes up the image (only once) and returns the object;
+		// the object stays valid until the pack is closed.
+		ERet LoadEntry( UINT32 _index, const mxClass& _type, void *&_o );
+		ERet Load( const char* _name, const mxClass& _type, void *&_o );
+
+		template< typename CLASS >
+		ERet Load( const char* _name, CLASS *&_o ) {
+			void* voidPtr = NULL;
+			mxDO(this->Load( _name, CLASS::MetaClass(), voidPtr ));
+			_o = static_cast< CLASS* >( voidPtr );
+			return ALL_OK;
+		}
+
+	private:
+		MappedFile			m_file;
+		const PackEntry *	m_entries;
+		UINT32				m_numEntries;
+		ELoadMode			m_mode;
+		TArray< void* >		m_loadedObjects;	// loaded objects (pointing into the mapping), indexed by entries
+	};
+
+}//namespace Serialization
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
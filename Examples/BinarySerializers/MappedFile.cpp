@@ -0,0 +1,162 @@
+/*
+=============================================================================
+	File:	MappedFile.cpp
+	Desc:	Read-only and copy-on-write memory-mapped files.
+=============================================================================
+*/
+#include <Core/Core_PCH.h>
+#pragma hdrstop
+#include <Core/MappedFile.h>
+
+#if mxPLATFORM != mxPLATFORM_WINDOWS
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	m_data = NULL;
+	m_size = 0;
+#if mxPLATFORM == mxPLATFORM_WINDOWS
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = NULL;
+#else
+	m_fileDescriptor = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	this->Close();
+}
+
+static UINT32 GetPageSize()
+{
+#if mxPLATFORM == mxPLATFORM_WINDOWS
+	SYSTEM_INFO systemInfo;
+	::GetSystemInfo( &systemInfo );
+	return systemInfo.dwPageSize;
+#else
+	return (UINT32) ::sysconf( _SC_PAGESIZE );
+#endif
+}
+
+bool MappedFile::IsNullTerminated() const
+{
+	return m_data != NULL && (m_size % GetPageSize()) != 0;
+}
+
+#if mxPLATFORM == mxPLATFORM_WINDOWS
+
+ERet MappedFile::Open( const char* _fileName, EFileMapMode _mode, EFileAccessPattern _access )
+{
+	this->Close();
+
+	const DWORD accessFlags = (_access == FileAccess_Sequential) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+	m_fileHandle = ::CreateFileA( _fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, accessFlags, NULL );
+	if( m_fileHandle == INVALID_HANDLE_VALUE ) {
+		ptWARN("Failed to open file '%s' for mapping\n", _fileName);
+		return ERR_FAILED_TO_OPEN_FILE;
+	}
+
+	LARGE_INTEGER fileSize;
+	if( !::GetFileSizeEx( m_fileHandle, &fileSize ) || fileSize.QuadPart == 0 || fileSize.HighPart != 0 ) {
+		ptWARN("Cannot map file '%s': bad file size\n", _fileName);
+		this->Close();
+		return ERR_FAILED_TO_OPEN_FILE;
+	}
+
+	const DWORD protection = (_mode == FileMap_CopyOnWrite) ? PAGE_WRITECOPY : PAGE_READONLY;
+	m_mappingHandle = ::CreateFileMappingA( m_fileHandle, NULL, protection, 0, 0, NULL );
+	if( m_mappingHandle == NULL ) {
+		ptWARN("CreateFileMapping() failed for '%s'\n", _fileName);
+		this->Close();
+		return ERR_FAILED_TO_OPEN_FILE;
+	}
+
+	const DWORD access = (_mode == FileMap_CopyOnWrite) ? FILE_MAP_COPY : FILE_MAP_READ;
+	m_data = ::MapViewOfFile( m_mappingHandle, access, 0, 0, 0 );
+	if( m_data == NULL ) {
+		ptWARN("MapViewOfFile() failed for '%s'\n", _fileName);
+		this->Close();
+		return ERR_FAILED_TO_OPEN_FILE;
+	}
+
+	m_size = fileSize.LowPart;
+	return ALL_OK;
+}
+
+void MappedFile::Close()
+{
+	if( m_data != NULL ) {
+		::UnmapViewOfFile( m_data );
+		m_data = NULL;
+	}
+	if( m_mappingHandle != NULL ) {
+		::CloseHandle( m_mappingHandle );
+		m_mappingHandle = NULL;
+	}
+	if( m_fileHandle != INVALID_HANDLE_VALUE ) {
+		::CloseHandle( m_fileHandle );
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+	m_size = 0;
+}
+
+#else
+
+ERet MappedFile::Open( const char* _fileName, EFileMapMode _mode, EFileAccessPattern _access )
+{
+	this->Close();
+
+	m_fileDescriptor = ::open( _fileName, O_RDONLY );
+	if( m_fileDescriptor == -1 ) {
+		ptWARN("Failed to open file '%s' for mapping\n", _fileName);
+		return ERR_FAILED_TO_OPEN_FILE;
+	}
+
+	struct stat fileInfo;
+	if( ::fstat( m_fileDescriptor, &fileInfo ) != 0 || fileInfo.st_size == 0 || (UINT64)fileInfo.st_size > UINT32(~0) ) {
+		ptWARN("Cannot map file '%s': bad file size\n", _fileName);
+		this->Close();
+		return ERR_FAILED_TO_OPEN_FILE;
+	}
+
+	const int protection = (_mode == FileMap_CopyOnWrite) ? (PROT_READ|PROT_WRITE) : PROT_READ;
+	void* mappedData = ::mmap( NULL, fileInfo.st_size, protection, MAP_PRIVATE, m_fileDescriptor, 0 );
+	if( mappedData == MAP_FAILED ) {
+		ptWARN("mmap() failed for '%s'\n", _fileName);
+		this->Close();
+		return ERR_FAILED_TO_OPEN_FILE;
+	}
+
+	// more aggressive read-ahead, pages behind the reader can be dropped
+	if( _access == FileAccess_Sequential ) {
+		::madvise( mappedData, fileInfo.st_size, MADV_SEQUENTIAL );
+	}
+
+	m_data = mappedData;
+	m_size = (UINT32) fileInfo.st_size;
+	return ALL_OK;
+}
+
+void MappedFile::Close()
+{
+	if( m_data != NULL ) {
+		::munmap( m_data, m_size );
+		m_data = NULL;
+	}
+	if( m_fileDescriptor != -1 ) {
+		::close( m_fileDescriptor );
+		m_fileDescriptor = -1;
+	}
+	m_size = 0;
+}
+
+#endif
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,73 @@
+/*
+=============================================================================
+	File:	MappedFile.h
+	Desc:	Read-only and copy-on-write memory-mapped files.
+=============================================================================
+*/
+#pragma once
+
+enum EFileMapMode
+{
+	// the mapped memory cannot be written to
+	FileMap_ReadOnly,
+
+	// the mapped memory can be modified (e.g. patched when loading in-place),
+	// but changes are private to the process and never written back to the file
+	FileMap_CopyOnWrite,
+};
+
+// hints for the OS (read-ahead and page eviction)
+enum EFileAccessPattern
+{
+	// pages are touched in no particular order (e.g. when looking up chunks)
+	FileAccess_Random,
+
+	// the file is read once from start to end (e.g. by text parsers)
+	FileAccess_Sequential,
+};
+
+/*
+-----------------------------------------------------------------------------
+	MappedFile
+	maps the whole file into the address space of the calling process
+-----------------------------------------------------------------------------
+*/
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	ERet Open( const char* _fileName, EFileMapMode _mode = FileMap_ReadOnly, EFileAccessPattern _access = FileAccess_Random );
+	void Close();
+
+	bool IsOpen() const { return m_data != NULL; }
+
+	// returns the start of the mapped view (aligned to the page size)
+	void* GetData() const { return m_data; }
+
+	// returns the size of the file
+	UINT32 GetSize() const { return m_size; }
+
+	// the rest of the last page is filled with zeros, so the mapped data
+	// is followed by a null unless the file size is a multiple of the page size
+	bool IsNullTerminated() const;
+
+private:
+	void *	m_data;
+	UINT32	m_size;
+#if mxPLATFORM == mxPLATFORM_WINDOWS
+	HANDLE	m_fileHandle;
+	HANDLE	m_mappingHandle;
+#else
+	int		m_fileDescriptor;
+#endif
+
+private:
+	NO_COPY_CONSTRUCTOR( MappedFile );
+	NO_ASSIGNMENT( MappedFile );
+};
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -17,9 +17,20 @@
 #pragma hdrstop
 #include <Base/Util/FourCC.h>
 #include <Core/Asset.h>
+#include <Base/Object/TWalker.h>
 #include <Core/Serialization.h>
 #include <Core/Util/ScopedTimer.h>
 
+#include <algorithm>
+
+// CRC32C instruction (SSE4.2) is used for computing payload checksums
+#if defined(__SSE4_2__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+	#define MX_USE_SSE42_CRC32	(1)
+	#include <nmmintrin.h>
+#else
+	#define MX_USE_SSE42_CRC32	(0)
+#endif
+
 #if 1
 	#define DBG_MSG(...)
 	#define DBG_MSG2(ctx,...)
@@ -40,10 +51,139 @@ namespace Serialization
 	static const UINT32 PADDING_VALUE = 0;
 #endif
 
+	// the version must be increased whenever the layout of images or relocation tables changes
+	static const UINT32 IMAGE_FOURCC = MCHAR4('I','M','A','G');
+	static const UINT32 IMAGE_VERSION = 2;	// 2: payload checksum in relocation tables
+
 	static const UINT32 NULL_POINTER_OFFSET = ~0UL;
 
 	enum { OBJECT_BLOB_ALIGNMENT = 16 };
 
+	//
+	// CRC32C (Castagnoli) checksum, used for validating untrusted memory images.
+	// NOTE: the running value is kept inverted, start with ~0 and invert the result.
+	//
+	static UINT32 CRC32C_Update( UINT32 _crc, const void* _data, size_t _size )
+	{
+		const BYTE* bytes = static_cast< const BYTE* >( _data );
+	#if MX_USE_SSE42_CRC32
+		#if defined(_M_X64) || defined(__x86_64__)
+		UINT64 crc64 = _crc;
+		while( _size >= sizeof(UINT64) )
+		{
+			UINT64 value;
+			memcpy( &value, bytes, sizeof(value) );
+			crc64 = _mm_crc32_u64( crc64, value );
+			bytes += sizeof(UINT64);
+			_size -= sizeof(UINT64);
+		}
+		_crc = (UINT32) crc64;
+		#endif
+		while( _size >= sizeof(UINT32) )
+		{
+			UINT32 value;
+			memcpy( &value, bytes, sizeof(value) );
+			_crc = _mm_crc32_u32( _crc, value );
+			bytes += sizeof(UINT32);
+			_size -= sizeof(UINT32);
+		}
+		while( _size > 0 )
+		{
+			_crc = _mm_crc32_u8( _crc, *bytes++ );
+			_size--;
+		}
+	#else
+		// slow bitwise fallback (reflected polynomial 0x1EDC6F41)
+		while( _size > 0 )
+		{
+			_crc ^= *bytes++;
+			for( int bit = 0; bit < 8; bit++ ) {
+				_crc = (_crc >> 1) ^ (0x82F63B78UL & (0 - (_crc & 1)));
+			}
+			_size--;
+		}
+	#endif
+		return _crc;
+	}
+	static inline UINT32 CRC32C( const void* _data, size_t _size )
+	{
+		return ~CRC32C_Update( ~0UL, _data, _size );
+	}
+
+	// fast 64-bit content hash (two interleaved CRC32C lanes),
+	// used for detecting modified memory blocks; not suitable for validation!
+	static UINT64 ContentHash64( const void* _data, size_t _size )
+	{
+		const BYTE* bytes = static_cast< const BYTE* >( _data );
+		UINT32 lane0 = ~0UL;
+		UINT32 lane1 = 0x9E3779B9UL;
+	#if MX_USE_SSE42_CRC32 && (defined(_M_X64) || defined(__x86_64__))
+		UINT64 crc0 = lane0;
+		UINT64 crc1 = lane1;
+		while( _size >= sizeof(UINT64) * 2 )
+		{
+			UINT64 values[2];
+			memcpy( values, bytes, sizeof(values) );
+			crc0 = _mm_crc32_u64( crc0, values[0] );
+			crc1 = _mm_crc32_u64( crc1, values[1] );
+			bytes += sizeof(values);
+			_size -= sizeof(values);
+		}
+		lane0 = (UINT32) crc0;
+		lane1 = (UINT32) crc1;
+	#else
+		while( _size >= sizeof(UINT64) * 2 )
+		{
+			lane0 = CRC32C_Update( lane0, bytes, sizeof(UINT64) );
+			lane1 = CRC32C_Update( lane1, bytes + sizeof(UINT64), sizeof(UINT64) );
+			bytes += sizeof(UINT64) * 2;
+			_size -= sizeof(UINT64) * 2;
+		}
+	#endif
+		lane0 = CRC32C_Update( lane0, bytes, _size );
+		return ((UINT64)lane0 << 32) | lane1;
+	}
+
+	// fills the memory with the padding pattern
+	static void FillPadding( void* _dest, UINT32 _size )
+	{
+		BYTE* bytes = static_cast< BYTE* >( _dest );
+		for( UINT32 i = 0; i < _size; i++ ) {
+			bytes[i] = ((const BYTE*)&PADDING_VALUE)[ i % sizeof(PADDING_VALUE) ];
+		}
+	}
+
+	// updates the running checksum of the payload with zero bytes
+	// (used for gaps which are not stored in the file, so that the checksum
+	// doesn't depend on PADDING_VALUE of the build which wrote or loads the image)
+	static UINT32 CRC32C_UpdateZeros( UINT32 _crc, UINT32 _size )
+	{
+		BYTE	padding[ OBJECT_BLOB_ALIGNMENT ];
+		mxZERO_OUT( padding );
+		while( _size > 0 )
+		{
+			const UINT32 bytesToHash = smallest( _size, (UINT32)sizeof(padding) );
+			_crc = CRC32C_Update( _crc, padding, bytesToHash );
+			_size -= bytesToHash;
+		}
+		return _crc;
+	}
+
+	// writes padding bytes and updates the running checksum of the payload
+	static ERet WritePadding( AStreamWriter &_stream, UINT32 _size, UINT32 &_crc )
+	{
+		BYTE	padding[ OBJECT_BLOB_ALIGNMENT ];
+		FillPadding( padding, sizeof(padding) );
+		while( _size > 0 )
+		{
+			const UINT32 bytesToWrite = smallest( _size, (UINT32)sizeof(padding) );
+			mxDO(_stream.Write( padding, bytesToWrite ));
+			_crc = CRC32C_Update( _crc, padding, bytesToWrite );
+			_size -= bytesToWrite;
+		}
+		return ALL_OK;
+	}
+
 	//
 	// Memory image serialization and in-place loading
 	// NOTE: all pointer offsets are relative to start of object data
@@ -99,7 +239,7 @@ namespace Serialization
 	}
 
 	// Gathers information necessary for memory image serialization: collects all memory blocks and pointers.
-	struct LIPInfoGatherer : public Reflection::AVisitor2
+	struct LIPInfoGatherer : public Reflection::StaticVisitorBase
 	{mxOPTIMIZE("reduce dynamic memory allocations in these arrays:")
 		TArray< SChunk > 	chunks;		// memory blocks to be serialized
 		TArray< SPointer > 	pointers;	// pointers to be patched after loading; they can only point inside the above memory blocks
@@ -175,10 +315,36 @@ namespace Serialization
 			offset = AlignUp(offset,OBJECT_BLOB_ALIGNMENT);
 			return offset;
 		}
-		UINT32 WriteChunksAndFixUpTables( AStreamWriter &_stream )
+		// computes the checksum of the payload without writing it,
+		// gaps between the blocks are hashed as zeros
+		UINT32 ComputePayloadChecksum() const
+		{
+			UINT32 payloadChecksum = ~0UL;
+			UINT32 currentOffset = 0;
+			for( UINT32 iChunk = 0; iChunk < chunks.Num(); iChunk++ )
+			{
+				const SChunk & chunk = chunks[ iChunk ];
+				payloadChecksum = CRC32C_UpdateZeros( payloadChecksum, chunk.offset - currentOffset );
+				payloadChecksum = CRC32C_Update( payloadChecksum, chunk.data, chunk.size );
+				currentOffset = chunk.offset + chunk.size;
+			}
+			payloadChecksum = CRC32C_UpdateZeros( payloadChecksum, AlignUp( currentOffset, OBJECT_BLOB_ALIGNMENT ) - currentOffset );
+			return ~payloadChecksum;
+		}
+		ERet WriteChunksAndFixUpTables( AStreamWriter &_stream )
+		{
+			UINT32 payloadChecksum;
+			UINT32 relocationTableOffset;
+			mxDO(this->WriteChunks( _stream, payloadChecksum, relocationTableOffset ));
+			mxDO(this->WriteFixUpTables( _stream, payloadChecksum ));
+			return ALL_OK;
+		}
+		// _payloadSize - the aligned size of the payload
+		ERet WriteChunks( AStreamWriter &_stream, UINT32 &_payloadChecksum, UINT32 &_payloadSize )
 		{
 			// Write all memory blocks to file.
 			UINT32 bytesWritten = 0;	//<= not including size of blob header
+			UINT32 payloadChecksum = ~0UL;
 			for( UINT32 iChunk = 0; iChunk < chunks.Num(); iChunk++ )
 			{
 				const SChunk & chunk = chunks[ iChunk ];
@@ -187,9 +353,10 @@ namespace Serialization
 				//mxASSERT2(IsAlignedBy(alignedOffset, chunk.alignment), "data must start at aligned offset");
 				const UINT32 sizeOfPadding = alignedOffset - currentOffset;
 				if( sizeOfPadding > 0 ) {
-					Write_N_bytes( _stream, PADDING_VALUE, sizeOfPadding );
+					mxDO(WritePadding( _stream, sizeOfPadding, payloadChecksum ));
 				}
-				_stream.Write( chunk.data, chunk.size );
+				mxDO(_stream.Write( chunk.data, chunk.size ));
+				payloadChecksum = CRC32C_Update( payloadChecksum, chunk.data, chunk.size );
 				bytesWritten += (chunk.size + sizeOfPadding);
 			}
 
@@ -197,50 +364,60 @@ namespace Serialization
 				const UINT32 currentOffset = bytesWritten;
 				const UINT32 alignedOffset = AlignUp( currentOffset, OBJECT_BLOB_ALIGNMENT );
 				const UINT32 sizeOfPadding = alignedOffset - currentOffset;
-				Write_N_bytes( _stream, PADDING_VALUE, sizeOfPadding );
+				mxDO(WritePadding( _stream, sizeOfPadding, payloadChecksum ));
 				bytesWritten = alignedOffset;
 			}
 
-			// Relocation data begin starts right after serialized object data.
-			const UINT32 relocationTableOffset = bytesWritten;
+			_payloadChecksum = ~payloadChecksum;
+			_payloadSize = bytesWritten;
+			return ALL_OK;
+		}
+		// Relocation data begin starts right after serialized object data.
+		ERet WriteFixUpTables( AStreamWriter &_stream, UINT32 _payloadChecksum )
+		{
+			UINT32 bytesWritten = 0;
+
+			// The checksum is only verified when loading untrusted images.
+			mxDO(_stream.Put( _payloadChecksum ));
+			bytesWritten += sizeof(_payloadChecksum);
 
 			// Append pointer patch tables.
 			const UINT32 numPointerFixups = pointers.Num();
-			_stream << numPointerFixups;
+			mxDO(_stream.Put( numPointerFixups ));
 			for( UINT32 i = 0; i < numPointerFixups; i++ )
 			{
 				const SPointer& pointer = pointers[ i ];
 				const UINT32 pointerOffset = GetFileOffset( pointer.address, chunks );
 				const UINT32 targetOffset = GetFileOffset( pointer.target, chunks );
-				_stream << pointerOffset;
-				_stream << targetOffset;
+				mxDO(_stream.Put( pointerOffset ));
+				mxDO(_stream.Put( targetOffset ));
 				DBG_MSG("WRITE: Pointer '%s': %u -> %u", pointer.name, pointerOffset, targetOffset);
 			}
 			bytesWritten += numPointerFixups * (sizeof(UINT32) * 2);
 
 			const UINT32 numTypeFixups = typeFixups.Num();
-			_stream << numTypeFixups;
+			mxDO(_stream.Put( numTypeFixups ));
 			for( UINT32 i = 0; i < numTypeFixups; i++ )
 			{
 				const STypeInfo& pointer = typeFixups[ i ];
 				const UINT32 pointerOffset = GetFileOffset( pointer.o, chunks );
 				const UINT32 typeID = pointer.o->type->GetTypeID();
-				_stream << pointerOffset;
-				_stream << typeID;
+				mxDO(_stream.Put( pointerOffset ));
+				mxDO(_stream.Put( typeID ));
 			}
 			bytesWritten += numTypeFixups * (sizeof(UINT32) * 2);
 
 			const UINT32 numAssetIdFixups = assetIdFixups.Num();
-			_stream << numAssetIdFixups;
+			mxDO(_stream.Put( numAssetIdFixups ));
 			for( UINT32 iAssetRef = 0; iAssetRef < numAssetIdFixups; iAssetRef++ )
 			{
 				const AssetID* assetID = assetIdFixups[ iAssetRef ];
 
 				const UINT32 pointerOffset = GetFileOffset( assetID, chunks );
-				_stream << pointerOffset;
+				mxDO(_stream.Put( pointerOffset ));
 				bytesWritten += sizeof(pointerOffset);
 
-				WriteAssetID( *assetID, _stream );
+				mxDO(WriteAssetID( *assetID, _stream ));
 
 				const UINT32 realLength = assetID->d.size();
 				const UINT32 alignedLength = TAlignUp< String::ALIGNMENT >( realLength );
@@ -250,18 +427,17 @@ namespace Serialization
 				}
 			}
 
-			DBG_MSG("WRITE: %u chunks, %u pointers, %u typeIDs, %u assetIDs at %u (totalsize=%u,tablesize=%u)",
-				chunks.Num(),pointers.Num(),typeFixups.Num(),assetIdFixups.Num(),relocationTableOffset,bytesWritten,bytesWritten-relocationTableOffset);
-
-			return relocationTableOffset;
+			DBG_MSG("WRITE: %u chunks, %u pointers, %u typeIDs, %u assetIDs (tablesize=%u)",
+				chunks.Num(),pointers.Num(),typeFixups.Num(),assetIdFixups.Num(),bytesWritten);
+			return ALL_OK;
 		}
 	public:
-		typedef Reflection::AVisitor Super;
-
 		LIPInfoGatherer()
 		{}
-		//-- Reflection::AVisitor
-		virtual void Visit_Pointer( VoidPointer& p, const mxPointerType& type, const Context& _context ) override
+		// member names are stored for debugging
+		static UINT32 GetFlags() { return Reflection::Visitor_TrackPath; }
+		//-- Reflection::StaticVisitorBase
+		void Visit_Pointer( VoidPointer& p, const mxPointerType& type, const Context& _context )
 		{
 			// null pointers will be written as it is - zeros
 			if( p.o != NULL )
@@ -275,13 +451,13 @@ namespace Serialization
 				//}
 			}
 		}
-		virtual void Visit_TypeId( SClassId * o, const Context& _context ) override
+		void Visit_TypeId( SClassId * o, const Context& _context )
 		{
 			DBG_MSG2(_context,"Visit_TypeId(): '%s' at 0x%p (\'%s\')", o->type->GetTypeName(), o->type, _context.GetMemberName());
 			STypeInfo & newItem = typeFixups.Add();
 			newItem.o = o;
 		}
-		virtual bool Visit_Array( void * _array, const mxArray& _type, const Context& _context ) override
+		bool Visit_Array( void * _array, const mxArray& _type, const Context& _context )
 		{
 			const UINT32 capacity = _type.Generic_Get_Capacity( _array );
 			if( capacity > 0 )
@@ -300,7 +476,7 @@ namespace Serialization
 			const bool bIterateOverElements = !ETypeKind_Is_Bitwise_Serializable( _type.m_itemType.m_kind );
 			return bIterateOverElements;
 		}
-		virtual void Visit_String( String & _string, const Context& _context ) override
+		void Visit_String( String & _string, const Context& _context )
 		{
 			if( _string.NonEmpty() )
 			{
@@ -308,12 +484,22 @@ namespace Serialization
 				this->AddPointer( _string.GetBufferAddress(), _string.ToPtr(), _context );
 			}
 		}
-		virtual void Visit_AssetId( AssetID & _assetId, const Context& _context )
+		void Visit_AssetId( AssetID & _assetId, const Context& _context )
 		{
 			assetIdFixups.Add( &_assetId );
 		}
 	};
 
+	static void InitImageHeader( ImageHeader &_header, TypeID _classId, UINT32 _payload )
+	{
+		mxZERO_OUT( _header );
+		_header.fourCC = IMAGE_FOURCC;
+		_header.version = IMAGE_VERSION;
+		_header.session = PtSessionInfo::CURRENT;
+		_header.classId = _classId;
+		_header.payload = _payload;
+	}
+
 	ERet SaveImage( const void* _o, const mxClass& _type, AStreamWriter &_stream )
 	{
 		LIPInfoGatherer	lip;
@@ -324,49 +510,113 @@ namespace Serialization
 		lip.AddChunk( _o, _type.m_size, _type.m_align, ctx );
 
 		// Recursively visit all referenced objects.
-		Reflection::Walker2::Visit( const_cast<void*>(_o), _type, &lip );
+		Reflection::StaticWalk( const_cast<void*>(_o), _type, lip );
 
 		// Determine file offsets of all memory blocks.
 		const UINT32 alignedDataSize = lip.ResolveChunkOffsets();
 
 		// Write the header.
 		ImageHeader	header;
-		{
-			header.session = PtSessionInfo::CURRENT;
-			header.classId = _type.GetTypeID();
-			header.payload = alignedDataSize;
-		}
+		InitImageHeader( header, _type.GetTypeID(), alignedDataSize );
 		mxDO(_stream.Put( header ));
 
 		DBG_MSG("WRITE: Object: '%s' (%#010x), data size: '%u', table start: '%u'",
 			_type.GetTypeName(), header.classId, alignedDataSize, sizeof(header) + alignedDataSize);
 
 		// Write all memory blocks and relocation tables.
-		lip.WriteChunksAndFixUpTables( _stream );
+		mxDO(lip.WriteChunksAndFixUpTables( _stream ));
+
+		return ALL_OK;
+	}
+
+	// an entry of the pointer relocation table
+	struct SPointerFixup
+	{
+		UINT32	pointerOffset;	// offset of the pointer itself
+		UINT32	targetOffset;	// offset of the memory the pointer points at
+	};
+	ASSERT_SIZEOF(SPointerFixup, 8);
+
+	// relocation tables are read in batches of this size
+	enum { FIXUP_BATCH_SIZE = 256 };
+
+	// trusted data: no branches, just patch pointers
+	static mxFORCEINLINE void ApplyPointerFixups_Trusted( void* _objectBuffer, const SPointerFixup* _fixups, UINT32 _count )
+	{
+		BYTE* base = static_cast< BYTE* >( _objectBuffer );
+		for( UINT32 i = 0; i < _count; i++ )
+		{
+			*(BYTE**)( base + _fixups[i].pointerOffset ) = base + _fixups[i].targetOffset;
+		}
+	}
 
+	// untrusted data: each pointer must lie within the buffer and point inside it
+	static ERet ApplyPointerFixups_Validated( void* _objectBuffer, UINT32 _bufferSize, const SPointerFixup* _fixups, UINT32 _count )
+	{
+		chkRET_X_IF_NOT(_bufferSize >= sizeof(void*), ERR_FAILED_TO_PARSE_DATA);
+		const UINT32 maxPointerOffset = _bufferSize - sizeof(void*);
+		BYTE* base = static_cast< BYTE* >( _objectBuffer );
+		for( UINT32 i = 0; i < _count; i++ )
+		{
+			const SPointerFixup& fixup = _fixups[i];
+			if( fixup.pointerOffset > maxPointerOffset || fixup.targetOffset >= _bufferSize )
+			{
+				ptWARN("Bad relocation: %u -> %u (payload size: %u)\n", fixup.pointerOffset, fixup.targetOffset, _bufferSize);
+				return ERR_FAILED_TO_PARSE_DATA;
+			}
+			*(BYTE**)( base + fixup.pointerOffset ) = base + fixup.targetOffset;
+		}
 		return ALL_OK;
 	}
 
-	static ERet ReadAndApplyFixups( AStreamReader& _reader, void* _objectBuffer, UINT32 _bufferSize )
+	// offsets of class and asset ids initialized by the relocation tables;
+	// the loaded image may only contain these ids (others hold raw bytes from the file)
+	struct SPatchedIds
 	{
+		TArray< UINT32 >	classIds;
+		TArray< UINT32 >	assetIds;
+	};
+
+	// _payloadChecksum - (optional) checksum of the payload, if it was computed before the buffer was modified
+	// _patchedIds - (optional) receives offsets of patched ids (only in validated mode)
+	static ERet ReadAndApplyFixups( AStreamReader& _reader, void* _objectBuffer, UINT32 _bufferSize, const ELoadMode _mode, const UINT32* _payloadChecksum = NULL, SPatchedIds* _patchedIds = NULL )
+	{
+		const bool validate = (_mode == LoadMode_Validated);
+
+		// Verify the payload checksum (the buffer hasn't been patched yet).
+		UINT32 payloadChecksum;
+		mxDO(_reader.Get(payloadChecksum));
+		if( validate )
+		{
+			const UINT32 actualChecksum = _payloadChecksum ? *_payloadChecksum : CRC32C( _objectBuffer, _bufferSize );
+			if( actualChecksum != payloadChecksum ) {
+				ptWARN("Image checksum mismatch: 0x%08x != 0x%08x\n", actualChecksum, payloadChecksum);
+				return ERR_FAILED_TO_PARSE_DATA;
+			}
+		}
+
 		// Load and apply fixup tables.
 		// Relocate pointers.
 		UINT32 numPointerFixups;
-		_reader.Get(numPointerFixups);
-		for( UINT32 i = 0; i < numPointerFixups; i++ )
+		mxDO(_reader.Get(numPointerFixups));
 		{
-			UINT32 pointerOffset;
-			UINT32 targetOffset;
-			mxDO(_reader.Get(pointerOffset));
-			mxDO(_reader.Get(targetOffset));
-
-			void* pointerAddress = mxAddByteOffset( _objectBuffer, pointerOffset );
-			void* targetAddress = mxAddByteOffset( _objectBuffer, targetOffset );
-			*((void**)pointerAddress) = targetAddress;
+			SPointerFixup	batch[ FIXUP_BATCH_SIZE ];
+			UINT32 numRemaining = numPointerFixups;
+			while( numRemaining > 0 )
+			{
+				const UINT32 batchSize = smallest( numRemaining, (UINT32)FIXUP_BATCH_SIZE );
+				mxDO(_reader.Read( batch, batchSize * sizeof(batch[0]) ));
+				if( validate ) {
+					mxDO(ApplyPointerFixups_Validated( _objectBuffer, _bufferSize, batch, batchSize ));
+				} else {
+					ApplyPointerFixups_Trusted( _objectBuffer, batch, batchSize );
+				}
+				numRemaining -= batchSize;
+			}
 		}
 		// Fixup type ids.
 		UINT32 numTypeFixups;
-		_reader.Get(numTypeFixups);
+		mxDO(_reader.Get(numTypeFixups));
 		for( UINT32 i = 0; i < numTypeFixups; i++ )
 		{
 			UINT32 pointerOffset;
@@ -374,18 +624,34 @@ namespace Serialization
 			mxDO(_reader.Get(pointerOffset));
 			mxDO(_reader.Get(typeID));
 
+			if( validate )
+			{
+				chkRET_X_IF_NOT(_bufferSize >= sizeof(SClassId) && pointerOffset <= _bufferSize - sizeof(SClassId), ERR_FAILED_TO_PARSE_DATA);
+				chkRET_X_IF_NOT(TypeRegistry::Get().ClassExists( typeID ), ERR_OBJECT_OF_WRONG_TYPE);
+				if( _patchedIds ) {
+					_patchedIds->classIds.Add( pointerOffset );
+				}
+			}
+
 			const mxClass* typeInfo = TypeRegistry::Get().FindClassByGuid( typeID );
 			mxASSERT_PTR(typeInfo);
 			void* pointerAddress = mxAddByteOffset( _objectBuffer, pointerOffset );
 			*(void**)pointerAddress = (void*)typeInfo;
 		}
 		UINT32 numAssetIdFixups;
-		_reader.Get(numAssetIdFixups);
+		mxDO(_reader.Get(numAssetIdFixups));
 		for( UINT32 i = 0; i < numAssetIdFixups; i++ )
 		{
 			UINT32 pointerOffset;
 			mxDO(_reader.Get(pointerOffset));
 
+			if( validate ) {
+				chkRET_X_IF_NOT(_bufferSize >= sizeof(AssetID) && pointerOffset <= _bufferSize - sizeof(AssetID), ERR_FAILED_TO_PARSE_DATA);
+				if( _patchedIds ) {
+					_patchedIds->assetIds.Add( pointerOffset );
+				}
+			}
+
 			AssetID* assetId = (AssetID*) mxAddByteOffset( _objectBuffer, pointerOffset );
 			new(assetId) AssetID();
 			mxDO(ReadAssetID( _reader, assetId ));
@@ -393,10 +659,124 @@ namespace Serialization
 		return ALL_OK;
 	}
 
-	static ERet ReadAndApplyFixups( void* objectBuffer, UINT32 objectDataSize, void* fixupTables, UINT32 tableDataSize )
+	static ERet ReadAndApplyFixups( void* objectBuffer, UINT32 objectDataSize, void* fixupTables, UINT32 tableDataSize, const ELoadMode _mode, SPatchedIds* _patchedIds = NULL )
 	{
 		MemoryReader	stream( fixupTables, tableDataSize );
-		mxDO(ReadAndApplyFixups( stream, objectBuffer, objectDataSize ));
+		mxDO(ReadAndApplyFixups( stream, objectBuffer, objectDataSize, _mode, NULL, _patchedIds ));
+		return ALL_OK;
+	}
+
+	// Makes sure that all references in the loaded (and relocated) image
+	// stay inside the image and are properly aligned
+	// and that class and asset ids were initialized by the relocation tables.
+	// Must only be called after the relocation tables have been validated.
+	class ImagePointerValidator : public Reflection::StaticVisitorBase
+	{
+		const void *		m_start;
+		const UINT32		m_size;
+		const SPatchedIds &	m_patchedIds;	// sorted
+		UINT32				m_numErrors;
+	public:
+		ImagePointerValidator( const void* _start, UINT32 _size, const SPatchedIds& _patchedIds )
+			: m_start( _start ), m_size( _size ), m_patchedIds( _patchedIds ), m_numErrors( 0 )
+		{}
+		// for printing names of invalid fields
+		static UINT32 GetFlags() { return Reflection::Visitor_TrackPath; }
+		bool IsValid() const
+		{
+			return m_numErrors == 0;
+		}
+		bool Visit_Array( void * _array, const mxArray& _type, const Context& _context )
+		{
+			if( !_type.IsDynamic() ) {
+				return true;
+			}
+			const UINT32 count = _type.Generic_Get_Count( _array );
+			const UINT32 capacity = _type.Generic_Get_Capacity( _array );
+			if( capacity == 0 ) {
+				return count == 0 || this->Error( "array", _context );
+			}
+			const mxType& itemType = _type.m_itemType;
+			const void* arrayBase = _type.Generic_Get_Data( _array );
+			const UINT64 arraySize = (UINT64)capacity * itemType.m_size;
+			const bool isValid = count <= capacity
+				&& arraySize <= m_size
+				&& this->IsInRange( arrayBase, (UINT32)arraySize, itemType.m_align )
+				;
+			// don't iterate over elements of a corrupted array
+			return isValid || this->Error( "array", _context );
+		}
+		void Visit_String( String & _string, const Context& _context )
+		{
+			if( _string.NonEmpty() && !this->IsInRange( _string.ToPtr(), _string.Length() + 1, String::ALIGNMENT ) ) {
+				this->Error( "string", _context );
+			}
+		}
+		void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context )
+		{
+			if( _pointer.o != NULL && !this->IsInRange( _pointer.o, _type.pointee.m_size, _type.pointee.m_align ) ) {
+				this->Error( "pointer", _context );
+			}
+		}
+		// the type pointer was set from a registered class (see ReadAndApplyFixups()) or is null
+		void Visit_TypeId( SClassId * _class, const Context& _context )
+		{
+			if( !this->IsInRange( _class, sizeof(*_class), sizeof(void*) ) ) {
+				this->Error( "class id", _context );
+				return;
+			}
+			if( _class->type != NULL && !IsPatched( m_patchedIds.classIds, _class ) ) {
+				this->Error( "class id", _context );
+			}
+		}
+		// the asset id was read from the relocation tables, not from the payload
+		void Visit_AssetId( AssetID & _assetId, const Context& _context )
+		{
+			if( !this->IsInRange( &_assetId, sizeof(_assetId), sizeof(void*) )
+				|| !IsPatched( m_patchedIds.assetIds, &_assetId ) )
+			{
+				this->Error( "asset id", _context );
+			}
+		}
+	private:
+		bool IsPatched( const TArray< UINT32 >& _offsets, const void* _pointer ) const
+		{
+			const UINT32 offset = (const char*)_pointer - (const char*)m_start;
+			return std::binary_search( _offsets.ToPtr(), _offsets.ToPtr() + _offsets.Num(), offset );
+		}
+		bool IsInRange( const void* _pointer, UINT32 _size, UINT32 _alignment ) const
+		{
+			const ptrdiff_t offset = (const char*)_pointer - (const char*)m_start;
+			return offset >= 0
+				&& (UINT64)offset + _size <= m_size
+				&& IsAlignedBy( _pointer, largest( _alignment, 1U ) )
+				;
+		}
+		bool Error( const char* _what, const Context& _context )
+		{
+			ptWARN("Invalid %s in memory image: '%s'\n", _what, _context.GetMemberName());
+			m_numErrors++;
+			return false;
+		}
+	};
+
+	static ERet ValidateImagePointers( void* _object, const mxClass& _type, UINT32 _size, SPatchedIds& _patchedIds )
+	{
+		std::sort( _patchedIds.classIds.ToPtr(), _patchedIds.classIds.ToPtr() + _patchedIds.classIds.Num() );
+		std::sort( _patchedIds.assetIds.ToPtr(), _patchedIds.assetIds.ToPtr() + _patchedIds.assetIds.Num() );
+
+		ImagePointerValidator	validator( _object, _size, _patchedIds );
+		Reflection::StaticWalk( _object, _type, validator );
+		chkRET_X_IF_NOT(validator.IsValid(), ERR_FAILED_TO_PARSE_DATA);
+		return ALL_OK;
+	}
+
+	ERet ValidateImageVersion( const ImageHeader& header )
+	{
+		if( header.fourCC != IMAGE_FOURCC || header.version != IMAGE_VERSION ) {
+			ptWARN("Incompatible image version: %u (expected %u)\n", header.version, IMAGE_VERSION);
+			return ERR_INCOMPATIBLE_VERSION;
+		}
 		return ALL_OK;
 	}
 
@@ -417,11 +797,12 @@ namespace Serialization
 		return ALL_OK;
 	}
 
-	ERet LoadImage( AStreamReader& stream, const mxClass& type, ByteArrayT &buffer )
+	ERet LoadImage( AStreamReader& stream, const mxClass& type, ByteArrayT &buffer, ELoadMode mode )
 	{
 		ImageHeader	header;
 		mxDO(stream.Get(header));
 
+		mxDO(ValidateImageVersion(header));
 		mxDO(ValidatePlatformAndType(header, type));
 
 		DBG_MSG("READ: Object: '%s' (%#010x), data size: '%u', table start: '%u'",
@@ -434,25 +815,36 @@ namespace Serialization
 		mxDO(stream.Read(buffer.ToPtr(), header.payload));
 
 		header.payload = AlignUp( header.payload, OBJECT_BLOB_ALIGNMENT );
-		mxDO(ReadAndApplyFixups( stream, buffer.ToPtr(), buffer.Num() ));
+		SPatchedIds	patchedIds;
+		mxDO(ReadAndApplyFixups( stream, buffer.ToPtr(), buffer.Num(), mode, NULL, &patchedIds ));
+		if( mode == LoadMode_Validated ) {
+			mxDO(ValidateImagePointers( buffer.ToPtr(), type, buffer.Num(), patchedIds ));
+		}
 		Reflection::MarkMemoryAsExternallyAllocated( buffer.ToPtr(), type );
 
 		return ALL_OK;
 	}
 
-	ERet LoadInPlace( const mxClass& type, void* buffer, UINT32 length, void *&o )
+	ERet LoadInPlace( const mxClass& type, void* buffer, UINT32 length, void *&o, ELoadMode mode )
 	{
+		chkRET_X_IF_NOT(length >= sizeof(ImageHeader), ERR_BUFFER_TOO_SMALL);
 		ImageHeader& header = *static_cast< ImageHeader* >( buffer );
 
+		mxDO(ValidateImageVersion(header));
 		mxDO(ValidatePlatformAndType(header, type));
 		mxDO(ValidateSizeAndAlignment(header, type, buffer, length));
 
 		header.payload = AlignUp( header.payload, OBJECT_BLOB_ALIGNMENT );
+		chkRET_X_IF_NOT(length - sizeof(ImageHeader) >= header.payload, ERR_BUFFER_TOO_SMALL);
 		void* objectData = mxAddByteOffset(buffer, sizeof(ImageHeader));
 		void* fixupsData = mxAddByteOffset(objectData, header.payload);
 		UINT32 tableSize = length - sizeof(ImageHeader) - header.payload;
 
-		mxDO(ReadAndApplyFixups(objectData, header.payload, fixupsData, tableSize));
+		SPatchedIds	patchedIds;
+		mxDO(ReadAndApplyFixups(objectData, header.payload, fixupsData, tableSize, mode, &patchedIds));
+		if( mode == LoadMode_Validated ) {
+			mxDO(ValidateImagePointers( objectData, type, header.payload, patchedIds ));
+		}
 		Reflection::MarkMemoryAsExternallyAllocated( objectData, type );
 
 		o = objectData;
@@ -463,14 +855,20 @@ namespace Serialization
 	ERet LoadInPlace(
 		const mxClass& type, const ImageHeader& header,
 		void * buffer, UINT32 length,
-		AStreamReader& stream
+		AStreamReader& stream,
+		ELoadMode mode
 		)
 	{
+		mxDO(ValidateImageVersion(header));
 		mxDO(ValidatePlatformAndType(header, type));
 		mxDO(ValidateSizeAndAlignment(header, type, buffer, length));
 
 		mxDO(stream.Read( buffer, header.payload ));
-		mxDO(ReadAndApplyFixups( stream, buffer, header.payload ));
+		SPatchedIds	patchedIds;
+		mxDO(ReadAndApplyFixups( stream, buffer, header.payload, mode, NULL, &patchedIds ));
+		if( mode == LoadMode_Validated ) {
+			mxDO(ValidateImagePointers( buffer, type, header.payload, patchedIds ));
+		}
 		Reflection::MarkMemoryAsExternallyAllocated( buffer, type );
 
 		return ALL_OK;
@@ -499,12 +897,13 @@ namespace Serialization
 
 		// 1. Gather all internal references (pointers).
 		{
-			class GatherPointers : public Reflection::AVisitor2 {
+			class GatherPointers : public Reflection::StaticVisitorBase {
 				SaveMapT & m_pointerMap;
 			public:
 				GatherPointers( SaveMapT &_pointerMap ) : m_pointerMap( _pointerMap )
 				{}
-				virtual void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context ) override
+				static UINT32 GetInterests() { return Reflection::TypeHas_Pointers; }
+				void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context )
 				{
 					if( _pointer.o != NULL )
 					{
@@ -514,18 +913,18 @@ namespace Serialization
 				}
 			};
 			GatherPointers	gatherPointers( pointerMap );
-			Reflection::Walker2::Visit( const_cast<void*>(o), _type, &gatherPointers );
+			Reflection::StaticWalk( const_cast<void*>(o), _type, gatherPointers );
 		}
 
 		// 2. Figure out pointer IDs which should be written in place of pointers.
 		{
-			class ResolvePointers : public Reflection::AVisitor2 {
+			class ResolvePointers : public Reflection::StaticVisitorBase {
 				SaveMapT & m_pointerMap;
 				int m_uniqueObjectID;	// zero is reserved for null pointers
 			public:
 				ResolvePointers( SaveMapT & _pointerMap ) : m_pointerMap( _pointerMap ), m_uniqueObjectID( 1 )
 				{}
-				virtual bool Visit_Class( void * _object, const mxClass& _type, const Context& _context )
+				bool Visit_Class( void * _object, const mxClass& _type, const Context& _context )
 				{
 					const int uniqueObjectID = m_uniqueObjectID++;
 
@@ -540,47 +939,46 @@ namespace Serialization
 				}
 			};
 			ResolvePointers	resolvePointers( pointerMap );
-			Reflection::Walker2::Visit( const_cast<void*>(o), _type, &resolvePointers );
+			Reflection::StaticWalk( const_cast<void*>(o), _type, resolvePointers );
 		}
 
 		// 3. Serialize to stream.
 
-		class BinarySerializer : public Reflection::AVisitor2 {
+		class BinarySerializer : public Reflection::StaticVisitorBase {
 			const SaveMapT & m_pointerMap;
 		public:
 			BinarySerializer( const SaveMapT& _pointerMap ) : m_pointerMap( _pointerMap )
 			{}
-			virtual bool Visit_Array( void * _array, const mxArray& _type, const Context& _context ) override
+			bool Visit_Array( void * _array, const mxArray& _type, const Context& _context )
 			{
 				AStreamWriter &stream = *(AStreamWriter*) _context.userData;
 
 				const UINT32 arrayCount = _type.Generic_Get_Count( _array );
-				const void* arrayBase = _type.Generic_Get_Data( _array );
-
 				stream << arrayCount;
 
-				const mxType& itemType = _type.m_itemType;
-				const UINT32 itemSize = itemType.m_size;
-
-				const bool isPOD = false;// ETypeKind_Is_Bitwise_Serializable( itemType.m_kind );
-				if( isPOD ) {
-					stream.Write( arrayBase, arrayCount * itemSize );
+				return true;
+			}
+			bool Visit_PODArray( void * _base, const mxType& _itemType, UINT32 _count, UINT32 _stride, const Context& _context )
+			{
+				// objects must be visited one by one to keep their IDs in sync with the loader
+				if( _itemType.m_kind == ETypeKind::Type_Class || _itemType.m_size != _stride ) {
 					return false;
-				} else {
-					return true;
 				}
+				AStreamWriter &stream = *(AStreamWriter*) _context.userData;
+				stream.Write( _base, _count * _stride );
+				return true;
 			}
-			virtual void Visit_POD( void * _memory, const mxType& type, const Context& _context ) override
+			void Visit_POD( void * _memory, const mxType& type, const Context& _context )
 			{
 				AStreamWriter &stream = *(AStreamWriter*) _context.userData;
 				stream.Write( _memory, type.m_size );
 			}
-			virtual void Visit_String( String & _string, const Context& _context ) override
+			void Visit_String( String & _string, const Context& _context )
 			{
 				AStreamWriter &stream = *(AStreamWriter*) _context.userData;
 				stream << _string;
 			}
-			virtual void Visit_TypeId( SClassId * _pointer, const Context& _context ) override
+			void Visit_TypeId( SClassId * _pointer, const Context& _context )
 			{
 				AStreamWriter &stream = *(AStreamWriter*) _context.userData;
 				if( _pointer->type != NULL ) {
@@ -589,12 +987,12 @@ namespace Serialization
 					stream << TypeID(0);
 				}
 			}
-			virtual void Visit_AssetId( AssetID & _assetId, const Context& _context ) override
+			void Visit_AssetId( AssetID & _assetId, const Context& _context )
 			{
 				AStreamWriter &stream = *(AStreamWriter*) _context.userData;
 				stream << _assetId.d;
 			}
-			virtual void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context ) override
+			void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context )
 			{
 				AStreamWriter &stream = *(AStreamWriter*) _context.userData;
 				// null pointers will be written as zeros
@@ -620,7 +1018,7 @@ namespace Serialization
 		};
 
 		BinarySerializer	serializer( pointerMap );
-		Reflection::Walker2::Visit( const_cast<void*>(o), _type, &serializer, &stream );
+		Reflection::StaticWalk( const_cast<void*>(o), _type, serializer, &stream );
 
 		return ALL_OK;
 	}
@@ -641,13 +1039,13 @@ namespace Serialization
 
 		// 1. Read object data and allocate memory for everything
 		{
-			class BinaryDeserializer : public Reflection::AVisitor2 {
+			class BinaryDeserializer : public Reflection::StaticVisitorBase {
 				LoadMapT & m_pointerMap;
 				int m_uniqueObjectID;	// zero is reserved for null pointers
 			public:
 				BinaryDeserializer( LoadMapT & _pointerMap ) : m_pointerMap( _pointerMap ), m_uniqueObjectID( 1 )
 				{}
-				virtual bool Visit_Class( void * _object, const mxClass& _type, const Context& _context ) override
+				bool Visit_Class( void * _object, const mxClass& _type, const Context& _context )
 				{
 #if USE_HASH_MAP
 					const int uniqueObjectID = m_uniqueObjectID++;
@@ -659,7 +1057,7 @@ namespace Serialization
 #endif
 					return true;
 				}
-				virtual bool Visit_Array( void * _array, const mxArray& arrayType, const Context& _context ) override
+				bool Visit_Array( void * _array, const mxArray& arrayType, const Context& _context )
 				{
 					AStreamReader& stream = *(AStreamReader*) _context.userData;
 
@@ -667,42 +1065,41 @@ namespace Serialization
 					stream >> arrayCount;
 					arrayType.Generic_Set_Count( _array, arrayCount );
 
-					void* arrayBase = arrayType.Generic_Get_Data( _array );
-
-					const mxType& itemType = arrayType.m_itemType;
-					const UINT32 itemSize = itemType.m_size;
-
-					const bool isPOD = false;//ETypeKind_Is_Bitwise_Serializable( itemType.m_kind );
-					if( isPOD ) {
-						stream.Read( arrayBase, arrayCount * itemSize );
+					return true;
+				}
+				bool Visit_PODArray( void * _base, const mxType& _itemType, UINT32 _count, UINT32 _stride, const Context& _context )
+				{
+					// Visit_Class() records the addresses of all objects
+					if( _itemType.m_kind == ETypeKind::Type_Class || _itemType.m_size != _stride ) {
 						return false;
-					} else {
-						return true;
 					}
+					AStreamReader& stream = *(AStreamReader*) _context.userData;
+					stream.Read( _base, _count * _stride );
+					return true;
 				}
-				virtual void Visit_POD( void * _memory, const mxType& type, const Context& _context ) override
+				void Visit_POD( void * _memory, const mxType& type, const Context& _context )
 				{
 					AStreamReader& stream = *(AStreamReader*) _context.userData;
 					stream.Read( _memory, type.m_size );
 				}
-				virtual void Visit_String( String & _string, const Context& _context ) override
+				void Visit_String( String & _string, const Context& _context )
 				{
 					AStreamReader& stream = *(AStreamReader*) _context.userData;
 					stream >> _string;
 				}
-				virtual void Visit_TypeId( SClassId * _class, const Context& _context ) override
+				void Visit_TypeId( SClassId * _class, const Context& _context )
 				{
 					AStreamReader& stream = *(AStreamReader*) _context.userData;
 					TypeID classId;
 					stream >> classId;
 					_class->type = TypeRegistry::Get().FindClassByGuid( classId );
 				}
-				virtual void Visit_AssetId( AssetID & _assetId, const Context& _context ) override
+				void Visit_AssetId( AssetID & _assetId, const Context& _context )
 				{
 					AStreamReader& stream = *(AStreamReader*) _context.userData;
 					stream >> _assetId.d;
 				}
-				virtual void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context ) override
+				void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context )
 				{
 					AStreamReader& stream = *(AStreamReader*) _context.userData;
 					int pointerID;
@@ -711,17 +1108,18 @@ namespace Serialization
 				}
 			};
 			BinaryDeserializer	deserializer( pointerMap );
-			Reflection::Walker2::Visit( o, _type, &deserializer, &stream );
+			Reflection::StaticWalk( o, _type, deserializer, &stream );
 		}
 
 		// 2. Resolve pointers
 
-		class ResolvePointers : public Reflection::AVisitor2 {
+		class ResolvePointers : public Reflection::StaticVisitorBase {
 			const LoadMapT & m_pointerMap;
 		public:
 			ResolvePointers( const LoadMapT& _pointerMap ) : m_pointerMap( _pointerMap )
 			{}
-			virtual void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context ) override
+			static UINT32 GetInterests() { return Reflection::TypeHas_Pointers; }
+			void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context )
 			{
 				const int pointerID = (int) reinterpret_cast< size_t >( _pointer.o );
 				mxASSERT(pointerID != -1);
@@ -742,7 +1140,7 @@ namespace Serialization
 			}
 		};
 		ResolvePointers	fixPointers( pointerMap );
-		Reflection::Walker2::Visit( const_cast<void*>(o), _type, &fixPointers );
+		Reflection::StaticWalk( const_cast<void*>(o), _type, fixPointers );
 
 		return ALL_OK;
 	}
@@ -764,10 +1162,9 @@ namespace Serialization
 		return LoadBinary(reader, type, o);
 	}
 
-	ERet SaveClumpImage( const Clump& _clump, AStreamWriter &_stream )
+	// collects the clump, all object lists and all objects
+	static void GatherClumpChunks( const Clump& _clump, LIPInfoGatherer &lip )
 	{
-		LIPInfoGatherer	lip;
-
 		Reflection::AVisitor2::Context	clumpCtx;
 		clumpCtx.userName = "Clump";
 
@@ -775,7 +1172,7 @@ namespace Serialization
 		lip.AddChunk( &_clump, sizeof(Clump), EFFICIENT_ALIGNMENT, clumpCtx );
 
 		// Recursively visit all referenced objects.
-		Reflection::Walker2::Visit( c_cast(void*)(&_clump), mxCLASS_OF(_clump), &lip, clumpCtx );
+		Reflection::StaticWalk( c_cast(void*)(&_clump), mxCLASS_OF(_clump), lip, clumpCtx );
 
 
 		ObjectList::Head currentList = _clump.GetObjectLists();
@@ -793,7 +1190,7 @@ namespace Serialization
 
 			lip.AddChunk( currentList, sizeof(ObjectList), EFFICIENT_ALIGNMENT, objectListCtx );
 
-			Reflection::Walker2::Visit( c_cast(void*)currentList, mxCLASS_OF(*currentList), &lip, objectListCtx );
+			Reflection::StaticWalk( c_cast(void*)currentList, mxCLASS_OF(*currentList), lip, objectListCtx );
 
 			lip.AddChunk( objectsArray, objectCount*arrayStride, objectType.m_align, objectListCtx );
 
@@ -805,43 +1202,50 @@ namespace Serialization
 			while( it.IsValid() )
 			{
 				void* o = it.ToVoidPtr();
-				Reflection::Walker2::Visit( o, objectType, &lip, objectCtx );
+				Reflection::StaticWalk( o, objectType, lip, objectCtx );
 				it.MoveToNext();
 			}
 
 			currentList = currentList->_next;
 		}
+	}
+
+	ERet SaveClumpImage( const Clump& _clump, AStreamWriter &_stream )
+	{
+		LIPInfoGatherer	lip;
+		GatherClumpChunks( _clump, lip );
 
 		// Determine file offsets of all memory blocks.
 		const UINT32 alignedDataSize = lip.ResolveChunkOffsets();
 
 		// Write the header.
 		ImageHeader	header;
-		{
-			header.session = PtSessionInfo::CURRENT;
-			header.classId = mxCLASS_OF(_clump).GetTypeID();
-			header.payload = alignedDataSize;
-		}
+		InitImageHeader( header, mxCLASS_OF(_clump).GetTypeID(), alignedDataSize );
 		mxDO(_stream.Put( header ));
 
 		DBG_MSG("WRITE: Object: '%s' (%#010x), data size: '%u', table start: '%u'",
 			"Clump", header.classId, alignedDataSize, sizeof(header) + alignedDataSize);
 
 		// Write all memory blocks and relocation tables.
-		lip.WriteChunksAndFixUpTables( _stream );
+		mxDO(lip.WriteChunksAndFixUpTables( _stream ));
 
 		return ALL_OK;
 	}
 
-	ERet LoadClumpImage( AStreamReader& _stream, UINT32 _payload, void *_buffer )
+	// patches the clump after the payload has been loaded into the buffer
+	static ERet FixupLoadedClump( void *_buffer, UINT32 _payload, AStreamReader& _tables, ELoadMode _mode )
 	{
-		mxDO(_stream.Read( _buffer, _payload ));
+		//NOTE: the checksum is computed before the constructor overwrites the clump header
+		UINT32 payloadChecksum = 0;
+		if( _mode == LoadMode_Validated ) {
+			payloadChecksum = CRC32C( _buffer, _payload );
+		}
 
 		Clump* clump = new(_buffer) Clump();
 
 		// Patch the clump after loading.
 
-		mxDO(ReadAndApplyFixups( _stream, _buffer, _payload ));
+		mxDO(ReadAndApplyFixups( _tables, _buffer, _payload, _mode, (_mode == LoadMode_Validated) ? &payloadChecksum : NULL ));
 
 		new(&clump->m_objectListsStorage)FreeListAllocator();
 		clump->m_objectListsStorage.Initialize( sizeof(ObjectList), 16 );
@@ -852,8 +1256,314 @@ namespace Serialization
 		return ALL_OK;
 	}
 
+	ERet LoadClumpImage( AStreamReader& _stream, UINT32 _payload, void *_buffer, ELoadMode _mode )
+	{
+		if( _mode == LoadMode_Validated ) {
+			chkRET_X_IF_NOT(_payload >= sizeof(Clump), ERR_BUFFER_TOO_SMALL);
+			chkRET_X_IF_NOT(IsAlignedBy(_buffer, EFFICIENT_ALIGNMENT), ERR_INVALID_ALIGNMENT);
+		}
+
+		mxDO(_stream.Read( _buffer, _payload ));
+
+		mxDO(FixupLoadedClump( _buffer, _payload, _stream, _mode ));
+
+		return ALL_OK;
+	}
+
+	/*
+	-----------------------------------------------------------------------------
+		IncrementalClumpImageWriter
+	-----------------------------------------------------------------------------
+	*/
+	static const UINT32 INCREMENTAL_IMAGE_FOURCC = MCHAR4('I','N','C','R');
+	static const UINT32 INCREMENTAL_IMAGE_VERSION = 2;	// 2: version field, gaps are hashed as zeros
+
+	//
+	// Incremental image file layout:
+	//	IncrementalImageHeader
+	//	(for each save):
+	//		modified memory blocks
+	//		UINT32 payload size, UINT32 number of blocks, SChunkLocation[]
+	//		relocation tables (in the same format as in SaveImage())
+	//		IncrementalImageFooter
+	// Only the last layout and relocation tables are used, all older data is stale.
+	//
+	// NOTE: older readers take the version for the class id and reject the file.
+	struct IncrementalImageHeader
+	{
+		UINT32			fourCC;		// 4 INCREMENTAL_IMAGE_FOURCC
+		UINT32			version;	// 4 INCREMENTAL_IMAGE_VERSION
+		PtSessionInfo	session;	// 8 platform/engine info
+		TypeID			classId;	// 4 type of stored object
+		UINT32			_unused;	// 4
+	};
+	ASSERT_SIZEOF(IncrementalImageHeader, 24);
+
+	struct IncrementalImageFooter
+	{
+		UINT32	layoutOffset;	// 4 offset of the latest layout table
+		UINT32	fourCC;			// 4 INCREMENTAL_IMAGE_FOURCC
+	};
+	ASSERT_SIZEOF(IncrementalImageFooter, 8);
+
+	// where the memory block is stored in the file and where it goes in the loaded image
+	struct SChunkLocation
+	{
+		UINT32	payloadOffset;
+		UINT32	fileOffset;
+		UINT32	size;
+	};
+	ASSERT_SIZEOF(SChunkLocation, 12);
+
+	IncrementalClumpImageWriter::IncrementalClumpImageWriter()
+	{
+		compactionThreshold = 50;
+		m_fileSize = 0;
+		m_compactNext = false;
+	}
+
+	IncrementalClumpImageWriter::~IncrementalClumpImageWriter()
+	{
+	}
+
+	bool IncrementalClumpImageWriter::WillRewriteFile() const
+	{
+		return m_fileSize == 0 || m_compactNext;
+	}
+
+	void IncrementalClumpImageWriter::Reset()
+	{
+		m_savedChunks.Empty();
+		m_fileSize = 0;
+		m_compactNext = false;
+	}
+
+	ERet IncrementalClumpImageWriter::Save( const Clump& _clump, AStreamWriter &_stream )
+	{
+		const ERet result = this->AppendImage( _clump, _stream );
+		if( result != ALL_OK ) {
+			// the saved chunks may not have reached the file
+			this->Reset();
+		}
+		return result;
+	}
+
+	// the file format uses 32-bit offsets
+	static ERet CheckIncrementalImageSize( UINT64 _fileSize )
+	{
+		if( _fileSize > (UINT32)~0 ) {
+			ptWARN("Incremental image exceeds 4 GiB\n");
+			return ERR_FAILED_TO_WRITE_FILE;
+		}
+		return ALL_OK;
+	}
+
+	ERet IncrementalClumpImageWriter::AppendImage( const Clump& _clump, AStreamWriter &_stream )
+	{
+		LIPInfoGatherer	lip;
+		GatherClumpChunks( _clump, lip );
+
+		// Determine offsets of all memory blocks in the loaded image.
+		const UINT32 alignedDataSize = lip.ResolveChunkOffsets();
+
+		CountingStreamWriter	stream( _stream );
+
+		const bool rewriteFile = this->WillRewriteFile();
+		const UINT64 oldFileSize = rewriteFile ? 0 : m_fileSize;
+
+		if( rewriteFile )
+		{
+			IncrementalImageHeader	header;
+			mxZERO_OUT( header );
+			header.fourCC = INCREMENTAL_IMAGE_FOURCC;
+			header.version = INCREMENTAL_IMAGE_VERSION;
+			header.classId = mxCLASS_OF(_clump).GetTypeID();
+			header.session = PtSessionInfo::CURRENT;
+			mxDO(stream.Put( header ));
+		}
+
+		// Index the memory blocks written by the previous save.
+		TPointerMap< SavedChunk, mxPointerHasher >	previousChunks;
+		if( !rewriteFile )
+		{
+			for( UINT32 i = 0; i < m_savedChunks.Num(); i++ ) {
+				previousChunks.Set( m_savedChunks[i].data, m_savedChunks[i] );
+			}
+		}
+
+		// Append the memory blocks that have been added or modified since the last save.
+		// m_savedChunks is only updated after everything has been written.
+		const UINT32 numChunks = lip.chunks.Num();
+		TArray< SavedChunk >	savedChunks;
+		mxDO(savedChunks.SetNum( numChunks ));
+
+		UINT64 liveBytes = sizeof(IncrementalImageHeader);
+		UINT32 numModifiedChunks = 0;
+
+		for( UINT32 iChunk = 0; iChunk < numChunks; iChunk++ )
+		{
+			const SChunk& chunk = lip.chunks[ iChunk ];
+			SavedChunk &savedChunk = savedChunks[ iChunk ];
+			savedChunk.data = chunk.data;
+			savedChunk.size = chunk.size;
+			savedChunk.hash = ContentHash64( chunk.data, chunk.size );
+
+			const SavedChunk* previous = previousChunks.Find( chunk.data );
+			if( previous && previous->size == chunk.size && previous->hash == savedChunk.hash )
+			{
+				savedChunk.fileOffset = previous->fileOffset;
+			}
+			else
+			{
+				const UINT64 fileOffset = oldFileSize + stream.m_bytesWritten;
+				mxDO(CheckIncrementalImageSize( fileOffset + chunk.size ));
+				savedChunk.fileOffset = (UINT32) fileOffset;
+				mxDO(stream.Write( chunk.data, chunk.size ));
+				numModifiedChunks++;
+			}
+			liveBytes += chunk.size;
+		}
+
+		// Append the new layout.
+		const UINT64 layoutOffset = oldFileSize + stream.m_bytesWritten;
+		mxDO(CheckIncrementalImageSize( layoutOffset ));
+		mxDO(stream.Put( alignedDataSize ));
+		mxDO(stream.Put( numChunks ));
+		for( UINT32 iChunk = 0; iChunk < numChunks; iChunk++ )
+		{
+			SChunkLocation	location;
+			location.payloadOffset = lip.chunks[ iChunk ].offset;
+			location.fileOffset = savedChunks[ iChunk ].fileOffset;
+			location.size = savedChunks[ iChunk ].size;
+			mxDO(stream.Put( location ));
+		}
+
+		// Append relocation tables.
+		mxDO(lip.WriteFixUpTables( stream, lip.ComputePayloadChecksum() ));
+
+		IncrementalImageFooter	footer;
+		footer.layoutOffset = (UINT32) layoutOffset;
+		footer.fourCC = INCREMENTAL_IMAGE_FOURCC;
+		mxDO(stream.Put( footer ));
+
+		mxDO(stream.m_status);
+		const UINT64 newFileSize = oldFileSize + stream.m_bytesWritten;
+		mxDO(CheckIncrementalImageSize( newFileSize ));
+
+		// Everything has been written, remember the new file contents.
+		mxDO(m_savedChunks.SetNum( numChunks ));
+		if( numChunks ) {
+			memcpy( m_savedChunks.ToPtr(), savedChunks.ToPtr(), numChunks * sizeof(SavedChunk) );
+		}
+		m_fileSize = newFileSize;
+		liveBytes += newFileSize - layoutOffset;
+
+		// Schedule compaction if the file contains too much stale data.
+		const UINT64 staleBytes = newFileSize - liveBytes;
+		m_compactNext = staleBytes * 100 > (UINT64)compactionThreshold * newFileSize;
+
+		DBG_MSG("WRITE: Incremental clump image: %u of %u chunks modified, file size: %u, stale: %u",
+			numModifiedChunks, numChunks, (UINT32)newFileSize, (UINT32)staleBytes);
+
+		return ALL_OK;
+	}
+
+	static ERet ParseIncrementalClumpImage( const void* _fileData, UINT32 _fileSize, UINT32 &_layoutOffset, UINT32 &_payload )
+	{
+		chkRET_X_IF_NOT(_fileSize >= sizeof(IncrementalImageHeader) + sizeof(IncrementalImageFooter), ERR_FAILED_TO_PARSE_DATA);
+
+		const IncrementalImageHeader& header = *static_cast< const IncrementalImageHeader* >( _fileData );
+		chkRET_X_IF_NOT(header.fourCC == INCREMENTAL_IMAGE_FOURCC, ERR_FAILED_TO_PARSE_DATA);
+		if( header.version != INCREMENTAL_IMAGE_VERSION ) {
+			ptWARN("Incompatible incremental image version: %u (expected %u)\n", header.version, INCREMENTAL_IMAGE_VERSION);
+			return ERR_INCOMPATIBLE_VERSION;
+		}
+		mxDO(PtSessionInfo::ValidateSession(header.session));
+		chkRET_X_IF_NOT(header.classId == Clump::MetaClass().GetTypeID(), ERR_OBJECT_OF_WRONG_TYPE);
+
+		const UINT32 footerOffset = _fileSize - sizeof(IncrementalImageFooter);
+		const IncrementalImageFooter& footer = *(const IncrementalImageFooter*) mxAddByteOffset( c_cast(void*)_fileData, footerOffset );
+		chkRET_X_IF_NOT(footer.fourCC == INCREMENTAL_IMAGE_FOURCC, ERR_FAILED_TO_PARSE_DATA);
+		chkRET_X_IF_NOT(footer.layoutOffset >= sizeof(IncrementalImageHeader), ERR_FAILED_TO_PARSE_DATA);
+		chkRET_X_IF_NOT(footer.layoutOffset + sizeof(UINT32) * 2 <= footerOffset, ERR_FAILED_TO_PARSE_DATA);
+
+		_layoutOffset = footer.layoutOffset;
+		_payload = *(const UINT32*) mxAddByteOffset( c_cast(void*)_fileData, footer.layoutOffset );
+		return ALL_OK;
+	}
+
+	ERet GetIncrementalClumpImageSize( const void* _fileData, UINT32 _fileSize, UINT32 &_payload )
+	{
+		UINT32 layoutOffset;
+		mxDO(ParseIncrementalClumpImage( _fileData, _fileSize, layoutOffset, _payload ));
+		return ALL_OK;
+	}
+
+	ERet LoadIncrementalClumpImage( const void* _fileData, UINT32 _fileSize, void *_buffer, UINT32 _bufferSize, ELoadMode _mode )
+	{
+		UINT32 layoutOffset;
+		UINT32 payload;
+		mxDO(ParseIncrementalClumpImage( _fileData, _fileSize, layoutOffset, payload ));
+
+		chkRET_X_IF_NOT(payload >= sizeof(Clump), ERR_FAILED_TO_PARSE_DATA);
+		chkRET_X_IF_NOT(_bufferSize >= payload, ERR_BUFFER_TOO_SMALL);
+		chkRET_X_IF_NOT(IsAlignedBy(_buffer, EFFICIENT_ALIGNMENT), ERR_INVALID_ALIGNMENT);
+
+		const UINT32 tablesSize = _fileSize - sizeof(IncrementalImageFooter) - layoutOffset;
+		MemoryReader	reader( mxAddByteOffset( c_cast(void*)_fileData, layoutOffset ), tablesSize );
+
+		UINT32 numChunks;
+		mxDO(reader.Get( payload ));
+		mxDO(reader.Get( numChunks ));
+
+		// Assemble the memory image from the blocks scattered across the file.
+		UINT32 currentOffset = 0;
+		for( UINT32 iChunk = 0; iChunk < numChunks; iChunk++ )
+		{
+			SChunkLocation	location;
+			mxDO(reader.Get( location ));
+
+			// the blocks are sorted by their offsets in the image
+			if( location.payloadOffset < currentOffset
+				|| (UINT64)location.payloadOffset + location.size > payload
+				|| (UINT64)location.fileOffset + location.size > layoutOffset )
+			{
+				ptWARN("Bad memory block %u in incremental image\n", iChunk);
+				return ERR_FAILED_TO_PARSE_DATA;
+			}
+
+			// the gaps are not stored in the file, they are hashed as zeros
+			memset( mxAddByteOffset( _buffer, currentOffset ), 0, location.payloadOffset - currentOffset );
+			memcpy( mxAddByteOffset( _buffer, location.payloadOffset ), mxAddByteOffset( c_cast(void*)_fileData, location.fileOffset ), location.size );
+			currentOffset = location.payloadOffset + location.size;
+		}
+		memset( mxAddByteOffset( _buffer, currentOffset ), 0, payload - currentOffset );
+
+		mxDO(FixupLoadedClump( _buffer, payload, reader, _mode ));
+
+		return ALL_OK;
+	}
+
 }//namespace Serialization
 
+// AssetID is a core type, so the reflection module relies on these helpers
+namespace Reflection
+{
+	void CopyAssetID( AssetID * _dst, const AssetID& _src, bool _isConstructed )
+	{
+		if( _isConstructed ) {
+			*_dst = _src;
+		} else {
+			new(_dst) AssetID( _src );
+		}
+	}
+
+	const char* GetAssetIDName( const AssetID& _assetId )
+	{
+		return AssetId_IsValid( _assetId ) ? _assetId.d.ToPtr() : "";
+	}
+}//namespace Reflection
+
 //--------------------------------------------------------------//
 //				End Of File.									//
 //--------------------------------------------------------------//
@@ -13,13 +13,17 @@ namespace Serialization
 {
 
 #pragma pack (push,1)
+	// NOTE: the version is stored first, so that readers of older formats fail the session check.
 	struct ImageHeader
 	{
+		UINT32			fourCC;		// 4 IMAGE_FOURCC
+		UINT32			version;	// 4 IMAGE_VERSION
 		PtSessionInfo	session;	// 8 platform/engine info
 		TypeID			classId;	// 4 type of stored object
 		UINT32			payload;	// 4 size of stored data
+		UINT32			_unused[2];	// 8 padding to align data to 16 bytes
 	};
-	ASSERT_SIZEOF(ImageHeader, 16);
+	ASSERT_SIZEOF(ImageHeader, 32);
 
 	struct BinaryHeader
 	{
@@ -30,6 +34,20 @@ namespace Serialization
 	ASSERT_SIZEOF(BinaryHeader, 16);
 #pragma pack (pop)
 
+	// Controls how much the loader trusts the serialized memory image.
+	enum ELoadMode
+	{
+		// The image comes from our own cooked data:
+		// relocation tables are applied as-is, without any checks.
+		LoadMode_Trusted,
+
+		// The image comes from an untrusted source (e.g. mod content):
+		// every relocation is bounds-checked, pointer targets are checked
+		// against the alignment of the pointee type
+		// and the checksum (CRC32C) of the payload is verified.
+		LoadMode_Validated,
+	};
+
 	//
 	// Memory image dump based on reflection metadata:
 	// serializes into native memory layout for in-place loading (LIP).
@@ -40,17 +58,19 @@ namespace Serialization
 	ERet SaveImage( const void* o, const mxClass& type, AStreamWriter& stream );
 	ERet SaveImage( const Clump& clump, AStreamWriter& stream );
 
-	ERet LoadImage( AStreamReader& stream, const mxClass& type, ByteArrayT &buffer );
+	ERet LoadImage( AStreamReader& stream, const mxClass& type, ByteArrayT &buffer, ELoadMode mode = LoadMode_Trusted );
 
-	mxDEPRECATED
-	// assumes that the buffer starts with an ImageHeader
-	ERet LoadInPlace( const mxClass& type, void* buffer, UINT32 length, void *&o );
+	// assumes that the buffer starts with an ImageHeader;
+	// the image is fixed up where it lies, so the buffer must be writable
+	// (e.g. a copy-on-write file mapping)
+	ERet LoadInPlace( const mxClass& type, void* buffer, UINT32 length, void *&o, ELoadMode mode = LoadMode_Trusted );
 
 	// parses the stream and loads the object data into the user-supplied buffer
 	ERet LoadInPlace(
 		const mxClass& type, const ImageHeader& header,
 		void * buffer, UINT32 length,
-		AStreamReader& stream
+		AStreamReader& stream,
+		ELoadMode mode = LoadMode_Trusted
 	);
 
 	// assumes that the buffer starts with an ImageHeader
@@ -58,9 +78,9 @@ namespace Serialization
 	//ERet FixupBufferWithHeader( void* buffer, UINT32 length );
 
 	template< typename CLASS >
-	ERet LoadInPlace( void* buffer, UINT32 length, CLASS *&o ) {
+	ERet LoadInPlace( void* buffer, UINT32 length, CLASS *&o, ELoadMode mode = LoadMode_Trusted ) {
 		void* voidPtr = NULL;
-		mxDO(LoadInPlace( CLASS::MetaClass(), buffer, length, voidPtr ));
+		mxDO(LoadInPlace( CLASS::MetaClass(), buffer, length, voidPtr, mode ));
 		o = static_cast< CLASS* >( voidPtr );
 		return ALL_OK;
 	}
@@ -87,12 +107,85 @@ namespace Serialization
 	ERet SaveBinaryToFile( const void* o, const mxClass& type, const char* file );
 	ERet LoadBinaryFromFile( const char* file, const mxClass& type, void *o );
 
+	// checks the format version of the image (e.g. before calling LoadClumpImage())
+	ERet ValidateImageVersion( const ImageHeader& header );
+
 	ERet SaveClumpImage( const Clump& _clump, AStreamWriter &_stream );
-	ERet LoadClumpImage( AStreamReader& _stream, UINT32 _payload, void *_buffer );
+	ERet LoadClumpImage( AStreamReader& _stream, UINT32 _payload, void *_buffer, ELoadMode _mode = LoadMode_Trusted );
+
+	//
+	// Incremental clump image: re-saving appends only modified memory blocks
+	// and new relocation tables to the end of the file.
+	// NOTE: the file is loaded by copying blocks into a contiguous buffer.
+	//
+	class IncrementalClumpImageWriter
+	{
+	public:
+		IncrementalClumpImageWriter();
+		~IncrementalClumpImageWriter();
+
+		// If true, the next Save() will write the whole file from scratch
+		// and the stream must be empty (e.g. the file must be truncated);
+		// this is also the case after a failed Save(), because the file may end with a partially written image;
+		// otherwise, the stream must be positioned at the end of the previously saved file.
+		bool WillRewriteFile() const;
+
+		ERet Save( const Clump& _clump, AStreamWriter &_stream );
+
+		// forgets the previously saved file, the next Save() will do a full rewrite
+		void Reset();
+
+	public:
+		// the file is compacted (fully rewritten) when stale data exceeds this percentage of the file size
+		UINT32	compactionThreshold;
+
+	private:
+		ERet AppendImage( const Clump& _clump, AStreamWriter &_stream );
+
+	private:
+		struct SavedChunk
+		{
+			const void *	data;		// start of the memory block
+			UINT32			size;		// size of the memory block
+			UINT32			fileOffset;	// where the block is stored in the file
+			UINT64			hash;		// hash of the block's contents
+		};
+		TArray< SavedChunk >	m_savedChunks;	// memory blocks written by the last Save()
+		UINT64					m_fileSize;		// total size of the file, 0 if nothing has been written
+		bool					m_compactNext;
+	};
+
+	// _fileData - contents of the whole file
+	ERet GetIncrementalClumpImageSize( const void* _fileData, UINT32 _fileSize, UINT32 &_payload );
+	ERet LoadIncrementalClumpImage( const void* _fileData, UINT32 _fileSize, void *_buffer, UINT32 _bufferSize, ELoadMode _mode = LoadMode_Trusted );
 
 	ERet SaveClumpBinary( const Clump& _clump, AStreamWriter &_stream );
 	ERet LoadClumpBinary( AStreamReader& _stream, Clump& _clump );
 
+	// counts the number of written bytes,
+	// remembers the first failure and refuses to write after it
+	class CountingStreamWriter : public AStreamWriter
+	{
+		AStreamWriter &	m_stream;
+	public:
+		UINT64			m_bytesWritten;
+		ERet			m_status;
+	public:
+		CountingStreamWriter( AStreamWriter &_stream )
+			: m_stream( _stream ), m_bytesWritten( 0 ), m_status( ALL_OK )
+		{}
+		virtual ERet Write( const void* _buffer, size_t _size ) override
+		{
+			if( m_status == ALL_OK ) {
+				m_status = m_stream.Write( _buffer, _size );
+				if( m_status == ALL_OK ) {
+					m_bytesWritten += _size;
+				}
+			}
+			return m_status;
+		}
+	};
+
 }//namespace Serialization
 
 //--------------------------------------------------------------//
@@ -0,0 +1,285 @@
+/*
+=============================================================================
+	File:	JsonLines.cpp
+	Desc:	JSON Lines (one object per line) export/import of object lists.
+	Note:	the reader processes the input in batches: complete lines are split
+			on the calling thread (which creates object lists and allocates objects
+			in the order of the file) and then decoded on the shared worker pool
+			(asset ids and user pointers are set on the calling thread afterwards);
+			the incomplete line at the end of the batch is moved to the start of the buffer.
+=============================================================================
+*/
+#include <Base/Base.h>
+
+#include <atomic>
+#include <thread>
+
+#include <Base/Object/WorkerPool.h>
+#include "JsonSupportInternal.h"
+#include "JsonLines.h"
+
+enum
+{
+	JSONL_BATCH_SIZE = 1 * mxMEGABYTE,	// the buffer grows only if a line is longer
+	JSONL_MAX_THREADS = Reflection::MAX_WORKERS,
+	JSONL_LINES_PER_TASK = 64,	// lines decoded by a worker at once
+};
+
+// an allocated object and its text
+struct JsonLine
+{
+	const char *	text;	// null-terminated
+	UINT32			length;
+	int				line;	// for diagnostics
+	CStruct *		o;
+	const mxClass *	type;
+};
+
+struct JsonLinesTask
+{
+	const JsonLine *		lines;
+	UINT32					numLines;
+	const char *			file;
+	std::atomic< UINT32 >	nextLine;
+	ERet					results[ JSONL_MAX_THREADS ];	// per worker
+	JsonDeferredValues *	deferredValues;	// per worker
+};
+
+static void DecodeLines( JsonLinesTask & _task, UINT32 _workerIndex )
+{
+	ERet result = ALL_OK;
+	for(;;)
+	{
+		const UINT32 begin = _task.nextLine.fetch_add( JSONL_LINES_PER_TASK );
+		if( begin >= _task.numLines ) {
+			break;
+		}
+		const UINT32 end = smallest( begin + JSONL_LINES_PER_TASK, _task.numLines );
+		for( UINT32 iLine = begin; iLine < end; iLine++ )
+		{
+			const JsonLine& line = _task.lines[ iLine ];
+
+			// call the default constructor
+			line.type->ConstructInPlace( line.o );
+
+			JsonStreamDecoder	decoder( line.text, line.length, _task.file, line.line );
+			decoder.SetDeferredValues( &_task.deferredValues[ _workerIndex ] );
+			const ERet lineResult = decoder.DecodeObject( line.o, *line.type );
+			if( result == ALL_OK ) {
+				result = lineResult;
+			}
+		}
+	}
+	_task.results[ _workerIndex ] = result;
+}
+
+// the calling thread is the first worker,
+// asset ids and user pointers are set on the calling thread after decoding
+static ERet DecodeLinesInParallel( const JsonLine* _lines, UINT32 _numLines, const char* _file, JsonDeferredValues* _deferredValues )
+{
+	JsonLinesTask	task;
+	task.lines = _lines;
+	task.numLines = _numLines;
+	task.file = _file;
+	task.nextLine.store( 0 );
+	task.deferredValues = _deferredValues;
+
+	UINT32 numWorkers = largest( std::thread::hardware_concurrency(), 1U );
+	numWorkers = smallest( numWorkers, (_numLines + JSONL_LINES_PER_TASK - 1) / JSONL_LINES_PER_TASK );
+	numWorkers = smallest( numWorkers, (UINT32)JSONL_MAX_THREADS );
+	numWorkers = largest( numWorkers, 1U );
+
+	// the other workers run on the shared pool
+	Reflection::RunOnWorkers( &DecodeLines, task, numWorkers );
+
+	ERet result = ALL_OK;
+	for( UINT32 i = 0; i < numWorkers; i++ )
+	{
+		_deferredValues[i].Resolve();
+		if( result == ALL_OK ) {
+			result = task.results[i];
+		}
+	}
+	return result;
+}
+
+// header lines are rare, so they are parsed with Jansson
+static ERet ReadListHeader( const char* _text, const char* _file, int _line, const mxClass *&_type, UINT32 &_count )
+{
+	json_error_t error;
+	json_t* root = json_loads( _text, 0, &error );
+	if( !root ) {
+		ptERROR("%s(%d,%d): parse error: %s\n", _file, _line, error.column, error.text);
+		return ERR_FAILED_TO_PARSE_DATA;
+	}
+
+	const char* typeName = json_string_value( json_object_get( root, OBJECT_CLASS_TAG ) );
+	_type = typeName ? TypeRegistry::Get().FindClassByName( typeName ) : nil;
+
+	json_int_t count = 0;
+	const bool isValid = _type && JSON_Find_Integer_Value( root, OBJECT_COUNT_TAG, count ) && count > 0;
+
+	if( !isValid ) {
+		ptERROR("%s(%d): invalid object list header (class: '%s')\n", _file, _line, typeName ? typeName : "");
+	}
+	json_decref( root );
+
+	_count = (UINT32) count;
+	return isValid ? ALL_OK : ERR_FAILED_TO_PARSE_DATA;
+}
+
+ERet JSON_WriteLines( const Clump& clump, AStreamWriter &stream )
+{
+	JSON::SaveOptions	options;
+	options.compact = true;
+
+	JsonStreamEncoder	encoder( stream, options );
+
+	ObjectList::Iterator it( clump.GetObjectLists() );
+	while( it.IsValid() )
+	{
+		const ObjectList& objectList = it.Value();
+		if( objectList.Num() > 0 )
+		{
+			const mxClass& type = objectList.GetType();
+
+			char header[ 256 ];
+			const int headerLength = snprintf( header, sizeof(header), "{\"%s\":\"%s\",\"%s\":%u}\n",
+				OBJECT_CLASS_TAG, type.GetTypeName(), OBJECT_COUNT_TAG, objectList.Num() );
+			mxASSERT(headerLength > 0 && headerLength < (int)sizeof(header));
+			encoder.WriteRaw( header, headerLength );
+
+			ObjectList::IteratorBase	itemIterator( objectList );
+			while( itemIterator.IsValid() )
+			{
+				encoder.EncodeLine( itemIterator.ToVoidPtr(), type );
+				itemIterator.MoveToNext();
+			}
+		}
+		it.MoveToNext();
+	}
+
+	return encoder.Flush();
+}
+
+ERet JSON_ReadLines( AStreamReader &stream, Clump &clump, const char* file )
+{
+	// +1 for the null after the last line
+	TArray< char >	buffer;
+	mxDO(buffer.SetNum( JSONL_BATCH_SIZE + 1 ));
+
+	TArray< JsonLine >	lines;
+	JsonDeferredValues	deferredValues[ JSONL_MAX_THREADS ];	// per worker, reused for all batches
+
+	ObjectList *	objectList = nil;
+	UINT32			remainingObjects = 0;	// in the current list
+	int				lineNumber = 1;
+
+	size_t	unreadBytes = stream.GetSize();
+	UINT32	used = 0;	// the beginning of an incomplete line from the previous batch
+
+	while( unreadBytes || used )
+	{
+		// the buffer is full, but doesn't contain a complete line
+		if( used == buffer.Num() - 1 ) {
+			mxDO(buffer.SetNum( buffer.Num() * 2 ));
+		}
+
+		const UINT32 bytesToRead = (UINT32) smallest( (size_t)(buffer.Num() - 1 - used), unreadBytes );
+		mxDO(stream.Read( buffer.ToPtr() + used, bytesToRead ));
+		used += bytesToRead;
+		unreadBytes -= bytesToRead;
+
+		char* text = buffer.ToPtr();
+
+		// complete lines end with the last newline (or with the end of the stream)
+		UINT32 completeLength = used;
+		if( unreadBytes )
+		{
+			while( completeLength > 0 && text[ completeLength - 1 ] != '\n' ) {
+				completeLength--;
+			}
+			if( !completeLength ) {
+				continue;
+			}
+		}
+		else
+		{
+			text[ used ] = '\0';
+		}
+
+		// object lists must be created and objects allocated in the order of the file
+		ERet result = ALL_OK;
+		char* lineStart = text;
+		char* const end = text + completeLength;
+		while( lineStart < end )
+		{
+			char* lineEnd = (char*) memchr( lineStart, '\n', end - lineStart );
+			if( !lineEnd ) {
+				lineEnd = end;
+			}
+			*lineEnd = '\0';
+
+			const char* p = lineStart;
+			while( *p == ' ' || *p == '\t' || *p == '\r' ) {
+				p++;
+			}
+
+			if( p[0] == '{' && p[1] == '"' && p[2] == '$' )
+			{
+				const mxClass* type;
+				UINT32 count;
+				result = ReadListHeader( p, file, lineNumber, type, count );
+				if( result != ALL_OK ) {
+					break;
+				}
+
+				objectList = clump.CreateObjectList( *type, count );
+				if( !objectList ) {
+					result = ERR_OUT_OF_MEMORY;
+					break;
+				}
+				remainingObjects = count;
+			}
+			else if( *p )
+			{
+				if( !remainingObjects ) {
+					ptERROR("%s(%d): unexpected object (the list header is missing or the count is too small)\n", file, lineNumber);
+					result = ERR_FAILED_TO_PARSE_DATA;
+					break;
+				}
+				JsonLine& line = lines.Add();
+				line.text = p;
+				line.length = lineEnd - p;
+				line.line = lineNumber;
+				line.o = objectList->Allocate();
+				line.type = &objectList->GetType();
+				remainingObjects--;
+			}
+
+			lineNumber++;
+			lineStart = lineEnd + 1;
+		}
+
+		// the lines point into the buffer, so they are decoded before reading the next batch;
+		// the allocated objects are in the clump and must be constructed even if the batch is invalid
+		if( lines.Num() ) {
+			const ERet decoded = DecodeLinesInParallel( lines.ToPtr(), lines.Num(), file, deferredValues );
+			lines.Empty();
+			if( result == ALL_OK ) {
+				result = decoded;
+			}
+		}
+		mxDO(result);
+
+		// move the incomplete line to the start of the buffer
+		used -= completeLength;
+		memmove( text, text + completeLength, used );
+	}
+
+	return ALL_OK;
+}
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,28 @@
+/*
+=============================================================================
+	File:	JsonLines.h
+	Desc:	JSON Lines (one object per line) export/import of object lists.
+=============================================================================
+*/
+#pragma once
+
+/*
+	Each non-empty object list is written as a header line followed by one line per object:
+
+	{"$CLASS":"Vertex","$COUNT":3}
+	{"x":1.0,"y":2.0}
+	...
+
+	Both the writer and the reader stream the data through fixed-size buffers,
+	so memory usage doesn't depend on the number of objects.
+	The reader splits each buffer at newlines and decodes the lines in parallel.
+	NOTE: pointers are not supported (objects are written with JsonStreamEncoder).
+*/
+ERet JSON_WriteLines( const Clump& clump, AStreamWriter &stream );
+
+//NOTE: doesn't clear the given clump first!
+ERet JSON_ReadLines( AStreamReader &stream, Clump &clump, const char* file = "" );
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,280 @@
+/*
+=============================================================================
+	File:	JsonStructuralIndex.cpp
+	Desc:	Vectorized first stage of the JSON parser.
+	Note:	the text is processed in 64-byte blocks, as in simdjson
+			("Parsing Gigabytes of JSON per Second", Langdale, Lemire):
+			each block is classified into 64-bit masks (one bit per byte),
+			escaped quotes and string contents are found with bitwise arithmetic
+			and the resulting bits are converted into byte offsets.
+			Only the classification depends on the instruction set
+			(AVX2, SSE2 or scalar code).
+=============================================================================
+*/
+#include <Base/Base.h>
+#include "JsonStructuralIndex.h"
+
+#if defined(__AVX2__)
+	#define MX_JSON_SCAN_AVX2	(1)
+	#define MX_JSON_SCAN_SSE2	(0)
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define MX_JSON_SCAN_AVX2	(0)
+	#define MX_JSON_SCAN_SSE2	(1)
+	#include <emmintrin.h>
+#else
+	#define MX_JSON_SCAN_AVX2	(0)
+	#define MX_JSON_SCAN_SSE2	(0)
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace
+{
+
+enum { BLOCK_SIZE = 64 };
+
+// one bit per byte of the block
+struct BlockMasks
+{
+	UINT64	backslash;
+	UINT64	quote;
+	UINT64	structural;	// { } [ ] : ,
+	UINT64	whitespace;
+	UINT64	slash;		// comments are not supported by the index
+};
+
+#if MX_JSON_SCAN_AVX2
+
+static inline UINT64 Mask32( const __m256i& v )
+{
+	return (UINT32) _mm256_movemask_epi8( v );
+}
+
+static void ClassifyBlock( const char* _block, BlockMasks &_masks )
+{
+	const __m256i lo = _mm256_loadu_si256( (const __m256i*) _block );
+	const __m256i hi = _mm256_loadu_si256( (const __m256i*) (_block + 32) );
+
+	// '[' | 0x20 == '{', ']' | 0x20 == '}'
+	const __m256i caseBit = _mm256_set1_epi8( 0x20 );
+	const __m256i lo20 = _mm256_or_si256( lo, caseBit );
+	const __m256i hi20 = _mm256_or_si256( hi, caseBit );
+
+#define CMP_EQ( V, C )	_mm256_cmpeq_epi8( V, _mm256_set1_epi8( C ) )
+#define MASK64( EXPR_LO, EXPR_HI )	( Mask32( EXPR_LO ) | (Mask32( EXPR_HI ) << 32) )
+
+	_masks.backslash = MASK64( CMP_EQ( lo, '\\' ), CMP_EQ( hi, '\\' ) );
+	_masks.quote = MASK64( CMP_EQ( lo, '"' ), CMP_EQ( hi, '"' ) );
+	_masks.slash = MASK64( CMP_EQ( lo, '/' ), CMP_EQ( hi, '/' ) );
+	_masks.structural = MASK64(
+		_mm256_or_si256( _mm256_or_si256( CMP_EQ( lo20, '{' ), CMP_EQ( lo20, '}' ) ), _mm256_or_si256( CMP_EQ( lo, ':' ), CMP_EQ( lo, ',' ) ) ),
+		_mm256_or_si256( _mm256_or_si256( CMP_EQ( hi20, '{' ), CMP_EQ( hi20, '}' ) ), _mm256_or_si256( CMP_EQ( hi, ':' ), CMP_EQ( hi, ',' ) ) )
+		);
+	_masks.whitespace = MASK64(
+		_mm256_or_si256( _mm256_or_si256( CMP_EQ( lo, ' ' ), CMP_EQ( lo, '\t' ) ), _mm256_or_si256( CMP_EQ( lo, '\n' ), CMP_EQ( lo, '\r' ) ) ),
+		_mm256_or_si256( _mm256_or_si256( CMP_EQ( hi, ' ' ), CMP_EQ( hi, '\t' ) ), _mm256_or_si256( CMP_EQ( hi, '\n' ), CMP_EQ( hi, '\r' ) ) )
+		);
+
+#undef MASK64
+#undef CMP_EQ
+}
+
+#elif MX_JSON_SCAN_SSE2
+
+static void ClassifyBlock( const char* _block, BlockMasks &_masks )
+{
+	const __m128i caseBit = _mm_set1_epi8( 0x20 );
+
+	_masks.backslash = 0;
+	_masks.quote = 0;
+	_masks.structural = 0;
+	_masks.whitespace = 0;
+	_masks.slash = 0;
+
+#define CMP_EQ( V, C )	_mm_cmpeq_epi8( V, _mm_set1_epi8( C ) )
+#define MASK16( EXPR )	( (UINT64)(UINT32) _mm_movemask_epi8( EXPR ) << shift )
+
+	for( UINT32 i = 0; i < 4; i++ )
+	{
+		const UINT32 shift = i * 16;
+		const __m128i v = _mm_loadu_si128( (const __m128i*) (_block + shift) );
+		// '[' | 0x20 == '{', ']' | 0x20 == '}'
+		const __m128i v20 = _mm_or_si128( v, caseBit );
+
+		_masks.backslash |= MASK16( CMP_EQ( v, '\\' ) );
+		_masks.quote |= MASK16( CMP_EQ( v, '"' ) );
+		_masks.slash |= MASK16( CMP_EQ( v, '/' ) );
+		_masks.structural |= MASK16( _mm_or_si128(
+			_mm_or_si128( CMP_EQ( v20, '{' ), CMP_EQ( v20, '}' ) ),
+			_mm_or_si128( CMP_EQ( v, ':' ), CMP_EQ( v, ',' ) )
+			) );
+		_masks.whitespace |= MASK16( _mm_or_si128(
+			_mm_or_si128( CMP_EQ( v, ' ' ), CMP_EQ( v, '\t' ) ),
+			_mm_or_si128( CMP_EQ( v, '\n' ), CMP_EQ( v, '\r' ) )
+			) );
+	}
+
+#undef MASK16
+#undef CMP_EQ
+}
+
+#else
+
+enum ECharClass
+{
+	Char_Other = 0,
+	Char_Backslash,
+	Char_Quote,
+	Char_Structural,
+	Char_Whitespace,
+	Char_Slash,
+};
+
+static UINT8 GetCharClass( char c )
+{
+	switch( c )
+	{
+	case '\\' :	return Char_Backslash;
+	case '"' :	return Char_Quote;
+	case '/' :	return Char_Slash;
+	case '{' : case '}' : case '[' : case ']' : case ':' : case ',' :
+		return Char_Structural;
+	case ' ' : case '\t' : case '\n' : case '\r' :
+		return Char_Whitespace;
+	}
+	return Char_Other;
+}
+
+static void ClassifyBlock( const char* _block, BlockMasks &_masks )
+{
+	UINT64 masks[6] = { 0 };
+	for( UINT32 i = 0; i < BLOCK_SIZE; i++ ) {
+		masks[ GetCharClass( _block[i] ) ] |= UINT64(1) << i;
+	}
+	_masks.backslash = masks[ Char_Backslash ];
+	_masks.quote = masks[ Char_Quote ];
+	_masks.structural = masks[ Char_Structural ];
+	_masks.whitespace = masks[ Char_Whitespace ];
+	_masks.slash = masks[ Char_Slash ];
+}
+
+#endif
+
+// returns the bits of characters which are preceded by an odd number of backslashes
+static inline UINT64 FindEscapedCharacters( UINT64 _backslash, UINT64 &_prevEndsWithOddBackslash )
+{
+	const UINT64 evenBits = 0x5555555555555555ULL;
+	const UINT64 oddBits = ~evenBits;
+
+	const UINT64 startEdges = _backslash & ~(_backslash << 1);
+	// flip the lowest bit if the previous block ended with an odd-length sequence
+	const UINT64 evenStartMask = evenBits ^ _prevEndsWithOddBackslash;
+	const UINT64 evenStarts = startEdges & evenStartMask;
+	const UINT64 oddStarts = startEdges & ~evenStartMask;
+	const UINT64 evenCarries = _backslash + evenStarts;
+
+	UINT64 oddCarries = _backslash + oddStarts;
+	const bool endsWithOddBackslash = (oddCarries < _backslash);	// overflow
+	oddCarries |= _prevEndsWithOddBackslash;
+	_prevEndsWithOddBackslash = endsWithOddBackslash ? 1 : 0;
+
+	const UINT64 evenCarryEnds = evenCarries & ~_backslash;
+	const UINT64 oddCarryEnds = oddCarries & ~_backslash;
+	const UINT64 evenStartOddEnd = evenCarryEnds & oddBits;
+	const UINT64 oddStartEvenEnd = oddCarryEnds & evenBits;
+	return evenStartOddEnd | oddStartEvenEnd;
+}
+
+// each bit becomes the XOR of all lower bits (including itself)
+static inline UINT64 PrefixXor( UINT64 x )
+{
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	return x;
+}
+
+static inline UINT32 CountTrailingZeros( UINT64 x )
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64( &index, x );
+	return index;
+#else
+	return __builtin_ctzll( x );
+#endif
+}
+
+}//namespace
+
+bool JSON_BuildStructuralIndex( const char* _text, UINT32 _length, TArray< UINT32 > &_tokens )
+{
+	UINT64 prevEndsWithOddBackslash = 0;
+	UINT64 prevInString = 0;	// all ones if the previous block ended inside a string
+	UINT64 prevScalar = 0;		// 1 if the previous block ended with a number or a literal
+
+	UINT32 numTokens = 0;
+	_tokens.Empty();
+
+	for( UINT32 blockStart = 0; blockStart < _length; blockStart += BLOCK_SIZE )
+	{
+		BlockMasks	masks;
+		if( blockStart + BLOCK_SIZE <= _length ) {
+			ClassifyBlock( _text + blockStart, masks );
+		} else {
+			// the last block is padded with spaces
+			char lastBlock[ BLOCK_SIZE ];
+			memset( lastBlock, ' ', sizeof(lastBlock) );
+			memcpy( lastBlock, _text + blockStart, _length - blockStart );
+			ClassifyBlock( lastBlock, masks );
+		}
+
+		const UINT64 escaped = FindEscapedCharacters( masks.backslash, prevEndsWithOddBackslash );
+		const UINT64 quotes = masks.quote & ~escaped;
+
+		// the opening quotes and the contents of strings (but not the closing quotes)
+		const UINT64 inString = PrefixXor( quotes ) ^ prevInString;
+		prevInString = (UINT64)( (INT64)inString >> 63 );
+
+		const UINT64 outsideStrings = ~(inString | quotes);
+		if( masks.slash & outsideStrings ) {
+			return false;	// a comment
+		}
+
+		const UINT64 structural = masks.structural & outsideStrings;
+		const UINT64 scalar = ~(masks.structural | masks.whitespace) & outsideStrings;
+		const UINT64 scalarStarts = scalar & ~((scalar << 1) | prevScalar);
+		prevScalar = scalar >> 63;
+
+		UINT64 bits = structural | quotes | scalarStarts;
+
+		// reserve space for the worst case
+		if( numTokens + BLOCK_SIZE > _tokens.Num() ) {
+			const UINT32 newSize = largest( numTokens + BLOCK_SIZE, _tokens.Num() * 2 );
+			if( _tokens.SetNum( newSize ) != ALL_OK ) {
+				return false;
+			}
+		}
+		UINT32* tokens = _tokens.ToPtr();
+		while( bits )
+		{
+			tokens[ numTokens++ ] = blockStart + CountTrailingZeros( bits );
+			bits &= bits - 1;
+		}
+	}
+
+	_tokens.SetNum( numTokens );
+
+	// an unterminated string
+	return prevInString == 0;
+}
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
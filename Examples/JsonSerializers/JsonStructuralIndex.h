@@ -0,0 +1,33 @@
+/*
+=============================================================================
+	File:	JsonStructuralIndex.h
+	Desc:	Vectorized first stage of the JSON parser:
+			finds the positions of all tokens in the text.
+=============================================================================
+*/
+#pragma once
+
+/*
+	The index contains byte offsets (in ascending order) of:
+	- structural characters outside strings: { } [ ] : ,
+	- quotes delimiting strings (both opening and closing ones),
+	- the first characters of numbers and literals (true, false, null).
+	Whitespace and the contents of strings are never referenced,
+	so the parser can jump from one token to the next one
+	and can find the end of a string without looking at its characters.
+
+	Returns false if the index cannot be used (the text contains comments
+	or an unterminated string), the text must then be parsed byte by byte.
+	NOTE: the index doesn't validate the text, it only finds the tokens.
+	NOTE: the whole index is built up front and takes 4 bytes per token,
+	i.e. up to 4 times the size of the text for dense input (e.g. "[1,2,3]"),
+	plus up to 2x slack because the array grows by doubling.
+	Typical documents (indented, with longer strings and numbers)
+	have one token per 4-8 bytes, so the index is about as large as the text.
+	The index is freed as soon as the text has been parsed.
+*/
+bool JSON_BuildStructuralIndex( const char* _text, UINT32 _length, TArray< UINT32 > &_tokens );
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
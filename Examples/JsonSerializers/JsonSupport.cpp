@@ -9,6 +9,7 @@
 
 #include "JsonSupport.h"
 #include "JsonSupportInternal.h"
+#include "JsonLines.h"
 
 #if 0
 /* swap 32 bits integers */
@@ -49,21 +50,36 @@ namespace JSON
 		}
 	}
 
-	ERet WriteToStream( const void* o, const mxType& type, AStreamWriter &stream )
+	ERet WriteToStream( const void* o, const mxType& type, AStreamWriter &stream, const SaveOptions& options )
 	{
-		Scope	scope;
-		scope.root = JSON_EncodeObject( o, type );
-		chkRET_X_IF_NIL(scope.root, ERR_UNKNOWN_ERROR);
-		chkRET_X_IF_NOT(JSON_WriteToStream( scope.root, stream ), ERR_FAILED_TO_WRITE_FILE);
-		return IM_OK;
+		// write straight into the stream, without creating a DOM
+		return JSON_EncodeStream( o, type, stream, options );
 	}
 	ERet LoadFromStream( AStreamReader& stream, void *o, const mxType& type, const char* name, int line )
 	{
-		Scope	scope;
-		scope.root = JSON_ParseStream( stream, name, line );
-		chkRET_X_IF_NIL(scope.root, ERR_FAILED_TO_PARSE_DATA);
-		JSON_DecodeObject( scope.root, type, o );
-		return IM_OK;
+		// parse straight into the object, without creating a DOM
+		return JSON_DecodeStream( stream, o, type, name, line );
+	}
+	ERet LoadInSitu( char* text, UINT32 length, void *o, const mxType& type, const char* name, int line )
+	{
+		return JSON_DecodeInSitu( text, length, o, type, name, line );
+	}
+	ERet LoadFromFile( const char* file, void *o, const mxType& type )
+	{
+		return JSON_DecodeFile( file, o, type );
+	}
+	ERet LoadInSituFromFile( const char* file, MappedFile &mapping, void *o, const mxType& type )
+	{
+		return JSON_DecodeFileInSitu( file, mapping, o, type );
+	}
+
+	ERet SaveObjectListsAsLines( const Clump& clump, AStreamWriter &stream )
+	{
+		return JSON_WriteLines( clump, stream );
+	}
+	ERet LoadObjectListsFromLines( AStreamReader& stream, Clump & clump, const char* name )
+	{
+		return JSON_ReadLines( stream, clump, name );
 	}
 
 	ERet SaveClumpToFile( const Clump& clump, const char* file )
@@ -84,11 +100,17 @@ namespace JSON
 	}
 	ERet LoadClumpFromFile( const char* file, Clump & clump )
 	{
-		FileReader	stream;
-		mxDO(stream.Open(file, FileRead_NoErrors));
-
-		ClumpLoaderJson	loader( stream );
-		chkRET_X_IF_NOT(loader.LoadClump( clump ), ERR_FAILED_TO_PARSE_DATA);
+		json_t* root = JSON_ParseFile( file );
+		chkRET_X_IF_NIL(root, ERR_FAILED_TO_PARSE_DATA);
+
+		// the loader only borrows the root, destroy it before releasing the DOM
+		bool loaded = false;
+		{
+			ClumpLoaderJson	loader( root );
+			loaded = loader.LoadClump( clump );
+		}
+		json_decref( root );
+		chkRET_X_IF_NOT(loaded, ERR_FAILED_TO_PARSE_DATA);
 
 		return IM_OK;
 	}
@@ -17,10 +17,38 @@
 // we use Jansson
 struct json_t;
 
+class MappedFile;
+
 namespace JSON
 {
-	ERet WriteToStream( const void* o, const mxType& type, AStreamWriter &stream );
+	// the loaders accept both forms of enums and flags
+	struct SaveOptions
+	{
+		bool	compact;			// no indentation and line breaks
+		bool	escapeUnicode;		// non-ASCII characters are written as \uXXXX (otherwise as UTF-8)
+		bool	enumsAsIntegers;	// enums are written as numbers instead of names
+		bool	flagsAsIntegers;	// flags are written as raw bit masks instead of arrays of names
+	public:
+		SaveOptions()
+		{
+			compact = false;
+			escapeUnicode = true;
+			enumsAsIntegers = false;
+			flagsAsIntegers = false;
+		}
+	};
+
+	ERet WriteToStream( const void* o, const mxType& type, AStreamWriter &stream, const SaveOptions& options = SaveOptions() );
 	ERet LoadFromStream( AStreamReader& stream, void *o, const mxType& type, const char* name = "", int line = 1 );
+	// String fields are not copied, they reference the (modified) text,
+	// so the null-terminated text must not be freed while the object is used.
+	ERet LoadInSitu( char* text, UINT32 length, void *o, const mxType& type, const char* name = "", int line = 1 );
+
+	// the file is memory-mapped instead of being read into a heap buffer
+	ERet LoadFromFile( const char* file, void *o, const mxType& type );
+	// String fields reference the copy-on-write mapping of the file (see LoadInSitu()),
+	// the mapping must stay open while the object is used
+	ERet LoadInSituFromFile( const char* file, MappedFile &mapping, void *o, const mxType& type );
 
 	//@todo: error checking
 	template< typename TYPE >
@@ -52,12 +80,15 @@ namespace JSON
 	template< typename TYPE >
 	ERet LoadObjectFromFile( const char* file, TYPE &o )
 	{
-		FileReader	stream;
-		mxDO(stream.Open(file, FileRead_NoErrors));
-		mxDO(LoadFromStream( stream, &o, mxTYPE_OF(o), file ));
-		return ALL_OK;
+		return LoadFromFile( file, &o, mxTYPE_OF(o) );
 	}
 
+	// JSON Lines: a header line per object list, then one line per object (see JsonLines.h);
+	// memory usage doesn't depend on the number of objects
+	ERet SaveObjectListsAsLines( const Clump& clump, AStreamWriter &stream );
+	//NOTE: doesn't clear the given clump first!
+	ERet LoadObjectListsFromLines( AStreamReader& stream, Clump & clump, const char* name = "" );
+
 	ERet SaveClumpToFile( const Clump& clump, const char* file );
 
 	//NOTE: doesn't clear the given clump first!
@@ -1,5 +1,9 @@
 #include <Base/Base.h>
+#include <Base/Object/FieldIndex.h>
+#include <Base/Object/NumberText.h>
+#include <Core/MappedFile.h>
 #include "JsonSupportInternal.h"
+#include "JsonStructuralIndex.h"
 
 static const bool bEnableJsonComments = true;
 
@@ -149,6 +153,11 @@ json_t* Flags_To_JSON( const mxFlagsType& flagsType, const void* flagsObject )
 
 void JSON_To_Flags( const json_t* jsonValue, const mxFlagsType& flagsType, void* flagsObject )
 {
+	// raw bit mask
+	if( json_is_integer( jsonValue ) ) {
+		flagsType.m_accessor.Set_Value( flagsObject, (mxFlagsType::Mask) json_integer_value( jsonValue ) );
+		return;
+	}
 	mxASSERT(json_is_array(jsonValue));
 	const UINT numFlags = json_array_size( jsonValue );
 	mxFlagsType::Mask integerValue = 0;
@@ -161,17 +170,25 @@ void JSON_To_Flags( const json_t* jsonValue, const mxFlagsType& flagsType, void*
 	flagsType.m_accessor.Set_Value( flagsObject, integerValue );
 }
 
+// reads the whole stream and appends a null terminator
+// (the buffer is allocated once, instead of growing it after loading)
+static ERet JSON_LoadText( AStreamReader& stream, ByteBuffer &fileData, UINT32 &fileSize )
+{
+	fileSize = (UINT32) stream.GetSize();
+	mxDO(fileData.SetNum( fileSize + 1 ));
+	mxDO(stream.Read( fileData.ToPtr(), fileSize ));
+	fileData[ fileSize ] = '\0';
+	return ALL_OK;
+}
+
 json_t* JSON_ParseStream( AStreamReader& stream, const char* file, int line )
 {
 	json_error_t error;
 
 	ByteBuffer	fileData;
-	if(mxSUCCEDED(Util_LoadStreamToBlob( stream, fileData )))
+	UINT32		fileSize;
+	if(mxSUCCEDED(JSON_LoadText( stream, fileData, fileSize )))
 	{
-		const UINT fileSize = fileData.GetDataSize();
-		fileData.Reserve( fileSize + 1 );
-		fileData[ fileSize ] = '\0';
-
 		const char* start = c_cast(const char*) fileData.ToPtr();
 		//const char* end = start + fileSize;
 
@@ -187,14 +204,34 @@ json_t* JSON_ParseStream( AStreamReader& stream, const char* file, int line )
 	return nil;
 }
 
+json_t* JSON_ParseFile( const char* file )
+{
+	MappedFile	mapping;
+	if(mxSUCCEDED(mapping.Open( file, FileMap_ReadOnly, FileAccess_Sequential )))
+	{
+		json_error_t error;
+
+		const size_t flags = 0;
+
+		// the mapped text is not null-terminated
+		json_t* root = json_loadb( c_cast(const char*) mapping.GetData(), mapping.GetSize(), flags, &error );
+		if( !root ) {
+			ptERROR("%s(%d,%d): parse error: %s", file, error.line, error.column, error.text );
+			return nil;
+		}
+		return root;
+	}
+	return nil;
+}
+
 extern "C" void jsonp_free(void *ptr);
 
-bool JSON_WriteToStream( const json_t* root, AStreamWriter& stream )
+bool JSON_WriteToStream( const json_t* root, AStreamWriter& stream, const JSON::SaveOptions& options )
 {
 	chkRET_FALSE_IF_NIL( root );
 
-	const size_t flags = JSON_INDENT(4)
-		| JSON_ENSURE_ASCII
+	const size_t flags = (options.compact ? JSON_COMPACT : JSON_INDENT(4))
+		| (options.escapeUnicode ? JSON_ENSURE_ASCII : 0)
 		//| JSON_SORT_KEYS
 		| JSON_PRESERVE_ORDER
 		;
@@ -495,6 +532,406 @@ void* JsonEncoder::Visit_String( String & s, void* _userData )
 	return nil;
 }
 
+/*
+-----------------------------------------------------------------------------
+	JsonStreamEncoder
+-----------------------------------------------------------------------------
+*/
+JsonStreamEncoder::JsonStreamEncoder( AStreamWriter &stream, const JSON::SaveOptions& options )
+	: m_stream( stream )
+	, m_options( options )
+{
+	m_used = 0;
+	m_status = ALL_OK;
+	m_level = 0;
+	m_first = true;
+}
+
+JsonStreamEncoder::~JsonStreamEncoder()
+{
+	mxASSERT2(m_used == 0, "Flush() must be called");
+}
+
+ERet JsonStreamEncoder::EncodeObject( const void* o, const mxType& type )
+{
+	mxASSERT_PTR(o);
+	Reflection::Walker2::Visit( c_cast(void*)o, type, this );
+	return this->Flush();
+}
+
+void JsonStreamEncoder::EncodeLine( const void* o, const mxType& type )
+{
+	mxASSERT_PTR(o);
+	Reflection::Walker2::Visit( c_cast(void*)o, type, this );
+	this->WriteChar( '\n' );
+}
+
+void JsonStreamEncoder::WriteRaw( const char* text, UINT32 length )
+{
+	this->Write( text, length );
+}
+
+bool JsonStreamEncoder::Visit_Field( void * _memory, const mxField& _field, const Context& _context )
+{
+	this->BeginItem();
+	this->WriteString( _field.name );
+	if( m_options.compact ) {
+		this->WriteChar( ':' );
+	} else {
+		this->Write( ": ", 2 );
+	}
+	if( _field.type.m_kind == ETypeKind::Type_Blob )
+	{
+		// not supported by the walker
+		const mxBlobType& blobType = _field.type.UpCast< mxBlobType >();
+		void* memoryBlock = blobType.GetBufferPointer( _memory );
+		this->Visit_Class( memoryBlock, blobType.GetBufferLayout( _memory ), _context );
+		return false;
+	}
+	return true;
+}
+
+bool JsonStreamEncoder::Visit_Class( void * _object, const mxClass& _type, const Context& _context )
+{
+	this->WriteChar( '{' );
+	m_level++;
+	m_first = true;
+
+	this->WriteObjectFields( _object, _type, _context );
+
+	m_level--;
+	if( !m_first ) {
+		this->NewLine();
+	}
+	this->WriteChar( '}' );
+	// this object is an item of the enclosing scope
+	m_first = false;
+
+	// the fields have been visited
+	return false;
+}
+
+void JsonStreamEncoder::WriteObjectFields( void * _object, const mxClass& _type, const Context& _context )
+{
+	// the same order as in Walker2::VisitAggregate()
+	const mxClass* parentType = _type.GetParent();
+	while( parentType != nil )
+	{
+		Reflection::Walker2::VisitStructFields( _object, *parentType, this, _context );
+		parentType = parentType->GetParent();
+	}
+	Reflection::Walker2::VisitStructFields( _object, _type, this, _context );
+}
+
+bool JsonStreamEncoder::Visit_Array( void * _array, const mxArray& _type, const Context& _context )
+{
+	const UINT32 numObjects = _type.Generic_Get_Count( _array );
+	void* arrayBase = _type.Generic_Get_Data( _array );
+
+	const mxType& itemType = _type.m_itemType;
+	const UINT32 itemStride = _type.m_itemSize;
+
+	this->WriteChar( '[' );
+	m_level++;
+	m_first = true;
+
+	for( UINT32 iObject = 0; iObject < numObjects; iObject++ )
+	{
+		this->BeginItem();
+		void* itemData = mxAddByteOffset( arrayBase, iObject * itemStride );
+		Reflection::Walker2::Visit( itemData, itemType, this, _context );
+	}
+
+	m_level--;
+	if( !m_first ) {
+		this->NewLine();
+	}
+	this->WriteChar( ']' );
+	m_first = false;
+
+	// the elements have been visited
+	return false;
+}
+
+void JsonStreamEncoder::Visit_POD( void * _memory, const mxType& _type, const Context& _context )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Integer :
+		switch( _type.m_size )
+		{
+		case 1 :	this->WriteUnsigned( *(UINT8*)_memory );	break;
+		case 2 :	this->WriteUnsigned( *(UINT16*)_memory );	break;
+		case 4 :	this->WriteUnsigned( *(UINT32*)_memory );	break;
+		case 8 :	this->WriteInteger( *(INT64*)_memory );		break;
+		default:	mxUNREACHABLE;
+		}
+		break;
+
+	case ETypeKind::Type_Float :
+		{
+			// NaNs and infinities are written as zeros
+			char text[ Reflection::MAX_NUMBER_TEXT_LENGTH ];
+			UINT32 length;
+			if( _type.m_size == 4 ) {
+				const FLOAT value = *(FLOAT*)_memory;
+				mxASSERT2(!isnan(value) && !isinf(value), "Invalid floating-point value!");
+				length = Reflection::FormatFloat( value, text );
+			} else {
+				const DOUBLE value = *(DOUBLE*)_memory;
+				mxASSERT2(!isnan(value) && !isinf(value), "Invalid floating-point value!");
+				length = Reflection::FormatDouble( value, text );
+			}
+			this->Write( text, length );
+		}
+		break;
+
+	case ETypeKind::Type_Bool :
+		if( TPODCast< bool >::GetConst( _memory ) ) {
+			this->Write( "true", 4 );
+		} else {
+			this->Write( "false", 5 );
+		}
+		break;
+
+	case ETypeKind::Type_Enum :
+		{
+			const mxEnumType& enumInfo = _type.UpCast< mxEnumType >();
+			const UINT enumValue = enumInfo.m_accessor.Get_Value( _memory );
+			if( m_options.enumsAsIntegers ) {
+				this->WriteUnsigned( enumValue );
+			} else {
+				this->WriteString( enumInfo.GetStringByValue( enumValue ) );
+			}
+		}
+		break;
+
+	case ETypeKind::Type_Flags :
+		{
+			const mxFlagsType& flagsType = _type.UpCast< mxFlagsType >();
+			const mxFlagsType::Mask currVal = flagsType.m_accessor.Get_Value( _memory );
+
+			if( m_options.flagsAsIntegers ) {
+				this->WriteUnsigned( currVal );
+				break;
+			}
+
+			this->WriteChar( '[' );
+			m_level++;
+			m_first = true;
+			for( UINT i = 0; i < flagsType.m_numFlags; i++ )
+			{
+				const mxFlagsType::Member& flag = flagsType.m_members[ i ];
+				if( currVal & flag.mask ) {
+					this->BeginItem();
+					this->WriteString( flag.name );
+				}
+			}
+			m_level--;
+			if( !m_first ) {
+				this->NewLine();
+			}
+			this->WriteChar( ']' );
+			m_first = false;
+		}
+		break;
+
+		mxNO_SWITCH_DEFAULT;
+	}
+}
+
+void JsonStreamEncoder::Visit_String( String & _string, const Context& _context )
+{
+	this->WriteString( _string.SafeGetPtr(), _string.Length() );
+}
+
+void JsonStreamEncoder::Visit_TypeId( SClassId * _class, const Context& _context )
+{
+	mxASSERT_PTR(_class);
+	const mxClass* type = _class->type;
+	this->WriteString( type ? type->GetTypeName() : "NULL" );
+}
+
+void JsonStreamEncoder::Visit_AssetId( AssetID & _assetId, const Context& _context )
+{
+	this->WriteString( AssetId_ToChars( _assetId ) );
+}
+
+void JsonStreamEncoder::Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context )
+{
+	mxDBG_UNREACHABLE;
+	this->Write( "null", 4 );
+}
+
+void JsonStreamEncoder::Visit_UserPointer( void * _pointer, const mxUserPointerType& _type, const Context& _context )
+{
+	this->WriteString( _type.GetPersistentStringId( _pointer ) );
+}
+
+void JsonStreamEncoder::BeginItem()
+{
+	if( !m_first ) {
+		this->WriteChar( ',' );
+	}
+	m_first = false;
+	this->NewLine();
+}
+
+void JsonStreamEncoder::NewLine()
+{
+	if( m_options.compact ) {
+		return;
+	}
+	this->WriteChar( '\n' );
+	for( int i = 0; i < m_level; i++ ) {
+		this->Write( "    ", 4 );
+	}
+}
+
+void JsonStreamEncoder::WriteString( const char* _string, UINT32 _length )
+{
+	static const char hexDigits[] = "0123456789abcdef";
+
+	this->WriteChar( '"' );
+
+	// UTF-8 sequences are either escaped or copied as-is
+	const UINT32 firstEscapedByte = m_options.escapeUnicode ? 0x80 : 0x100;
+
+	const UINT8* s = c_cast(const UINT8*) _string;
+	const UINT8* end = s + _length;
+	while( s < end )
+	{
+		// copy runs of characters which don't need escaping
+		const UINT8* run = s;
+		while( s < end && *s >= 0x20 && *s < firstEscapedByte && *s != '"' && *s != '\\' ) {
+			s++;
+		}
+		if( s > run ) {
+			this->Write( run, s - run );
+		}
+		if( s == end ) {
+			break;
+		}
+
+		const UINT8 c = *s;
+		switch( c )
+		{
+		case '"' :	this->Write( "\\\"", 2 );	s++;	continue;
+		case '\\' :	this->Write( "\\\\", 2 );	s++;	continue;
+		case '\b' :	this->Write( "\\b", 2 );	s++;	continue;
+		case '\f' :	this->Write( "\\f", 2 );	s++;	continue;
+		case '\n' :	this->Write( "\\n", 2 );	s++;	continue;
+		case '\r' :	this->Write( "\\r", 2 );	s++;	continue;
+		case '\t' :	this->Write( "\\t", 2 );	s++;	continue;
+		}
+
+		// control characters and UTF-8 sequences are written as \uXXXX (ASCII output)
+		UINT32 codePoint = c;
+		UINT32 numBytes = 1;
+		if( c >= 0xF0 )			{ codePoint = c & 0x07; numBytes = 4; }
+		else if( c >= 0xE0 )	{ codePoint = c & 0x0F; numBytes = 3; }
+		else if( c >= 0xC0 )	{ codePoint = c & 0x1F; numBytes = 2; }
+		if( s + numBytes > end ) {
+			numBytes = 1;	// truncated sequence, write the byte as is
+			codePoint = c;
+		}
+		for( UINT32 i = 1; i < numBytes; i++ ) {
+			codePoint = (codePoint << 6) | (s[i] & 0x3F);
+		}
+		s += numBytes;
+
+		UINT32 units[2];
+		UINT32 numUnits = 1;
+		units[0] = codePoint;
+		if( codePoint >= 0x10000 )
+		{
+			// surrogate pair
+			codePoint -= 0x10000;
+			units[0] = 0xD800 | (codePoint >> 10);
+			units[1] = 0xDC00 | (codePoint & 0x3FF);
+			numUnits = 2;
+		}
+		for( UINT32 i = 0; i < numUnits; i++ )
+		{
+			const char escaped[6] = {
+				'\\', 'u',
+				hexDigits[ (units[i] >> 12) & 0xF ],
+				hexDigits[ (units[i] >> 8) & 0xF ],
+				hexDigits[ (units[i] >> 4) & 0xF ],
+				hexDigits[ units[i] & 0xF ]
+			};
+			this->Write( escaped, sizeof(escaped) );
+		}
+	}
+
+	this->WriteChar( '"' );
+}
+
+void JsonStreamEncoder::WriteString( const char* _string )
+{
+	this->WriteString( _string, strlen( _string ) );
+}
+
+void JsonStreamEncoder::WriteInteger( INT64 _value )
+{
+	if( _value < 0 ) {
+		this->WriteChar( '-' );
+		this->WriteUnsigned( (UINT64)0 - (UINT64)_value );
+	} else {
+		this->WriteUnsigned( (UINT64)_value );
+	}
+}
+
+void JsonStreamEncoder::WriteUnsigned( UINT64 _value )
+{
+	char digits[24];
+	char* p = digits + sizeof(digits);
+	do {
+		*--p = (char)( '0' + _value % 10 );
+		_value /= 10;
+	} while( _value );
+	this->Write( p, digits + sizeof(digits) - p );
+}
+
+void JsonStreamEncoder::Write( const void* _data, UINT32 _size )
+{
+	if( m_used + _size > BUFFER_SIZE )
+	{
+		this->Flush();
+		if( _size > BUFFER_SIZE ) {
+			if( mxSUCCEDED(m_status) ) {
+				m_status = m_stream.Write( _data, _size );
+			}
+			return;
+		}
+	}
+	memcpy( m_buffer + m_used, _data, _size );
+	m_used += _size;
+}
+
+void JsonStreamEncoder::WriteChar( char c )
+{
+	if( m_used == BUFFER_SIZE ) {
+		this->Flush();
+	}
+	m_buffer[ m_used++ ] = c;
+}
+
+ERet JsonStreamEncoder::Flush()
+{
+	if( m_used && mxSUCCEDED(m_status) ) {
+		m_status = m_stream.Write( m_buffer, m_used );
+	}
+	m_used = 0;
+	return m_status;
+}
+
+ERet JSON_EncodeStream( const void* o, const mxType& type, AStreamWriter &stream, const JSON::SaveOptions& options )
+{
+	JsonStreamEncoder	encoder( stream, options );
+	return encoder.EncodeObject( o, type );
+}
+
 /*
 -----------------------------------------------------------------------------
 	JsonDecoder
@@ -598,9 +1035,13 @@ void* JsonDecoder::Visit_POD( void * o, const mxType& type, void* _userData )
 	case ETypeKind::Type_Enum :
 		{
 			const mxEnumType& enumInfo = type.UpCast< mxEnumType >();
-			const char* sEnumValue = json_string_value( jsonValue );
-			const UINT nEnumValue = enumInfo.GetIntegerByString(sEnumValue);
-			enumInfo.m_accessor.Set_Value( o, nEnumValue );
+			if( json_is_integer( jsonValue ) ) {
+				enumInfo.m_accessor.Set_Value( o, (UINT) json_integer_value( jsonValue ) );
+			} else {
+				const char* sEnumValue = json_string_value( jsonValue );
+				const UINT nEnumValue = enumInfo.GetIntegerByString(sEnumValue);
+				enumInfo.m_accessor.Set_Value( o, nEnumValue );
+			}
 		}
 		break;
 
@@ -627,9 +1068,26 @@ void* JsonDecoder::Visit_Aggregate( void * o, const mxClass& type, void* _userDa
 		mxASSERT(!strcmp( json_string_value(typeTag), type.m_name.buffer ));
 	}
 
-	// read object data
+	// read object data:
+	// iterate over the keys once and look up the fields in the class's hash table
 	{
-		Super::Visit_Aggregate( o, type, (void*)objectValue );
+		json_t* jsonObject = c_cast(json_t*) objectValue;
+		void* iter = json_object_iter( jsonObject );
+		while( iter != nil )
+		{
+			const char* key = json_object_iter_key( iter );
+			const mxFieldInfo* fieldInfo = Reflection::FindField( type, key );
+			if( fieldInfo != nil )
+			{
+				void* fieldData = mxAddByteOffset( o, fieldInfo->offset );
+				Super::Visit_Field( fieldData, *fieldInfo->field, json_object_iter_value( iter ) );
+			}
+			else if( key[0] != '$' )	// skip tags
+			{
+				ptWARN("Unknown struct field: '%s' in '%s'\n", key, type.GetTypeName());
+			}
+			iter = json_object_iter_next( jsonObject, iter );
+		}
 	}
 	return nil;
 }
@@ -733,6 +1191,952 @@ void* JsonDecoder::Visit_String( String & s, void* _userData )
 	return nil;
 }
 
+/*
+-----------------------------------------------------------------------------
+	JsonStreamDecoder
+-----------------------------------------------------------------------------
+*/
+enum
+{
+	JSON_MAX_NESTING_DEPTH = 512,
+	JSON_MIN_ARRAY_CAPACITY = 8,
+};
+
+static inline bool JSON_IsDigit( char c )
+{
+	return c >= '0' && c <= '9';
+}
+
+// characters which can follow a number or a literal
+static inline bool JSON_IsDelimiter( char c )
+{
+	switch( c )
+	{
+	case ' ' : case '\t' : case '\n' : case '\r' :
+	case ',' : case ':' : case ']' : case '}' :
+	case '/' :	// a comment
+	case '\0' :
+		return true;
+	}
+	return false;
+}
+
+static inline int JSON_HexDigit( char c )
+{
+	if( c >= '0' && c <= '9' ) return c - '0';
+	if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+	if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+	return -1;
+}
+
+static UINT32 JSON_EncodeUTF8( UINT32 codePoint, char *dst )
+{
+	if( codePoint < 0x80 ) {
+		dst[0] = (char) codePoint;
+		return 1;
+	}
+	if( codePoint < 0x800 ) {
+		dst[0] = (char)( 0xC0 | (codePoint >> 6) );
+		dst[1] = (char)( 0x80 | (codePoint & 0x3F) );
+		return 2;
+	}
+	if( codePoint < 0x10000 ) {
+		dst[0] = (char)( 0xE0 | (codePoint >> 12) );
+		dst[1] = (char)( 0x80 | ((codePoint >> 6) & 0x3F) );
+		dst[2] = (char)( 0x80 | (codePoint & 0x3F) );
+		return 3;
+	}
+	dst[0] = (char)( 0xF0 | (codePoint >> 18) );
+	dst[1] = (char)( 0x80 | ((codePoint >> 12) & 0x3F) );
+	dst[2] = (char)( 0x80 | ((codePoint >> 6) & 0x3F) );
+	dst[3] = (char)( 0x80 | (codePoint & 0x3F) );
+	return 4;
+}
+
+JsonStreamDecoder::JsonStreamDecoder( const char* text, UINT32 length, const char* file, int line )
+{
+	mxASSERT_PTR(text);
+	mxASSERT(text[ length ] == '\0');
+	m_start = text;
+	m_end = text + length;
+	m_curr = text;
+	m_file = file;
+	m_line = line;
+	m_depth = 0;
+	m_inSituText = NULL;
+	m_deferredValues = NULL;
+	m_scratchUsed = 0;
+	m_tokens = NULL;
+	m_numTokens = 0;
+	m_nextToken = 0;
+}
+
+void JsonStreamDecoder::SetStructuralIndex( const UINT32* _tokens, UINT32 _numTokens )
+{
+	m_tokens = _tokens;
+	m_numTokens = _numTokens;
+	m_nextToken = 0;
+}
+
+void JsonStreamDecoder::SetInSitu( char* _text )
+{
+	mxASSERT(_text == m_start);
+	m_inSituText = _text;
+}
+
+void JsonStreamDecoder::SetDeferredValues( JsonDeferredValues* _deferredValues )
+{
+	m_deferredValues = _deferredValues;
+}
+
+JsonStreamDecoder::~JsonStreamDecoder()
+{
+}
+
+static void JSON_SetValueFromString( void *o, const mxType& type, const char* stringValue )
+{
+	if( type.m_kind == ETypeKind::Type_AssetId )
+	{
+		AssetID & assetId = *static_cast< AssetID* >( o );
+		if( strcmp( stringValue, "NULL" ) != 0 ) {
+			assetId.d = mxName( stringValue );
+		} else {
+			assetId.d = mxName();
+		}
+	}
+	else
+	{
+		mxASSERT(type.m_kind == ETypeKind::Type_UserData);
+		type.UpCast< mxUserPointerType >().SetFromStringId( o, stringValue );
+	}
+}
+
+ERet JsonDeferredValues::Add( void *o, const mxType& type, const char* stringValue )
+{
+	const UINT32 length = strlen( stringValue );
+	const UINT32 offset = strings.Num();
+	mxDO(strings.SetNum( offset + length + 1 ));
+	memcpy( strings.ToPtr() + offset, stringValue, length + 1 );
+
+	JsonDeferredValue& newValue = values.Add();
+	newValue.o = o;
+	newValue.type = &type;
+	newValue.stringOffset = offset;
+	return ALL_OK;
+}
+
+void JsonDeferredValues::Resolve()
+{
+	for( UINT32 i = 0; i < values.Num(); i++ )
+	{
+		const JsonDeferredValue& value = values[i];
+		JSON_SetValueFromString( value.o, *value.type, strings.ToPtr() + value.stringOffset );
+	}
+	values.Empty();
+	strings.Empty();
+}
+
+ERet JsonStreamDecoder::DecodeObject( void *o, const mxType& type )
+{
+	mxASSERT_PTR(o);
+	mxDO(this->ReadValue( o, type ));
+	this->SkipWhitespace();
+	if( m_curr != m_end ) {
+		return this->Error( "unexpected data after the root value" );
+	}
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadValue( void *o, const mxType& type )
+{
+	switch( type.m_kind )
+	{
+	case ETypeKind::Type_Integer :
+		{
+			UINT64 integer;
+			mxDO(this->ReadInteger( integer ));
+			switch( type.m_size )
+			{
+			case 1 :	*(UINT8*)o = (UINT8) integer;	break;
+			case 2 :	*(UINT16*)o = (UINT16) integer;	break;
+			case 4 :	*(UINT32*)o = (UINT32) integer;	break;
+			case 8 :	*(UINT64*)o = (UINT64) integer;	break;
+			default:	return this->Error( "unsupported integer size" );
+			}
+		}
+		break;
+
+	case ETypeKind::Type_Float :
+		{
+			double real;
+			mxDO(this->ReadReal( real ));
+			switch( type.m_size )
+			{
+			case 4 :	*(FLOAT*)o = (FLOAT) real;	break;
+			case 8 :	*(DOUBLE*)o = (DOUBLE) real;	break;
+			default:	return this->Error( "unsupported floating-point type size" );
+			}
+		}
+		break;
+
+	case ETypeKind::Type_Bool :
+		{
+			this->SkipWhitespace();
+			const bool booleanValue = (*m_curr == 't');
+			mxDO(booleanValue ? this->ReadLiteral( "true", 4 ) : this->ReadLiteral( "false", 5 ));
+			TPODCast< bool >::GetNonConst( o ) = booleanValue;
+		}
+		break;
+
+	case ETypeKind::Type_Enum :
+		{
+			const mxEnumType& enumInfo = type.UpCast< mxEnumType >();
+			this->SkipWhitespace();
+			if( *m_curr == '"' )
+			{
+				const char* valueName;
+				mxDO(this->ReadStringZ( valueName ));
+				enumInfo.m_accessor.Set_Value( o, enumInfo.GetValueByString( valueName ) );
+			}
+			else
+			{
+				// integer value
+				UINT64 integer;
+				mxDO(this->ReadInteger( integer ));
+				enumInfo.m_accessor.Set_Value( o, (UINT) integer );
+			}
+		}
+		break;
+
+	case ETypeKind::Type_Flags :
+		mxDO(this->ReadFlags( o, type.UpCast< mxFlagsType >() ));
+		break;
+
+	case ETypeKind::Type_String :
+		if( m_inSituText )
+		{
+			mxDO(this->ReadStringInSitu( TPODCast< String >::GetNonConst( o ) ));
+		}
+		else
+		{
+			const char* start;
+			UINT32 length;
+			mxDO(this->ReadString( start, length ));
+			Str::CopyS( TPODCast< String >::GetNonConst( o ), start, length );
+		}
+		break;
+
+	case ETypeKind::Type_Class :
+		mxDO(this->ReadObject( o, type.UpCast< mxClass >() ));
+		break;
+
+	case ETypeKind::Type_Pointer :
+		ptWARN("%s: pointers are not supported\n", m_file);
+		mxDO(this->SkipValue());
+		break;
+
+	case ETypeKind::Type_AssetId :
+	case ETypeKind::Type_UserData :
+		{
+			const char* stringValue;
+			mxDO(this->ReadStringZ( stringValue ));
+			if( m_deferredValues ) {
+				mxDO(m_deferredValues->Add( o, type, stringValue ));
+			} else {
+				JSON_SetValueFromString( o, type, stringValue );
+			}
+		}
+		break;
+
+	case ETypeKind::Type_ClassId :
+		{
+			const char* typeName;
+			mxDO(this->ReadStringZ( typeName ));
+			SClassId * classId = static_cast< SClassId* >( o );
+			if( strcmp( typeName, "NULL" ) != 0 ) {
+				classId->type = TypeRegistry::Get().FindClassByName( typeName );
+			} else {
+				classId->type = nil;
+			}
+		}
+		break;
+
+	case ETypeKind::Type_Blob :
+		{
+			const mxBlobType& blobType = type.UpCast< mxBlobType >();
+			void* memoryBlock = blobType.GetBufferPointer( o );
+			mxDO(this->ReadObject( memoryBlock, blobType.GetBufferLayout( o ) ));
+		}
+		break;
+
+	case ETypeKind::Type_Array :
+		mxDO(this->ReadArray( o, type.UpCast< mxArray >() ));
+		break;
+
+	default:
+		return this->Error( "unsupported type" );
+	}
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadObject( void *o, const mxClass& type )
+{
+	mxDO(this->Expect( '{' ));
+	if( ++m_depth > JSON_MAX_NESTING_DEPTH ) {
+		return this->Error( "too deeply nested" );
+	}
+	if( !this->Accept( '}' ) )
+	{
+		do
+		{
+			const char* key;
+			UINT32 keyLength;
+			mxDO(this->ReadString( key, keyLength ));
+			mxDO(this->Expect( ':' ));
+
+			// the key may point into the scratch buffer, use it before reading the value
+			const mxFieldInfo* fieldInfo = Reflection::FindField( type, key, keyLength );
+			if( fieldInfo != nil )
+			{
+				void* fieldData = mxAddByteOffset( o, fieldInfo->offset );
+				mxDO(this->ReadValue( fieldData, fieldInfo->field->type ));
+			}
+			else
+			{
+				if( !keyLength || key[0] != '$' ) {	// skip tags
+					ptWARN("Unknown struct field: '%.*s' in '%s'\n", keyLength, key, type.GetTypeName());
+				}
+				mxDO(this->SkipValue());
+			}
+		}
+		while( this->Accept( ',' ) );
+
+		mxDO(this->Expect( '}' ));
+	}
+	m_depth--;
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadArray( void *o, const mxArray& type )
+{
+	mxDO(this->Expect( '[' ));
+	if( ++m_depth > JSON_MAX_NESTING_DEPTH ) {
+		return this->Error( "too deeply nested" );
+	}
+
+	const mxType& itemType = type.m_itemType;
+	const UINT32 itemStride = type.m_itemSize;
+	const bool isDynamic = type.IsDynamic();
+
+	if( isDynamic ) {
+		type.Generic_Set_Count( o, 0 );
+	}
+	UINT32 capacity = type.Generic_Get_Capacity( o );
+	UINT32 count = 0;
+
+	if( !this->Accept( ']' ) )
+	{
+		do
+		{
+			if( count == capacity )
+			{
+				if( !isDynamic ) {
+					return this->Error( "too many elements in a fixed-size array" );
+				}
+				// the number of elements is not known in advance
+				capacity = largest( capacity * 2, (UINT32)JSON_MIN_ARRAY_CAPACITY );
+				chkRET_X_IF_NOT(type.Generic_Set_Capacity( o, capacity ), ERR_OUT_OF_MEMORY);
+			}
+			chkRET_X_IF_NOT(type.Generic_Set_Count( o, count + 1 ), ERR_OUT_OF_MEMORY);
+
+			void* itemData = mxAddByteOffset( type.Generic_Get_Data( o ), count * itemStride );
+			mxDO(this->ReadValue( itemData, itemType ));
+			count++;
+		}
+		while( this->Accept( ',' ) );
+
+		mxDO(this->Expect( ']' ));
+	}
+	m_depth--;
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadFlags( void *o, const mxFlagsType& type )
+{
+	mxFlagsType::Mask integerValue = 0;
+	this->SkipWhitespace();
+	if( *m_curr != '[' )
+	{
+		// raw bit mask
+		UINT64 integer;
+		mxDO(this->ReadInteger( integer ));
+		type.m_accessor.Set_Value( o, (mxFlagsType::Mask) integer );
+		return ALL_OK;
+	}
+	mxDO(this->Expect( '[' ));
+	if( !this->Accept( ']' ) )
+	{
+		do
+		{
+			const char* flagName;
+			mxDO(this->ReadStringZ( flagName ));
+			integerValue |= type.GetItemValueByName( flagName );
+		}
+		while( this->Accept( ',' ) );
+
+		mxDO(this->Expect( ']' ));
+	}
+	type.m_accessor.Set_Value( o, integerValue );
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadString( const char *&_start, UINT32 &_length )
+{
+	this->SkipWhitespace();
+	if( *m_curr != '"' ) {
+		return this->Error( "expected a string" );
+	}
+	const char* closingQuote = this->FindClosingQuote();
+	const char* start = ++m_curr;
+
+	if( closingQuote )
+	{
+		// the end of the string is known, only look for escape sequences
+		const char* backslash = (const char*) memchr( start, '\\', closingQuote - start );
+		m_curr = backslash ? backslash : closingQuote;
+	}
+	else
+	{
+		while( *m_curr != '"' && *m_curr != '\\' )
+		{
+			if( *m_curr == '\0' ) {
+				return this->Error( "unterminated string" );
+			}
+			m_curr++;
+		}
+	}
+
+	// fast path: strings without escape sequences are returned in-place
+	if( *m_curr == '"' )
+	{
+		_start = start;
+		_length = m_curr - start;
+		m_curr++;
+		return ALL_OK;
+	}
+
+	// slow path: unescape into the scratch buffer
+	m_scratchUsed = 0;
+	const UINT32 prefixLength = m_curr - start;
+	memcpy( this->AllocScratch( prefixLength ), start, prefixLength );
+
+	for(;;)
+	{
+		const char c = *m_curr++;
+		if( c == '"' ) {
+			break;
+		}
+		if( c == '\0' ) {
+			m_curr--;
+			return this->Error( "unterminated string" );
+		}
+		if( c != '\\' ) {
+			*this->AllocScratch( 1 ) = c;
+			continue;
+		}
+		const char escaped = *m_curr++;
+		switch( escaped )
+		{
+		case '"' :	*this->AllocScratch( 1 ) = '"';		break;
+		case '\\' :	*this->AllocScratch( 1 ) = '\\';	break;
+		case '/' :	*this->AllocScratch( 1 ) = '/';		break;
+		case 'b' :	*this->AllocScratch( 1 ) = '\b';	break;
+		case 'f' :	*this->AllocScratch( 1 ) = '\f';	break;
+		case 'n' :	*this->AllocScratch( 1 ) = '\n';	break;
+		case 'r' :	*this->AllocScratch( 1 ) = '\r';	break;
+		case 't' :	*this->AllocScratch( 1 ) = '\t';	break;
+		case 'u' :
+			{
+				UINT32 codePoint = 0;
+				for( int i = 0; i < 4; i++ )
+				{
+					const int digit = JSON_HexDigit( *m_curr++ );
+					if( digit < 0 ) {
+						return this->Error( "invalid unicode escape sequence" );
+					}
+					codePoint = (codePoint << 4) | digit;
+				}
+				// surrogate pair
+				if( codePoint >= 0xD800 && codePoint <= 0xDBFF && m_curr[0] == '\\' && m_curr[1] == 'u' )
+				{
+					m_curr += 2;
+					UINT32 lowSurrogate = 0;
+					for( int i = 0; i < 4; i++ )
+					{
+						const int digit = JSON_HexDigit( *m_curr++ );
+						if( digit < 0 ) {
+							return this->Error( "invalid unicode escape sequence" );
+						}
+						lowSurrogate = (lowSurrogate << 4) | digit;
+					}
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+				}
+				char utf8[4];
+				const UINT32 numBytes = JSON_EncodeUTF8( codePoint, utf8 );
+				memcpy( this->AllocScratch( numBytes ), utf8, numBytes );
+			}
+			break;
+		default:
+			m_curr--;
+			return this->Error( "invalid escape sequence" );
+		}
+	}
+
+	_length = m_scratchUsed;
+	*this->AllocScratch( 1 ) = '\0';
+	_start = m_scratch.ToPtr();
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadStringZ( const char *&_string )
+{
+	const char* start;
+	UINT32 length;
+	mxDO(this->ReadString( start, length ));
+	if( start != m_scratch.ToPtr() )
+	{
+		// copy the in-place string
+		m_scratchUsed = 0;
+		char* copy = this->AllocScratch( length + 1 );
+		memcpy( copy, start, length );
+		copy[ length ] = '\0';
+		start = m_scratch.ToPtr();
+	}
+	_string = start;
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadStringInSitu( String &_string )
+{
+	this->SkipWhitespace();
+	// the unescaped string is never longer than the escaped one,
+	// so it always fits between the quotes (the closing quote is replaced with null)
+	char* dest = m_inSituText + (m_curr - m_start) + 1;
+	const char* start;
+	UINT32 length;
+	mxDO(this->ReadString( start, length ));
+	if( !length ) {
+		Str::CopyS( _string, start, 0 );
+		return ALL_OK;
+	}
+	if( start != dest ) {
+		// the string had escape sequences and was unescaped into the scratch buffer
+		memcpy( dest, start, length );
+	}
+	dest[ length ] = '\0';
+	_string.SetReference( Chars( dest ) );
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadNumber( UINT64 &_magnitude, bool &_isNegative, double &_real, bool &_isInteger )
+{
+	this->SkipWhitespace();
+	const char* start = m_curr;
+
+	_isNegative = (*m_curr == '-');
+	if( _isNegative ) {
+		m_curr++;
+	}
+	if( !JSON_IsDigit( *m_curr ) ) {
+		return this->Error( "expected a number" );
+	}
+
+	// fast path for integers, up to 20 digits fit into UINT64
+	UINT64 magnitude = 0;
+	bool overflow = false;
+	while( JSON_IsDigit( *m_curr ) )
+	{
+		const UINT32 digit = *m_curr - '0';
+		if( magnitude > (UINT64(~0) - digit) / 10 ) {
+			overflow = true;
+		} else {
+			magnitude = magnitude * 10 + digit;
+		}
+		m_curr++;
+	}
+	const char c = *m_curr;
+	if( c != '.' && c != 'e' && c != 'E' && !overflow )
+	{
+		_magnitude = magnitude;
+		_isInteger = true;
+	}
+	else
+	{
+		const char* end = Reflection::ParseDouble( start, _real );
+		if( !end ) {
+			return this->Error( "invalid number" );
+		}
+		m_curr = end;
+		_isInteger = false;
+	}
+	if( !JSON_IsDelimiter( *m_curr ) ) {
+		return this->Error( "invalid number" );
+	}
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadInteger( UINT64 &_bits )
+{
+	UINT64 magnitude;
+	bool isNegative;
+	double real;
+	bool isInteger;
+	mxDO(this->ReadNumber( magnitude, isNegative, real, isInteger ));
+	if( isInteger )
+	{
+		if( isNegative && magnitude > (UINT64(1) << 63) ) {
+			return this->Error( "integer is out of range" );
+		}
+		_bits = isNegative ? 0 - magnitude : magnitude;
+		return ALL_OK;
+	}
+	// truncated towards zero, the negated comparisons reject NaNs
+	if( real >= 0 )
+	{
+		if( !(real < 18446744073709551616.0) ) {
+			return this->Error( "integer is out of range" );
+		}
+		_bits = (UINT64) real;
+	}
+	else
+	{
+		if( !(real >= -9223372036854775808.0) ) {
+			return this->Error( "integer is out of range" );
+		}
+		_bits = (UINT64) (INT64) real;
+	}
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadReal( double &_real )
+{
+	UINT64 magnitude;
+	bool isNegative;
+	bool isInteger;
+	mxDO(this->ReadNumber( magnitude, isNegative, _real, isInteger ));
+	if( isInteger ) {
+		_real = isNegative ? -(double) magnitude : (double) magnitude;
+	}
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::ReadLiteral( const char* _literal, UINT32 _length )
+{
+	this->SkipWhitespace();
+	if( strncmp( m_curr, _literal, _length ) != 0 ) {
+		return this->Error( "unexpected token" );
+	}
+	m_curr += _length;
+	if( !JSON_IsDelimiter( *m_curr ) ) {
+		return this->Error( "unexpected token" );
+	}
+	return ALL_OK;
+}
+
+ERet JsonStreamDecoder::SkipString()
+{
+	mxASSERT(*m_curr == '"');
+	const char* closingQuote = this->FindClosingQuote();
+	if( closingQuote ) {
+		m_curr = closingQuote + 1;
+		return ALL_OK;
+	}
+	m_curr++;
+	for(;;)
+	{
+		const char c = *m_curr++;
+		if( c == '"' ) {
+			return ALL_OK;
+		}
+		if( c == '\\' && *m_curr != '\0' ) {
+			m_curr++;
+			continue;
+		}
+		if( c == '\0' ) {
+			m_curr--;
+			return this->Error( "unterminated string" );
+		}
+	}
+}
+
+ERet JsonStreamDecoder::SkipValue()
+{
+	this->SkipWhitespace();
+	const char c = *m_curr;
+
+	if( c == '"' ) {
+		return this->SkipString();
+	}
+
+	if( (c == '{' || c == '[') && m_tokens )
+	{
+		// only look at structural characters
+		int depth = 0;
+		for( UINT32 i = m_nextToken; i < m_numTokens; i++ )
+		{
+			const char token = m_start[ m_tokens[ i ] ];
+			if( token == '{' || token == '[' ) {
+				depth++;
+			}
+			else if( (token == '}' || token == ']') && --depth == 0 ) {
+				m_curr = m_start + m_tokens[ i ] + 1;
+				m_nextToken = i + 1;
+				return ALL_OK;
+			}
+		}
+		m_curr = m_end;
+		return this->Error( "unexpected end of data" );
+	}
+
+	if( c == '{' || c == '[' )
+	{
+		// skip the nested values without recursion
+		int depth = 0;
+		do
+		{
+			this->SkipWhitespace();
+			switch( *m_curr )
+			{
+			case '"' :
+				mxDO(this->SkipString());
+				break;
+			case '{' :
+			case '[' :
+				depth++;
+				m_curr++;
+				break;
+			case '}' :
+			case ']' :
+				depth--;
+				m_curr++;
+				break;
+			case '\0' :
+				return this->Error( "unexpected end of data" );
+			default:
+				m_curr++;
+			}
+		}
+		while( depth > 0 );
+		return ALL_OK;
+	}
+
+	// a number or a literal
+	const char* start = m_curr;
+	while( *m_curr && !strchr( ",:]} \t\r\n/", *m_curr ) ) {
+		m_curr++;
+	}
+	if( m_curr == start ) {
+		return this->Error( "expected a value" );
+	}
+	return ALL_OK;
+}
+
+void JsonStreamDecoder::SkipWhitespace()
+{
+	if( m_tokens )
+	{
+		// jump to the next token
+		const UINT32 offset = m_curr - m_start;
+		while( m_nextToken < m_numTokens && m_tokens[ m_nextToken ] < offset ) {
+			m_nextToken++;
+		}
+		m_curr = (m_nextToken < m_numTokens) ? m_start + m_tokens[ m_nextToken ] : m_end;
+		return;
+	}
+	for(;;)
+	{
+		const char c = *m_curr;
+		if( c == ' ' || c == '\t' || c == '\n' || c == '\r' ) {
+			m_curr++;
+			continue;
+		}
+		if( c == '/' && bEnableJsonComments )
+		{
+			if( m_curr[1] == '/' ) {
+				m_curr += 2;
+				while( *m_curr && *m_curr != '\n' ) {
+					m_curr++;
+				}
+				continue;
+			}
+			if( m_curr[1] == '*' ) {
+				m_curr += 2;
+				while( *m_curr && !(m_curr[0] == '*' && m_curr[1] == '/') ) {
+					m_curr++;
+				}
+				if( *m_curr ) {
+					m_curr += 2;
+				}
+				continue;
+			}
+		}
+		break;
+	}
+}
+
+const char* JsonStreamDecoder::FindClosingQuote()
+{
+	if( !m_tokens ) {
+		return NULL;
+	}
+	const UINT32 offset = m_curr - m_start;
+	while( m_nextToken < m_numTokens && m_tokens[ m_nextToken ] < offset ) {
+		m_nextToken++;
+	}
+	// quotes are always paired in the index
+	if( m_nextToken + 1 < m_numTokens && m_tokens[ m_nextToken ] == offset ) {
+		return m_start + m_tokens[ m_nextToken + 1 ];
+	}
+	return NULL;
+}
+
+bool JsonStreamDecoder::Accept( char c )
+{
+	this->SkipWhitespace();
+	if( *m_curr == c ) {
+		m_curr++;
+		return true;
+	}
+	return false;
+}
+
+ERet JsonStreamDecoder::Expect( char c )
+{
+	if( !this->Accept( c ) )
+	{
+		char message[32];
+		sprintf( message, "expected '%c'", c );
+		return this->Error( message );
+	}
+	return ALL_OK;
+}
+
+char* JsonStreamDecoder::AllocScratch( UINT32 _size )
+{
+	const UINT32 newSize = m_scratchUsed + _size;
+	if( newSize > m_scratch.Num() ) {
+		m_scratch.SetNum( largest( newSize, m_scratch.Num() * 2 ) );
+	}
+	char* result = m_scratch.ToPtr() + m_scratchUsed;
+	m_scratchUsed = newSize;
+	return result;
+}
+
+ERet JsonStreamDecoder::Error( const char* message )
+{
+	// find the line and column only when reporting the error
+	int line = m_line;
+	const char* lineStart = m_start;
+	for( const char* p = m_start; p < m_curr; p++ )
+	{
+		if( *p == '\n' ) {
+			line++;
+			lineStart = p + 1;
+		}
+	}
+	ptERROR("%s(%d,%d): parse error: %s\n", m_file, line, (int)(m_curr - lineStart) + 1, message);
+	return ERR_FAILED_TO_PARSE_DATA;
+}
+
+static ERet JSON_DecodeText( const char* text, UINT32 length, void *o, const mxType& type, const char* file, int line )
+{
+	JsonStreamDecoder	decoder( text, length, file, line );
+
+	// the index is not built for texts with comments
+	TArray< UINT32 >	tokens;
+	if( JSON_BuildStructuralIndex( text, length, tokens ) ) {
+		decoder.SetStructuralIndex( tokens.ToPtr(), tokens.Num() );
+	}
+
+	return decoder.DecodeObject( o, type );
+}
+
+ERet JSON_DecodeStream( AStreamReader& stream, void *o, const mxType& type, const char* file, int line )
+{
+	ByteBuffer	fileData;
+	UINT32		fileSize;
+	mxDO(JSON_LoadText( stream, fileData, fileSize ));
+
+	return JSON_DecodeText( c_cast(const char*) fileData.ToPtr(), fileSize, o, type, file, line );
+}
+
+// decodes a copy of the mapped text if there's no null after it,
+// String fields own their memory
+static ERet JSON_DecodeMappedText( const MappedFile& mapping, void *o, const mxType& type, const char* file )
+{
+	const char* text = c_cast(const char*) mapping.GetData();
+	const UINT32 length = mapping.GetSize();
+
+	// the decoder needs a null after the text
+	ByteBuffer	copy;
+	if( !mapping.IsNullTerminated() )
+	{
+		mxDO(copy.SetNum( length + 1 ));
+		memcpy( copy.ToPtr(), text, length );
+		copy[ length ] = '\0';
+		text = c_cast(const char*) copy.ToPtr();
+	}
+
+	return JSON_DecodeText( text, length, o, type, file, 1 );
+}
+
+ERet JSON_DecodeFile( const char* file, void *o, const mxType& type )
+{
+	MappedFile	mapping;
+	mxDO(mapping.Open( file, FileMap_ReadOnly, FileAccess_Sequential ));
+
+	return JSON_DecodeMappedText( mapping, o, type, file );
+}
+
+ERet JSON_DecodeFileInSitu( const char* file, MappedFile &mapping, void *o, const mxType& type )
+{
+	// the closing quote of every string is replaced with null,
+	// so every page containing a string is copied on the first write
+	// (only pages without any strings stay shared with the file)
+	// NOTE: empty files are rejected by MappedFile::Open()
+	mxDO(mapping.Open( file, FileMap_CopyOnWrite, FileAccess_Sequential ));
+
+	char* text = c_cast(char*) mapping.GetData();
+	UINT32 length = mapping.GetSize();
+
+	if( !mapping.IsNullTerminated() )
+	{
+		// there's no room after the text, so replace the trailing whitespace with null
+		const char lastChar = text[ length - 1 ];
+		if( lastChar != ' ' && lastChar != '\t' && lastChar != '\n' && lastChar != '\r' ) {
+			// the file ends exactly at a page boundary: decode a copy instead
+			return JSON_DecodeMappedText( mapping, o, type, file );
+		}
+		text[ --length ] = '\0';
+	}
+
+	return JSON_DecodeInSitu( text, length, o, type, file, 1 );
+}
+
+ERet JSON_DecodeInSitu( char* text, UINT32 length, void *o, const mxType& type, const char* file, int line )
+{
+	JsonStreamDecoder	decoder( text, length, file, line );
+	decoder.SetInSitu( text );
+
+	// the index must be built before the text is modified
+	TArray< UINT32 >	tokens;
+	if( JSON_BuildStructuralIndex( text, length, tokens ) ) {
+		decoder.SetStructuralIndex( tokens.ToPtr(), tokens.Num() );
+	}
+
+	return decoder.DecodeObject( o, type );
+}
+
 json_t* JSON_EncodeObject( const void* o, const mxType& type )
 {
 	JsonEncoder	jsonWriter;
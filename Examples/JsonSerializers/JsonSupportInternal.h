@@ -79,7 +79,9 @@ bool JSON_Find_String_Value( const json_t* parent, const char* key, String &valu
 
 // file name is used for diagnostics
 json_t* JSON_ParseStream( AStreamReader& stream, const char* file = "", int line = 0 );
-bool JSON_WriteToStream( const json_t* root, AStreamWriter& stream );
+// maps the file instead of loading it into memory
+json_t* JSON_ParseFile( const char* file );
+bool JSON_WriteToStream( const json_t* root, AStreamWriter& stream, const JSON::SaveOptions& options = JSON::SaveOptions() );
 
 
 bool JSON_DumpToFile( const json_t* root, const char* file );
@@ -192,6 +194,194 @@ public:
 	virtual void* Visit_String( String & s, void* _userData ) override;
 };
 
+/*
+-----------------------------------------------------------------------------
+	JsonDeferredValues
+
+	asset ids and user pointers go through global tables (e.g. mxName() interns strings),
+	so decoders running on worker threads record them here
+	and they are resolved later, on the calling thread.
+-----------------------------------------------------------------------------
+*/
+struct JsonDeferredValue
+{
+	void *			o;
+	const mxType *	type;			// Type_AssetId or Type_UserData
+	UINT32			stringOffset;	// into JsonDeferredValues::strings
+};
+
+struct JsonDeferredValues
+{
+	TArray< JsonDeferredValue >	values;
+	TArray< char >				strings;	// null-terminated string values
+public:
+	ERet Add( void *o, const mxType& type, const char* stringValue );
+	// sets the values (in the order they were added) and empties the list
+	void Resolve();
+};
+
+/*
+-----------------------------------------------------------------------------
+	JsonStreamDecoder
+
+	SAX-style decoder: parses JSON text and writes values
+	straight into reflected objects (without building a DOM).
+	only objects without pointers are supported.
+-----------------------------------------------------------------------------
+*/
+class JsonStreamDecoder
+{
+public:
+	// the text must be null-terminated, file name and line are used for diagnostics
+	JsonStreamDecoder( const char* text, UINT32 length, const char* file = "", int line = 1 );
+	~JsonStreamDecoder();
+
+	// the index must be built from the same text (see JSON_BuildStructuralIndex()),
+	// then whitespace and strings are skipped without looking at every character
+	void SetStructuralIndex( const UINT32* _tokens, UINT32 _numTokens );
+
+	// String fields will reference the text instead of allocating memory:
+	// strings are unescaped in place and null-terminated (over the closing quotes).
+	// the text passed to the constructor must be writable and must outlive the decoded object.
+	void SetInSitu( char* _text );
+
+	// asset ids and user pointers will be added to the list instead of being set
+	// (required if the decoder runs on a worker thread)
+	void SetDeferredValues( JsonDeferredValues* _deferredValues );
+
+	ERet DecodeObject( void *o, const mxType& type );
+
+private:
+	ERet ReadValue( void *o, const mxType& type );
+	ERet ReadObject( void *o, const mxClass& type );
+	ERet ReadArray( void *o, const mxArray& type );
+	ERet ReadFlags( void *o, const mxFlagsType& type );
+
+	// the returned string points either into the source text or into the scratch buffer
+	ERet ReadString( const char *&_start, UINT32 &_length );
+	// returns a null-terminated string
+	ERet ReadStringZ( const char *&_string );
+	// makes the String reference the unescaped text (in-situ mode)
+	ERet ReadStringInSitu( String &_string );
+	// integers are returned as magnitude and sign (the whole UINT64 range is exact),
+	// numbers with a fraction or an exponent and longer integers are returned as doubles
+	ERet ReadNumber( UINT64 &_magnitude, bool &_isNegative, double &_real, bool &_isInteger );
+	// returns the bits of an integer of any size (two's complement for negative numbers)
+	ERet ReadInteger( UINT64 &_bits );
+	ERet ReadReal( double &_real );
+	ERet ReadLiteral( const char* _literal, UINT32 _length );
+	ERet SkipString();
+	ERet SkipValue();
+
+	void SkipWhitespace();
+	// returns the closing quote of the string starting at the current position (if the index is used)
+	const char* FindClosingQuote();
+	// skips whitespace and the given character, if it's the next one
+	bool Accept( char c );
+	ERet Expect( char c );
+
+	char* AllocScratch( UINT32 _size );
+	ERet Error( const char* message );
+
+private:
+	const char *	m_start;
+	const char *	m_end;
+	const char *	m_curr;
+	const char *	m_file;
+	int				m_line;
+	int				m_depth;
+
+	char *			m_inSituText;	// writable m_start, if strings are decoded in place
+
+	JsonDeferredValues *	m_deferredValues;	// optional
+
+	TArray< char >	m_scratch;	// for unescaped strings
+	UINT32			m_scratchUsed;
+
+	// optional structural index: offsets of tokens
+	const UINT32 *	m_tokens;
+	UINT32			m_numTokens;
+	UINT32			m_nextToken;	// the first token at or after the current position
+};
+
+// parses the stream contents without creating a JSON DOM
+ERet JSON_DecodeStream( AStreamReader& stream, void *o, const mxType& type, const char* file = "", int line = 1 );
+
+// parses the null-terminated text in place, String fields reference the text (see JsonStreamDecoder::SetInSitu())
+ERet JSON_DecodeInSitu( char* text, UINT32 length, void *o, const mxType& type, const char* file = "", int line = 1 );
+
+// the file is mapped (read-only) and parsed without copying it into memory
+ERet JSON_DecodeFile( const char* file, void *o, const mxType& type );
+
+// the file is mapped (copy-on-write) and decoded in place,
+// String fields point into the mapping, so it must stay open while the object is used
+// (a file ending exactly at a page boundary without trailing whitespace is decoded from a copy)
+ERet JSON_DecodeFileInSitu( const char* file, MappedFile &mapping, void *o, const mxType& type );
+
+/*
+-----------------------------------------------------------------------------
+	JsonStreamEncoder
+
+	writes JSON text straight into the stream (without building a DOM),
+	the output is buffered, fields are written in the order of declaration.
+	only objects without pointers can be encoded.
+-----------------------------------------------------------------------------
+*/
+class JsonStreamEncoder : public Reflection::AVisitor2
+{
+public:
+	JsonStreamEncoder( AStreamWriter &stream, const JSON::SaveOptions& options = JSON::SaveOptions() );
+	~JsonStreamEncoder();
+
+	// encodes the object and flushes the output buffer
+	ERet EncodeObject( const void* o, const mxType& type );
+
+	// JSON Lines: writes the object (on a single line, if compact) followed by a newline,
+	// the output is written to the stream only when the buffer is full
+	void EncodeLine( const void* o, const mxType& type );
+	// writes JSON text as-is
+	void WriteRaw( const char* text, UINT32 length );
+	// returns the first write error
+	ERet Flush();
+
+protected:	//-- Reflection::AVisitor2
+	virtual bool Visit_Field( void * _memory, const mxField& _field, const Context& _context ) override;
+	virtual bool Visit_Class( void * _object, const mxClass& _type, const Context& _context ) override;
+	virtual bool Visit_Array( void * _array, const mxArray& _type, const Context& _context ) override;
+	virtual void Visit_POD( void * _memory, const mxType& _type, const Context& _context ) override;
+	virtual void Visit_String( String & _string, const Context& _context ) override;
+	virtual void Visit_TypeId( SClassId * _class, const Context& _context ) override;
+	virtual void Visit_AssetId( AssetID & _assetId, const Context& _context ) override;
+	virtual void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context ) override;
+	virtual void Visit_UserPointer( void * _pointer, const mxUserPointerType& _type, const Context& _context ) override;
+
+private:
+	void WriteObjectFields( void * _object, const mxClass& _type, const Context& _context );
+	// writes the separator and starts a new line
+	void BeginItem();
+	void NewLine();
+	void WriteString( const char* _string, UINT32 _length );
+	void WriteString( const char* _string );
+	void WriteInteger( INT64 _value );
+	void WriteUnsigned( UINT64 _value );
+	void Write( const void* _data, UINT32 _size );
+	void WriteChar( char c );
+
+private:
+	enum { BUFFER_SIZE = 16 * 1024 };
+
+	AStreamWriter &	m_stream;
+	UINT32		m_used;		// number of bytes in the buffer
+	ERet		m_status;	// the first write error
+	int			m_level;	// nesting level, for indentation
+	bool		m_first;	// no items have been written in the current scope
+	const JSON::SaveOptions	m_options;
+	char		m_buffer[ BUFFER_SIZE ];
+};
+
+// encodes the object without creating a JSON DOM
+ERet JSON_EncodeStream( const void* o, const mxType& type, AStreamWriter &stream, const JSON::SaveOptions& options = JSON::SaveOptions() );
+
 json_t* AssetId_To_JSON_String( const AssetID& assetId );
 AssetID JSON_String_To_AssetId( const json_t* jsonValue );
 
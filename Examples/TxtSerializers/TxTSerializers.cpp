@@ -3,12 +3,19 @@
 =============================================================================
 */
 #include <Base/Base.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include <Base/Object/Reflection.h>
+#include <Base/Object/WorkerPool.h>
 #include <Base/Template/Containers/HashMap/TPointerMap.h>
 #include <Core/Core.h>
 #include <Core/Asset.h>
 #include <Core/ObjectModel.h>
 #include <Core/Util/ScopedTimer.h>
+#include <Core/MappedFile.h>
 #include <TxTSupport/TxTCommon.h>
 #include <TxTSupport/TxTReader.h>
 #include <TxTSupport/TxTWriter.h>
@@ -87,6 +94,11 @@ static inline void PutFloat( const Node* _source, const UINT _byteWidth, void *_
 
 static void SON_To_Flags( const Node* _sourceNode, const mxFlagsType& _type, void *_flags )
 {
+	// raw bit mask
+	if( _sourceNode->tag.type == TypeTag_Number ) {
+		_type.m_accessor.Set_Value( _flags, (mxFlagsType::Mask) AsDouble( _sourceNode ) );
+		return;
+	}
 	mxASSERT(_sourceNode->tag.type == TypeTag_List);
 
 	mxFlagsType::Mask integerValue = 0;
@@ -143,9 +155,17 @@ static AssetID SON_To_AssetId( const Node* _sourceNode )
 
 class Decoder : public Reflection::AVisitor
 {
+	// String fields reference the parsed text instead of copying it
+	const bool	m_inSitu;
+
 public:
 	typedef Reflection::AVisitor Super;
 
+	Decoder( bool _inSitu = false )
+		: m_inSitu( _inSitu )
+	{
+	}
+
 	//-- Reflection::AVisitor
 	virtual void* Visit_Field( void * _o, const mxField& _field, void* _userData ) override
 	{
@@ -182,9 +202,13 @@ public:
 		case ETypeKind::Type_Enum :
 			{
 				const mxEnumType& enumType = _type.UpCast< mxEnumType >();
-				const char* sEnumValue = AsString( sourceNode );
-				const UINT nEnumValue = enumType.GetValueByString(sEnumValue);
-				enumType.m_accessor.Set_Value( _o, nEnumValue );
+				if( sourceNode->tag.type == TypeTag_Number ) {
+					enumType.m_accessor.Set_Value( _o, (UINT) AsDouble( sourceNode ) );
+				} else {
+					const char* sEnumValue = AsString( sourceNode );
+					const UINT nEnumValue = enumType.GetValueByString(sEnumValue);
+					enumType.m_accessor.Set_Value( _o, nEnumValue );
+				}
 			}
 			break;
 
@@ -213,7 +237,12 @@ public:
 		mxASSERT(sourceNode->tag.type == TypeTag_String);
 		const char* data = sourceNode->value.s.start;
 		const UINT32 len = sourceNode->value.s.length;
-		Str::CopyS( _string, data, len );
+		if( m_inSitu && len ) {
+			// the parser leaves null-terminated strings in the text buffer
+			_string.SetReference( Chars( data ) );
+		} else {
+			Str::CopyS( _string, data, len );
+		}
 		return _userData;
 	}
 	virtual void* Visit_AssetId( AssetID & _assetId, void* _userData ) override
@@ -271,10 +300,11 @@ public:
 	}
 };
 
-ERet LoadFromBuffer(
+static ERet DecodeBuffer(
 	char* _text, int _size,
 	void *_o, const mxType& _type,
-	const char* _file, int _line
+	const char* _file, int _line,
+	bool _inSitu
 )
 {
 	SON::Parser		parser;
@@ -288,13 +318,31 @@ ERet LoadFromBuffer(
 	chkRET_X_IF_NIL(root, ERR_FAILED_TO_PARSE_DATA);
 	chkRET_X_IF_NOT(parser.errorCode == 0, ERR_FAILED_TO_PARSE_DATA);
 
-	SON::Decoder	decoder;
+	SON::Decoder	decoder( _inSitu );
 
 	Reflection::Walker::Visit( _o, _type, &decoder, root );
 
 	return ALL_OK;
 }
 
+ERet LoadFromBuffer(
+	char* _text, int _size,
+	void *_o, const mxType& _type,
+	const char* _file, int _line
+)
+{
+	return DecodeBuffer( _text, _size, _o, _type, _file, _line, false );
+}
+
+ERet LoadInSitu(
+	char* _text, int _size,
+	void *_o, const mxType& _type,
+	const char* _file, int _line
+)
+{
+	return DecodeBuffer( _text, _size, _o, _type, _file, _line, true );
+}
+
 ERet LoadFromStream(
 	AStreamReader& _stream,
 	void *_o, const mxType& _type,
@@ -312,14 +360,38 @@ ERet LoadFromStream(
 	return ALL_OK;
 }
 
+ERet LoadFromFile(
+	const char* _file,
+	void *_o, const mxType& _type
+)
+{
+	// the parser may write into the text, the modified pages are private copies
+	MappedFile	mapping;
+	mxDO(mapping.Open( _file, FileMap_CopyOnWrite, FileAccess_Sequential ));
+
+	return DecodeBuffer( (char*) mapping.GetData(), mapping.GetSize(), _o, _type, _file, 1, false );
+}
+
+ERet LoadInSituFromFile(
+	const char* _file, MappedFile &_mapping,
+	void *_o, const mxType& _type
+)
+{
+	mxDO(_mapping.Open( _file, FileMap_CopyOnWrite, FileAccess_Sequential ));
+
+	return DecodeBuffer( (char*) _mapping.GetData(), _mapping.GetSize(), _o, _type, _file, 1, true );
+}
+
 class Encoder : public Reflection::AVisitor {
 protected:
-	SON::Allocator &	m_allocator;
+	SON::Allocator &		m_allocator;
+	const SON::SaveOptions	m_options;
 public:
 	typedef Reflection::AVisitor Super;
 
-	Encoder( SON::Allocator & allocator )
+	Encoder( SON::Allocator & allocator, const SON::SaveOptions& options = SON::SaveOptions() )
 		: m_allocator( allocator )
+		, m_options( options )
 	{
 	}
 	//-- Reflection::AVisitor
@@ -363,6 +435,9 @@ public:
 			{
 				const mxEnumType& enumType = _type.UpCast< mxEnumType >();
 				const UINT32 enumValue = enumType.m_accessor.Get_Value( _o );
+				if( m_options.enumsAsIntegers ) {
+					return NewNumber( enumValue, m_allocator );
+				}
 				const char* valueName = enumType.GetStringByValue(enumValue);
 				return NewString( valueName, m_allocator );
 			}
@@ -371,6 +446,9 @@ public:
 		case ETypeKind::Type_Flags :
 			{
 				const mxFlagsType& flagsType = _type.UpCast< mxFlagsType >();
+				if( m_options.flagsAsIntegers ) {
+					return NewNumber( flagsType.m_accessor.Get_Value( _o ), m_allocator );
+				}
 				return Flags_To_SON( _o, flagsType, m_allocator );
 			}
 			break;
@@ -479,22 +557,23 @@ ERet Decode( const Node* _root, const mxType& _type, void *_o )
 	return ALL_OK;
 }
 
-Node* Encode( const void* _o, const mxType& _type, Allocator & _allocator )
+Node* Encode( const void* _o, const mxType& _type, Allocator & _allocator, const SaveOptions& _options )
 {
 //	ScopedTimer		timer( "SON::Encode" );
-	SON::Encoder	encoder( _allocator );
+	SON::Encoder	encoder( _allocator, _options );
 	SON::Node *		root = (Node*) Reflection::Walker::Visit( (void*)_o, _type, &encoder );
 	return root;
 }
 
 ERet SaveToStream(
 				  const void* _o, const mxType& _type,
-				  AStreamWriter &_stream
+				  AStreamWriter &_stream,
+				  const SaveOptions& _options
 				  )
 {
 	Allocator	allocator;
 
-	SON::Node *	root = Encode(_o, _type, allocator);
+	SON::Node *	root = Encode(_o, _type, allocator, _options);
 
 	chkRET_X_IF_NIL(root, ERR_UNKNOWN_ERROR);
 
@@ -511,7 +590,63 @@ struct ObjectInfo
 	const mxClass *	type;
 	UINT32			index;	// unique (sequential) id of this object
 };
-typedef TPointerMap< ObjectInfo, mxPointerHasher >	ObjectMap;
+
+// objects of an object list are stored in a contiguous (strided) array
+struct ObjectListRange
+{
+	const char *	start;		// the first object
+	const char *	end;		// past the last object
+	UINT32			stride;
+	UINT32			baseIndex;	// id of the first object (ids are sequential for each type)
+	const mxClass *	type;
+public:
+	bool operator < ( const ObjectListRange& other ) const
+	{
+		return start < other.start;
+	}
+};
+
+// maps pointers to objects inside the clump to their ids:
+// a binary search over the sorted address ranges of object lists,
+// no memory is allocated per object
+struct ObjectMap
+{
+	TArray< ObjectListRange >	ranges;
+public:
+	bool Find( const void* _pointer, ObjectInfo &_info ) const
+	{
+		const ObjectListRange* ranges = this->ranges.ToPtr();
+		const char* pointer = (const char*) _pointer;
+
+		// find the last range starting at or before the pointer
+		UINT32 lo = 0;
+		UINT32 hi = this->ranges.Num();
+		while( lo < hi )
+		{
+			const UINT32 mid = lo + (hi - lo) / 2;
+			if( ranges[ mid ].start <= pointer ) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		if( lo == 0 ) {
+			return false;
+		}
+		const ObjectListRange& range = ranges[ lo - 1 ];
+		if( pointer >= range.end ) {
+			return false;
+		}
+		const UINT32 offset = (UINT32)( pointer - range.start );
+		if( offset % range.stride ) {
+			return false;	// points inside an object
+		}
+		_info.o = c_cast(void*) _pointer;
+		_info.type = range.type;
+		_info.index = range.baseIndex + offset / range.stride;
+		return true;
+	}
+};
 
 typedef TArray< const ObjectList* >						ObjectListsArray;
 typedef THashMap< const mxClass*, ObjectListsArray >	ObjectListsByType;
@@ -519,7 +654,7 @@ typedef TArray< AObject* >								PolymorphicObjects;
 
 static void CollectObjects( const Clump& _clump, ObjectMap &_map )
 {
-	_map.Empty();
+	_map.ranges.Empty();
 
 	THashMap< TypeID, UINT32 >	instanceCount;
 
@@ -527,7 +662,8 @@ static void CollectObjects( const Clump& _clump, ObjectMap &_map )
 	while( it.IsValid() )
 	{
 		ObjectList& objectList = it.Value();
-		if( objectList.Num() > 0 )
+		const UINT32 objectCount = objectList.Num();
+		if( objectCount > 0 )
 		{
 			const TypeID typeId = objectList.GetType().GetTypeID();
 
@@ -536,29 +672,19 @@ static void CollectObjects( const Clump& _clump, ObjectMap &_map )
 				pCount = &instanceCount.Set( typeId, 0 );
 			}
 
-			{
-				ObjectList::IteratorBase itemIterator( objectList );
-				while( itemIterator.IsValid() )
-				{
-					void* o = itemIterator.ToVoidPtr();
+			ObjectListRange& range = _map.ranges.Add();
+			range.start = (const char*) objectList.GetArrayPtr();
+			range.stride = objectList.GetStride();
+			range.end = range.start + objectCount * range.stride;
+			range.baseIndex = *pCount;
+			range.type = &objectList.GetType();
 
-					ObjectInfo	objectInfo;
-					{
-						objectInfo.o = o;
-						objectInfo.type = &objectList.GetType();
-						objectInfo.index = *pCount;
-					}
-
-					_map.Set( o, objectInfo );
-
-					(*pCount)++;
-
-					itemIterator.MoveToNext();
-				}
-			}
+			(*pCount) += objectCount;
 		}
 		it.MoveToNext();
 	}
+
+	std::sort( _map.ranges.ToPtr(), _map.ranges.ToPtr() + _map.ranges.Num() );
 }
 
 static void CollectObjectLists( const Clump& _clump, ObjectListsByType &_objectLists )
@@ -593,18 +719,18 @@ static Node* InternalPointerToJsonValue(
 
 	// If the pointer points at some object inside the _clump, then serialize the pointer as an object index.
 
-	const ObjectInfo* objectInfo = _map.Find( _pointerTarget );
-	if(PtrToBool( objectInfo ))
+	ObjectInfo	objectInfo;
+	if( _map.Find( _pointerTarget, objectInfo ) )
 	{
-		mxASSERT( objectInfo->type->IsDerivedFrom( _pointee ) );
-		mxASSERT(objectInfo->index != INDEX_NONE);
+		mxASSERT( objectInfo.type->IsDerivedFrom( _pointee ) );
+		mxASSERT(objectInfo.index != INDEX_NONE);
 
-		const mxClass& pointeeType = *objectInfo->type;
+		const mxClass& pointeeType = *objectInfo.type;
 
 		Node* pointerNode = NewObject(_allocator);
 
 		Node *	pointeeTypeNode = NewString( pointeeType.m_name.buffer, pointeeType.m_name.length, _allocator );
-		Node *	objectIndexNode = NewNumber( objectInfo->index, _allocator );
+		Node *	objectIndexNode = NewNumber( objectInfo.index, _allocator );
 
 		AddChild( pointerNode, OBJECT_CLASS_TAG, pointeeTypeNode );
 		AddChild( pointerNode, OBJECT_INDEX_TAG, objectIndexNode );
@@ -650,7 +776,8 @@ static Node* EncodeObjectStoredInClump(
 									   const mxType& _type,
 									   const Clump& _clump,
 									   const ObjectMap& _objectMap,
-									   SON::Allocator & _allocator
+									   SON::Allocator & _allocator,
+									   const SaveOptions& _options
 									   )
 {
 	class ObjectEncoder : public SON::Encoder
@@ -658,8 +785,8 @@ static Node* EncodeObjectStoredInClump(
 		const Clump &		m_clump;
 		const ObjectMap &	m_objectMap;
 	public:
-		ObjectEncoder( const Clump& _clump, const ObjectMap& _objectMap, SON::Allocator & _allocator )
-			: m_clump( _clump ), m_objectMap( _objectMap ), SON::Encoder( _allocator )
+		ObjectEncoder( const Clump& _clump, const ObjectMap& _objectMap, SON::Allocator & _allocator, const SaveOptions& _options )
+			: m_clump( _clump ), m_objectMap( _objectMap ), SON::Encoder( _allocator, _options )
 		{}
 		virtual void* Visit_Pointer( VoidPointer& p, const mxPointerType& type, void* _userData ) override
 		{
@@ -675,7 +802,7 @@ static Node* EncodeObjectStoredInClump(
 			return InternalPointerToJsonValue( target, pointeeBaseClass, m_clump, m_objectMap, m_allocator );
 		}
 	};
-	ObjectEncoder	encoder( _clump, _objectMap, _allocator );
+	ObjectEncoder	encoder( _clump, _objectMap, _allocator, _options );
 	return (Node*) Reflection::Walker::Visit( (void*)_o, _type, &encoder );
 }
 
@@ -727,7 +854,7 @@ ERet SaveClump(
 					while( itemIterator.IsValid() )
 					{
 						void* o = itemIterator.ToVoidPtr();
-						Node* objectNode = EncodeObjectStoredInClump(o, type, _clump, objectMap, allocator);
+						Node* objectNode = EncodeObjectStoredInClump(o, type, _clump, objectMap, allocator, _options);
 						if( objectNode ) {
 							mxOPTIMIZE("remove O(N^2)");
 							AppendChild( objectListDataNode, objectNode );
@@ -763,112 +890,217 @@ ERet SaveClumpToFile( const Clump& _clump, const char* _file )
 	return ALL_OK;
 }
 
-// populate the empty object list with parsed data
-static void LoadObjectList( const Node* _objectListNode, ObjectList &_objectList, Clump & _clump )
+/*
+	Object lists are decoded in parallel:
+	1) all object lists are created and all objects are allocated (on the calling thread),
+	   so every object has its final address before decoding starts;
+	2) workers construct and decode objects, taking chunks from a flat array of objects
+	   (so that large lists are split and small ones are batched together),
+	   pointers and asset ids are not resolved, but recorded as fixups;
+	3) pointers to objects are patched in parallel (only lookups in the clump),
+	   asset ids and asset references use global tables, so they are resolved on the calling thread.
+*/
+enum
 {
-	mxASSERT(_objectListNode->tag.type == TypeTag_List);
+	MAX_LOADER_THREADS = Reflection::MAX_WORKERS,
+	OBJECTS_PER_TASK = 64,	// objects decoded by a worker at once
+};
 
-	class ObjectDecoder : public SON::Decoder
-	{
-		Clump &	m_clump;
+// a pointer or an asset id which is resolved after all objects have been decoded
+struct ObjectFixup
+{
+	void *					target;		// VoidPointer or AssetID
+	const Node *			sourceNode;
+	const mxPointerType *	pointerType;	// null for asset ids
+};
 
-	public:
-		ObjectDecoder( Clump & _clump )
-			: m_clump( _clump )
-		{}
-		virtual void* Visit_Pointer( VoidPointer& _pointer, const mxPointerType& _type, void* _userData ) override
+struct ObjectToLoad
+{
+	CStruct *		o;
+	const mxClass *	type;
+	const Node *	sourceNode;
+};
+
+struct ClumpLoadTask
+{
+	Clump *					clump;
+	const ObjectToLoad *	objects;
+	UINT32					numObjects;
+	std::atomic< UINT32 >	nextObject;
+	TArray< ObjectFixup >	fixups[ MAX_LOADER_THREADS ];	// per worker
+};
+
+// decodes everything except pointers and asset ids
+class ObjectDecoder : public SON::Decoder
+{
+	TArray< ObjectFixup > &	m_fixups;
+
+public:
+	ObjectDecoder( TArray< ObjectFixup > & _fixups )
+		: m_fixups( _fixups )
+	{}
+	virtual void* Visit_Pointer( VoidPointer& _pointer, const mxPointerType& _type, void* _userData ) override
+	{
+		if( !_type.pointee.IsClass() )
 		{
-			if( !_type.pointee.IsClass() )
-			{
-				ptERROR("JSON deserializer : Only pointers to CStruct-derived objects are supported!");
-				return nil;
-			}
-			const mxClass& pointeeBaseClass = _type.pointee.UpCast< mxClass >();
-			const Node*	sourceNode = static_cast< Node* >( _userData );
-			mxASSERT_PTR(sourceNode);
+			ptERROR("JSON deserializer : Only pointers to CStruct-derived objects are supported!");
+			return nil;
+		}
+		ObjectFixup& fixup = m_fixups.Add();
+		fixup.target = &_pointer;
+		fixup.sourceNode = static_cast< Node* >( _userData );
+		fixup.pointerType = &_type;
+		mxASSERT_PTR(fixup.sourceNode);
+		return _userData;
+	}
+	virtual void* Visit_AssetId( AssetID & o, void* _userData ) override
+	{
+		ObjectFixup& fixup = m_fixups.Add();
+		fixup.target = &o;
+		fixup.sourceNode = static_cast< Node* >( _userData );
+		fixup.pointerType = nil;
+		mxASSERT_PTR(fixup.sourceNode);
+		return _userData;
+	}
+};
 
-			// check if this is a null pointer or a pointer to the fallback instance
-			if( sourceNode->tag.type == TypeTag_Number )
-			{
-				const int integerValue = (int) AsDouble(sourceNode);
-				if( integerValue == NULL_POINTER_TAG ) {
-					_pointer.o = nil;
-				} else {
-					mxASSERT(integerValue == FALLBACK_INSTANCE_TAG);
-					_pointer.o = pointeeBaseClass.fallbackInstance;
-				}
-			}
-			// check if this is an object id
-			else if( sourceNode->tag.type == TypeTag_Object )
-			{
-				const char* typeName = AsString( FindValue(sourceNode, OBJECT_CLASS_TAG) );
-				const mxClass* pointeeClass = TypeRegistry::Get().FindClassByName( typeName );
-				mxASSERT_PTR(pointeeClass);
-				// NOTE: serialized clumps have unique object lists (1-1 correspondence between class and object list)
-				ObjectList* objectList = FindFirstObjectListOfType( m_clump, *pointeeClass );
-				mxASSERT_PTR(objectList);
-				if( objectList ) {
-					const UINT32 objectIndex = (UINT32) AsDouble( FindValue(sourceNode, OBJECT_INDEX_TAG) );
-					_pointer.o = objectList->GetItemAtIndex( objectIndex );
-				}
-			}
-#if ENABLE_ASSET_LOADING
-			// check if this is an asset id
-			else if( sourceNode->tag.type == TypeTag_String )
-			{
-				const AssetID assetId = SON_To_AssetId( sourceNode );
-				const AssetType assetType = &pointeeBaseClass;
-				_pointer.o = Assets::FindInstance(AssetKey( assetId, assetType ));
-				if( !_pointer.o ) {
-					_pointer.o = assetType->fallbackInstance;
-				}			
-			}
-#endif // ENABLE_ASSET_LOADING
-			else {
-				ptERROR("JSON loader: couldn't resolve pointer of _type '%s'\n", _type.GetTypeName());
-			}
-			return _userData;
+// references to external assets must be resolved on the calling thread
+static bool IsAssetReference( const ObjectFixup& _fixup )
+{
+	return _fixup.pointerType == nil || _fixup.sourceNode->tag.type == TypeTag_String;
+}
+
+static void ResolvePointer( const ObjectFixup& _fixup, Clump & _clump )
+{
+	const mxPointerType& pointerType = *_fixup.pointerType;
+	const mxClass& pointeeBaseClass = pointerType.pointee.UpCast< mxClass >();
+	const Node*	sourceNode = _fixup.sourceNode;
+	VoidPointer& pointer = *static_cast< VoidPointer* >( _fixup.target );
+
+	// check if this is a null pointer or a pointer to the fallback instance
+	if( sourceNode->tag.type == TypeTag_Number )
+	{
+		const int integerValue = (int) AsDouble(sourceNode);
+		if( integerValue == NULL_POINTER_TAG ) {
+			pointer.o = nil;
+		} else {
+			mxASSERT(integerValue == FALLBACK_INSTANCE_TAG);
+			pointer.o = pointeeBaseClass.fallbackInstance;
 		}
-		virtual void* Visit_AssetId( AssetID & o, void* _userData ) override
-		{
-			const Node*	sourceNode = static_cast< Node* >( _userData );
-			mxASSERT_PTR(sourceNode);
-			o = SON_To_AssetId( sourceNode );
-			return _userData;
+	}
+	// check if this is an object id
+	else if( sourceNode->tag.type == TypeTag_Object )
+	{
+		const char* typeName = AsString( FindValue(sourceNode, OBJECT_CLASS_TAG) );
+		const mxClass* pointeeClass = TypeRegistry::Get().FindClassByName( typeName );
+		mxASSERT_PTR(pointeeClass);
+		// NOTE: serialized clumps have unique object lists (1-1 correspondence between class and object list)
+		ObjectList* objectList = FindFirstObjectListOfType( _clump, *pointeeClass );
+		mxASSERT_PTR(objectList);
+		if( objectList ) {
+			const UINT32 objectIndex = (UINT32) AsDouble( FindValue(sourceNode, OBJECT_INDEX_TAG) );
+			pointer.o = objectList->GetItemAtIndex( objectIndex );
 		}
-	};
+	}
+#if ENABLE_ASSET_LOADING
+	// check if this is an asset id
+	else if( sourceNode->tag.type == TypeTag_String )
+	{
+		const AssetID assetId = SON_To_AssetId( sourceNode );
+		const AssetType assetType = &pointeeBaseClass;
+		pointer.o = Assets::FindInstance(AssetKey( assetId, assetType ));
+		if( !pointer.o ) {
+			pointer.o = assetType->fallbackInstance;
+		}			
+	}
+#endif // ENABLE_ASSET_LOADING
+	else {
+		ptERROR("JSON loader: couldn't resolve pointer of _type '%s'\n", pointerType.GetTypeName());
+	}
+}
 
-	const mxClass& objectType = _objectList.GetType();
+static void ResolveAssetReference( const ObjectFixup& _fixup, Clump & _clump )
+{
+	if( _fixup.pointerType ) {
+		ResolvePointer( _fixup, _clump );
+	} else {
+		*static_cast< AssetID* >( _fixup.target ) = SON_To_AssetId( _fixup.sourceNode );
+	}
+}
 
-	const Node* objectNode = _objectListNode->value.l.kids;
-	while( objectNode )
+static void DecodeObjects( ClumpLoadTask & _task, UINT32 _workerIndex )
+{
+	ObjectDecoder	decoder( _task.fixups[ _workerIndex ] );
+	for(;;)
 	{
-		CStruct* o = _objectList.Allocate();
+		const UINT32 begin = _task.nextObject.fetch_add( OBJECTS_PER_TASK );
+		if( begin >= _task.numObjects ) {
+			break;
+		}
+		const UINT32 end = smallest( begin + OBJECTS_PER_TASK, _task.numObjects );
+		for( UINT32 iObject = begin; iObject < end; iObject++ )
+		{
+			const ObjectToLoad& objectToLoad = _task.objects[ iObject ];
 
-		// call the default constructor
-		objectType.ConstructInPlace( o );
+			// call the default constructor
+			objectToLoad.type->ConstructInPlace( objectToLoad.o );
 
-		// deserialize the object
-		ObjectDecoder	decoder( _clump );
-		Reflection::Walker::Visit( o, objectType, &decoder, (void*)objectNode );
+			// deserialize the object
+			Reflection::Walker::Visit( objectToLoad.o, *objectToLoad.type, &decoder, (void*)objectToLoad.sourceNode );
+		}
+	}
+}
 
-		objectNode = objectNode->next;
+static void ResolveObjectPointers( ClumpLoadTask & _task, UINT32 _workerIndex )
+{
+	const TArray< ObjectFixup >& fixups = _task.fixups[ _workerIndex ];
+	for( UINT32 iFixup = 0; iFixup < fixups.Num(); iFixup++ )
+	{
+		const ObjectFixup& fixup = fixups[ iFixup ];
+		if( !IsAssetReference( fixup ) ) {
+			ResolvePointer( fixup, *_task.clump );
+		}
 	}
 }
 
-ERet LoadClump(
-		AStreamReader &_stream, Clump &_clump,
+// populates the empty object lists with parsed data
+static void LoadObjectLists( const ObjectToLoad* _objects, UINT32 _numObjects, Clump & _clump )
+{
+	ClumpLoadTask	task;
+	task.clump = &_clump;
+	task.objects = _objects;
+	task.numObjects = _numObjects;
+	task.nextObject.store( 0 );
+
+	UINT32 numWorkers = largest( std::thread::hardware_concurrency(), 1U );
+	numWorkers = smallest( numWorkers, (_numObjects + OBJECTS_PER_TASK - 1) / OBJECTS_PER_TASK );
+	numWorkers = smallest( numWorkers, (UINT32)MAX_LOADER_THREADS );
+	numWorkers = largest( numWorkers, 1U );
+
+	// the calling thread is the first worker, the others run on the shared pool
+	Reflection::RunOnWorkers( &DecodeObjects, task, numWorkers );
+	Reflection::RunOnWorkers( &ResolveObjectPointers, task, numWorkers );
+
+	for( UINT32 iWorker = 0; iWorker < numWorkers; iWorker++ )
+	{
+		const TArray< ObjectFixup >& fixups = task.fixups[ iWorker ];
+		for( UINT32 iFixup = 0; iFixup < fixups.Num(); iFixup++ )
+		{
+			if( IsAssetReference( fixups[ iFixup ] ) ) {
+				ResolveAssetReference( fixups[ iFixup ], _clump );
+			}
+		}
+	}
+}
+
+static ERet LoadClumpFromBuffer(
+		char* _text, UINT32 _size, Clump &_clump,
 		const char* _file, int _line
 	)
 {
-	chkRET_X_IF_NOT( _clump.IsEmpty(), ERR_INVALID_PARAMETER );
-
-	ByteBuffer	fileData;
-	mxDO(Util_LoadStreamToBlob(_stream, fileData));
-
 	SON::Parser		parser;
-	parser.buffer = fileData.ToPtr();
-	parser.length = fileData.GetDataSize();
+	parser.buffer = _text;
+	parser.length = _size;
 	parser.file = _file;
 	parser.line = _line;
 
@@ -879,6 +1111,19 @@ ERet LoadClump(
 	return LoadClump(root, _clump);
 }
 
+ERet LoadClump(
+		AStreamReader &_stream, Clump &_clump,
+		const char* _file, int _line
+	)
+{
+	chkRET_X_IF_NOT( _clump.IsEmpty(), ERR_INVALID_PARAMETER );
+
+	ByteBuffer	fileData;
+	mxDO(Util_LoadStreamToBlob(_stream, fileData));
+
+	return LoadClumpFromBuffer( (char*) fileData.ToPtr(), fileData.GetDataSize(), _clump, _file, _line );
+}
+
 ERet LoadClump( const SON::Node* root, Clump &_clump )
 {
 	// read headerNode
@@ -896,24 +1141,14 @@ ERet LoadClump( const SON::Node* root, Clump &_clump )
 	}
 
 	// load object lists
-	// 1) create object lists, initialize objects with default constructors
-	// 2) patch pointers, resolve cross references
-	// 3) resolve references to external assets, finalize asset instances
+	// 1) create object lists, allocate objects
+	// 2) initialize objects with default constructors, decode them (in parallel)
+	// 3) patch pointers, resolve cross references and references to external assets
 	{
 		const Node*	objectListsNode = FindValue( root, NODE_DATA_TAG );
 		mxASSERT(objectListsNode->tag.type == TypeTag_List);
 
-		const UINT numObjectLists = objectListsNode->value.l.size;
-
-		struct ObjectListInfo
-		{
-			const Node *	sourceNode;	// OBJECT_ARRAY_TAG
-			ObjectList *	objectList;
-		};
-		ObjectListInfo				localStorage[64];
-		TArray< ObjectListInfo >	objectListsInfos(localStorage, mxCOUNT_OF(localStorage));
-
-		objectListsInfos.Reserve(numObjectLists);
+		TArray< ObjectToLoad >	objectsToLoad;
 
 		const Node* objectListNode = objectListsNode->value.l.kids;
 		while( objectListNode )
@@ -932,18 +1167,24 @@ ERet LoadClump( const SON::Node* root, Clump &_clump )
 
 			ObjectList* newObjectList = _clump.CreateObjectList( *classInfo, maxItemCount );
 
-			ObjectListInfo& newObjectListInfo = objectListsInfos.Add();
-			newObjectListInfo.sourceNode = objectDataNode;
-			newObjectListInfo.objectList = newObjectList;
+			mxASSERT(objectDataNode->tag.type == TypeTag_List);
+			const Node* objectNode = objectDataNode->value.l.kids;
+			while( objectNode )
+			{
+				ObjectToLoad& objectToLoad = objectsToLoad.Add();
+				objectToLoad.o = newObjectList->Allocate();
+				objectToLoad.type = classInfo;
+				objectToLoad.sourceNode = objectNode;
+
+				objectNode = objectNode->next;
+			}
 
 			objectListNode = objectListNode->next;
 		}
 
 		// deserialize POD objects (stored in ObjectLists inside Clumps)
-		for( UINT iObjectList = 0; iObjectList < numObjectLists; iObjectList++ )
-		{
-			const ObjectListInfo& objectListInfo = objectListsInfos[ iObjectList ];
-			LoadObjectList( objectListInfo.sourceNode, *objectListInfo.objectList, _clump );
+		if( objectsToLoad.Num() ) {
+			LoadObjectLists( objectsToLoad.ToPtr(), objectsToLoad.Num(), _clump );
 		}
 	}
 	return ALL_OK;
@@ -951,9 +1192,13 @@ ERet LoadClump( const SON::Node* root, Clump &_clump )
 
 ERet LoadClumpFromFile( const char* _file, Clump &_clump )
 {
-	FileReader	reader;
-	mxDO(reader.Open(_file));
-	return LoadClump(reader, _clump);
+	chkRET_X_IF_NOT( _clump.IsEmpty(), ERR_INVALID_PARAMETER );
+
+	// strings are copied into objects, so the mapping is closed after loading
+	MappedFile	mapping;
+	mxDO(mapping.Open( _file, FileMap_CopyOnWrite, FileAccess_Sequential ));
+
+	return LoadClumpFromBuffer( (char*) mapping.GetData(), mapping.GetSize(), _clump, _file, 1 );
 }
 
 }//namespace SON
@@ -3,14 +3,20 @@
 #include <Utility/TxTSupport/TxTCommon.h>
 
 class Clump;
+class MappedFile;
 
 namespace SON
 {
+	// the loaders accept both forms of enums and flags
 	struct SaveOptions {
 		bool	wrapRootInBraces;
+		bool	enumsAsIntegers;	// enums are written as numbers instead of names
+		bool	flagsAsIntegers;	// flags are written as raw bit masks instead of lists of names
 	public:
 		SaveOptions() {
 			wrapRootInBraces = false;
+			enumsAsIntegers = false;
+			flagsAsIntegers = false;
 		}
 	};
 
@@ -22,6 +28,14 @@ namespace SON
 		const char* _file = "", int _line = 1
 	);
 
+	// String fields are not copied, they reference the (modified) text,
+	// so the text must not be freed while the object is used.
+	ERet LoadInSitu(
+		char* _text, int _size,
+		void *_o, const mxType& _type,
+		const char* _file = "", int _line = 1
+	);
+
 	ERet LoadFromStream(
 		AStreamReader& _stream,
 		void *_o, const mxType& _type,
@@ -34,13 +48,23 @@ namespace SON
 		return LoadFromStream( _stream, &_o, mxTYPE_OF(_o) );
 	}
 
+	// the file is memory-mapped instead of being read into memory
+	ERet LoadFromFile(
+		const char* _file,
+		void *_o, const mxType& _type
+	);
+
+	// String fields reference the copy-on-write mapping of the file (see LoadInSitu()),
+	// the mapping must stay open while the object is used.
+	ERet LoadInSituFromFile(
+		const char* _file, MappedFile &_mapping,
+		void *_o, const mxType& _type
+	);
+
 	template< typename TYPE >
 	ERet LoadFromFile( const char* _file, TYPE &_o )
 	{
-		FileReader	stream;
-		mxTRY(stream.Open( _file, FileRead_NoErrors ));
-		mxTRY(LoadFromStream( stream, &_o, mxTYPE_OF(_o), _file ));
-		return ALL_OK;
+		return LoadFromFile( _file, &_o, mxTYPE_OF(_o) );
 	}
 
 	ERet Decode( const Node* _root, const mxType& _type, void *_o );
@@ -51,7 +75,10 @@ namespace SON
 		return Decode( _root, mxTYPE_OF(_o), &_o );
 	}
 
-	Node* Encode( const void* _o, const mxType& _type, Allocator & _allocator );
+	Node* Encode(
+		const void* _o, const mxType& _type, Allocator & _allocator,
+		const SaveOptions& _options = SaveOptions()
+	);
 
 	template< typename TYPE >
 	Node* Encode( const TYPE& _o, Allocator & _allocator )
@@ -61,13 +88,14 @@ namespace SON
 
 	ERet SaveToStream(
 		const void* _o, const mxType& _type,
-		AStreamWriter &_stream
+		AStreamWriter &_stream,
+		const SaveOptions& _options = SaveOptions()
 	);
 
 	template< typename TYPE >
-	ERet Save( const TYPE& _o, AStreamWriter &_stream )
+	ERet Save( const TYPE& _o, AStreamWriter &_stream, const SaveOptions& _options = SaveOptions() )
 	{
-		return SaveToStream( &_o, mxTYPE_OF(_o), _stream );
+		return SaveToStream( &_o, mxTYPE_OF(_o), _stream, _options );
 	}
 
 	template< typename TYPE >
@@ -1,4 +1,5 @@
 #include <Base/Base.h>
+#include <Base/Object/NumberText.h>
 #include "pugixml.hpp"
 #include "XmlSupport.h"
 
@@ -38,31 +39,47 @@ static void PutInteger( const UINT32 value, void *pointer, const int byteWidth )
 	}
 }
 
-static double GetDouble( const void* pointer, const int byteWidth )
+static void PutDouble( const double value, const void* pointer, const int byteWidth )
 {
 	if( byteWidth == 4 ) {
-		return *(float*) pointer;
+		*(float*) pointer = value;
 	}
 	else if( byteWidth == 8 ) {
-		return *(double*) pointer;
+		*(double*) pointer = value;
 	}
 	else {
 		mxUNREACHABLE;
-		return 0;
 	}
 }
 
-static void PutDouble( const double value, const void* pointer, const int byteWidth )
+// shortest text which is read back as the same value
+struct FloatText
 {
+	char	text[ Reflection::MAX_NUMBER_TEXT_LENGTH ];
+};
+static FloatText FloatToString( const void* pointer, const int byteWidth )
+{
+	FloatText result;
 	if( byteWidth == 4 ) {
-		*(float*) pointer = value;
+		Reflection::FormatFloat( *(float*) pointer, result.text );
 	}
 	else if( byteWidth == 8 ) {
-		*(double*) pointer = value;
+		Reflection::FormatDouble( *(double*) pointer, result.text );
 	}
 	else {
 		mxUNREACHABLE;
+		result.text[0] = '\0';
 	}
+	return result;
+}
+
+static double StringToDouble( const char* text )
+{
+	double value = 0;
+	if( !Reflection::ParseDouble( text, value ) ) {
+		value = 0;
+	}
+	return value;
 }
 
 static void Flags_To_XML( const void* o, const mxFlagsType& type, pugi::xml_node &node )
@@ -80,6 +97,12 @@ static void Flags_To_XML( const void* o, const mxFlagsType& type, pugi::xml_node
 
 static void XML_To_Flags( const pugi::xml_node& node, const mxFlagsType& type, void *o )
 {
+	// raw bit mask
+	const pugi::xml_attribute maskValue = node.attribute("value");
+	if( maskValue ) {
+		type.m_accessor.Set_Value(o, maskValue.as_uint());
+		return;
+	}
 	pugi::xml_node child = node.first_child();
 	const UINT numBits = type.m_numFlags;
 	UINT bitMask = 0;
@@ -98,9 +121,15 @@ static void XML_To_Flags( const pugi::xml_node& node, const mxFlagsType& type, v
 }
 
 class XmlEncoder : public Reflection::AVisitor {
+	const SaveOptions	m_options;
 public:
 	typedef Reflection::AVisitor Super;
 
+	XmlEncoder( const SaveOptions& options )
+		: m_options( options )
+	{
+	}
+
 	//-- Reflection::AVisitor
 	virtual void Visit_POD( void * o, const mxType& type, void* _userData ) override
 	{
@@ -124,7 +153,7 @@ public:
 		case ETypeKind::Type_Float :
 			{
 				pugi::xml_attribute value = node.append_attribute("value");
-				value.set_value(GetDouble(o, typeSize));
+				value.set_value(FloatToString(o, typeSize).text);
 			}
 			break;
 
@@ -140,14 +169,22 @@ public:
 				pugi::xml_attribute value = node.append_attribute("value");
 				const mxEnumType& enumType = type.UpCast< mxEnumType >();
 				const UINT32 enumValue = enumType.m_accessor.Get_Value( o );
-				value.set_value( enumType.GetStringByInteger(enumValue) );
+				if( m_options.enumsAsIntegers ) {
+					value.set_value( enumValue );
+				} else {
+					value.set_value( enumType.GetStringByInteger(enumValue) );
+				}
 			}
 			break;
 
 		case ETypeKind::Type_Flags :
 			{
 				const mxFlagsType& flagsType = type.UpCast< mxFlagsType >();
-				Flags_To_XML( o, flagsType, node );
+				if( m_options.flagsAsIntegers ) {
+					node.append_attribute("value").set_value( flagsType.m_accessor.Get_Value( o ) );
+				} else {
+					Flags_To_XML( o, flagsType, node );
+				}
 			}
 			break;
 
@@ -237,7 +274,7 @@ public:
 		case ETypeKind::Type_Float :
 			{
 				const pugi::xml_attribute value = node.attribute("value");
-				PutDouble(value.as_double(), o, typeSize);
+				PutDouble(StringToDouble(value.as_string()), o, typeSize);
 			}
 			break;
 
@@ -252,7 +289,10 @@ public:
 			{
 				pugi::xml_attribute value = node.attribute("value");
 				const mxEnumType& enumType = type.UpCast< mxEnumType >();
-				const UINT32 enumValue = enumType.GetIntegerByString( value.value() );
+				const char* valueText = value.value();
+				const UINT32 enumValue = ( valueText[0] >= '0' && valueText[0] <= '9' )
+					? value.as_uint()
+					: enumType.GetIntegerByString( valueText );
 				enumType.m_accessor.Set_Value( o, enumValue );
 			}
 			break;
@@ -326,11 +366,11 @@ public:
 	}
 };
 
-ERet EncodeObject( const void* o, const mxType& type, AStreamWriter &stream )
+ERet EncodeObject( const void* o, const mxType& type, AStreamWriter &stream, const SaveOptions& options )
 {
 	pugi::xml_document	doc;
 
-	XmlEncoder	encoder;
+	XmlEncoder	encoder( options );
 	encoder.Visit_Element( (void*)o, type, &doc );
 
 	class My_XML_Writer : public pugi::xml_writer
@@ -344,7 +384,11 @@ ERet EncodeObject( const void* o, const mxType& type, AStreamWriter &stream )
 		}
 	};
 	My_XML_Writer	streamWriter( stream );
-	doc.save( streamWriter );
+	if( options.compact ) {
+		doc.save( streamWriter, "", pugi::format_raw );
+	} else {
+		doc.save( streamWriter );
+	}
 
 	return ALL_OK;
 }
@@ -8,7 +8,23 @@
 
 namespace XML
 {
-	ERet EncodeObject( const void* o, const mxType& type, AStreamWriter &stream );
+	// the decoder accepts both forms of enums and flags
+	// NOTE: non-ASCII characters are always written as UTF-8.
+	struct SaveOptions
+	{
+		bool	compact;			// no indentation and line breaks
+		bool	enumsAsIntegers;	// enums are written as numbers instead of names
+		bool	flagsAsIntegers;	// flags are written as a raw bit mask ('value' attribute)
+	public:
+		SaveOptions()
+		{
+			compact = false;
+			enumsAsIntegers = false;
+			flagsAsIntegers = false;
+		}
+	};
+
+	ERet EncodeObject( const void* o, const mxType& type, AStreamWriter &stream, const SaveOptions& options = SaveOptions() );
 	ERet DecodeObject( AStreamReader& reader, const mxType& type, void *o );
 }//namespace XML
 
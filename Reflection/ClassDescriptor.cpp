@@ -47,6 +47,8 @@ mxClass::mxClass(
 	ass = nil;
 	editorInfo = nil;
 	allocationGranularity = 1;
+	plan = nil;
+	fieldIndex = nil;
 }
 
 bool mxClass::IsDerivedFrom( const mxClass& other ) const
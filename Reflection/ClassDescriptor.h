@@ -222,6 +222,9 @@ public:
 
 	UINT32		allocationGranularity;	// new objects in clumps should be allocated in batches
 
+	mutable const struct mxClassPlan *	plan;	// flattened layout, see Reflection::GetClassPlan()
+	mutable const struct mxFieldIndex *	fieldIndex;	// lookup by name, see Reflection::GetFieldIndex()
+
 private:
 	NO_COPY_CONSTRUCTOR( mxClass );
 	NO_ASSIGNMENT( mxClass );
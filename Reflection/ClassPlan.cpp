@@ -0,0 +1,255 @@
+/*
+=============================================================================
+	File:	ClassPlan.cpp
+	Desc:	Flattened class layouts for fast comparing/hashing/copying
+			of reflected objects.
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <Base/Object/ClassDescriptor.h>
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/ClassPlan.h>
+
+namespace Reflection
+{
+
+static void AddBytes( mxClassPlan & _plan, UINT32 _offset, UINT32 _size )
+{
+	// merge with the previous span, if they are adjacent
+	if( _plan.ops.Num() )
+	{
+		mxPlanOp & lastOp = _plan.ops[ _plan.ops.Num() - 1 ];
+		if( lastOp.op == PlanOp_Bytes && lastOp.offset + lastOp.size == _offset )
+		{
+			lastOp.size += _size;
+			return;
+		}
+	}
+	mxPlanOp & newOp = _plan.ops.Add();
+	newOp.op = PlanOp_Bytes;
+	newOp.offset = _offset;
+	newOp.size = _size;
+	newOp.type = nil;
+}
+
+static void AddOp( mxClassPlan & _plan, EPlanOp _op, UINT32 _offset, const mxType& _type )
+{
+	mxPlanOp & newOp = _plan.ops.Add();
+	newOp.op = _op;
+	newOp.offset = _offset;
+	newOp.size = _type.m_size;
+	newOp.type = &_type;
+}
+
+static void FlattenClass( mxClassPlan & _plan, const mxClass& _type, UINT32 _baseOffset );
+
+static void FlattenField( mxClassPlan & _plan, const mxType& _type, UINT32 _offset )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Integer :
+	case ETypeKind::Type_Float :
+	case ETypeKind::Type_Bool :
+	case ETypeKind::Type_Enum :
+	case ETypeKind::Type_Flags :
+		AddBytes( _plan, _offset, _type.m_size );
+		break;
+
+	case ETypeKind::Type_String :
+		AddOp( _plan, PlanOp_String, _offset, _type );
+		break;
+
+	case ETypeKind::Type_Class :
+		FlattenClass( _plan, _type.UpCast< mxClass >(), _offset );
+		break;
+
+	case ETypeKind::Type_Pointer :
+		AddOp( _plan, PlanOp_Pointer, _offset, _type );
+		break;
+
+	case ETypeKind::Type_AssetId :
+		AddOp( _plan, PlanOp_AssetId, _offset, _type );
+		break;
+
+	case ETypeKind::Type_ClassId :
+		AddOp( _plan, PlanOp_ClassId, _offset, _type );
+		break;
+
+	case ETypeKind::Type_UserData :
+		AddOp( _plan, PlanOp_UserPointer, _offset, _type );
+		break;
+
+	case ETypeKind::Type_Array :
+		AddOp( _plan, PlanOp_Array, _offset, _type );
+		break;
+
+	case ETypeKind::Type_Blob :
+		Unimplemented;
+		break;
+
+		mxNO_SWITCH_DEFAULT;
+	}
+}
+
+static void FlattenClass( mxClassPlan & _plan, const mxClass& _type, UINT32 _baseOffset )
+{
+	// base classes start at offset 0
+	const mxClass* parentType = _type.GetParent();
+	if( parentType != nil ) {
+		FlattenClass( _plan, *parentType, _baseOffset );
+	}
+
+	const mxClassLayout& layout = _type.GetLayout();
+	for( UINT fieldIndex = 0; fieldIndex < layout.numFields; fieldIndex++ )
+	{
+		const mxField& field = layout.fields[ fieldIndex ];
+		FlattenField( _plan, field.type, _baseOffset + field.offset );
+	}
+}
+
+static mxClassPlan* CreateClassPlan( const mxClass& _type )
+{
+	mxClassPlan* plan = new mxClassPlan();
+
+	FlattenClass( *plan, _type, 0 );
+
+	plan->isPlain = true;
+	for( UINT32 i = 0; i < plan->ops.Num(); i++ )
+	{
+		if( plan->ops[i].op != PlanOp_Bytes ) {
+			plan->isPlain = false;
+			break;
+		}
+	}
+
+	plan->isDense = plan->isPlain
+		&& plan->ops.Num() == 1
+		&& plan->ops[0].offset == 0
+		&& plan->ops[0].size == _type.m_size
+		;
+
+	// conservative, until the contents have been computed (for recursive types)
+	plan->contents = TypeHas_Everything;
+
+	return plan;
+}
+
+static UINT32 ComputeContents( const mxClassPlan& _plan )
+{
+	UINT32 contents = 0;
+	for( UINT32 i = 0; i < _plan.ops.Num(); i++ )
+	{
+		const mxPlanOp& op = _plan.ops[i];
+		switch( op.op )
+		{
+		case PlanOp_Bytes :
+			break;
+		case PlanOp_String :
+			contents |= TypeHas_OwnedMemory;
+			break;
+		case PlanOp_Array :
+			contents |= GetTypeContents( *op.type );
+			break;
+		case PlanOp_Pointer :
+		case PlanOp_UserPointer :
+			contents |= TypeHas_Pointers;
+			break;
+		case PlanOp_ClassId :
+			contents |= TypeHas_ClassIds;
+			break;
+		case PlanOp_AssetId :
+			contents |= TypeHas_AssetIds;
+			break;
+			mxNO_SWITCH_DEFAULT;
+		}
+	}
+	return contents;
+}
+
+const mxClassPlan& GetClassPlan( const mxClass& _type )
+{
+	if( _type.plan == nil ) {
+		mxClassPlan* plan = CreateClassPlan( _type );
+		// the plan must be visible while computing contents of recursive types
+		_type.plan = plan;
+		plan->contents = ComputeContents( *plan );
+	}
+	return *_type.plan;
+}
+
+void ReleaseClassPlan( const mxClass& _type )
+{
+	delete _type.plan;
+	_type.plan = nil;
+}
+
+bool IsDenseType( const mxType& _type )
+{
+	if( ETypeKind_Is_Bitwise_Serializable( _type.m_kind ) ) {
+		return true;
+	}
+	if( _type.m_kind == ETypeKind::Type_Class ) {
+		return GetClassPlan( _type.UpCast< mxClass >() ).isDense;
+	}
+	return false;
+}
+
+bool IsPlainType( const mxType& _type )
+{
+	if( ETypeKind_Is_Bitwise_Serializable( _type.m_kind ) ) {
+		return true;
+	}
+	if( _type.m_kind == ETypeKind::Type_Class ) {
+		return GetClassPlan( _type.UpCast< mxClass >() ).isPlain;
+	}
+	return false;
+}
+
+UINT32 GetTypeContents( const mxType& _type )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_String :
+		return TypeHas_OwnedMemory;
+
+	case ETypeKind::Type_Class :
+		return GetClassPlan( _type.UpCast< mxClass >() ).contents;
+
+	case ETypeKind::Type_Pointer :
+	case ETypeKind::Type_UserData :
+		return TypeHas_Pointers;
+
+	case ETypeKind::Type_AssetId :
+		return TypeHas_AssetIds;
+
+	case ETypeKind::Type_ClassId :
+		return TypeHas_ClassIds;
+
+	case ETypeKind::Type_Array :
+		{
+			const mxArray& arrayType = _type.UpCast< mxArray >();
+			const UINT32 arrayContents = arrayType.IsDynamic() ? TypeHas_OwnedMemory : 0;
+			return arrayContents | GetTypeContents( arrayType.m_itemType );
+		}
+
+	case ETypeKind::Type_Blob :
+		return TypeHas_Everything;
+	}
+	// plain data
+	return 0;
+}
+
+bool IsBitwiseCopyable( const mxType& _type )
+{
+	// class IDs point to static type descriptors
+	return ( GetTypeContents( _type ) & ~TypeHas_ClassIds ) == 0;
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,92 @@
+/*
+=============================================================================
+	File:	ClassPlan.h
+	Desc:	Flattened class layouts for fast comparing/hashing/copying
+			of reflected objects.
+=============================================================================
+*/
+#pragma once
+
+#include <Base/Object/Reflection.h>
+
+/*
+-----------------------------------------------------------------------------
+	mxClassPlan
+
+	a class layout with all nested structures and base classes flattened:
+	adjacent POD fields are merged into 'spans' of bytes,
+	padding between fields is never included.
+-----------------------------------------------------------------------------
+*/
+enum EPlanOp
+{
+	PlanOp_Bytes,		// a run of POD fields (integers, floats, bools, enums, flags)
+	PlanOp_String,
+	PlanOp_Array,		// 'type' points to mxArray
+	PlanOp_Pointer,		// 'type' points to mxPointerType
+	PlanOp_ClassId,
+	PlanOp_AssetId,
+	PlanOp_UserPointer,	// 'type' points to mxUserPointerType
+};
+
+struct mxPlanOp
+{
+	UINT32			op;		// EPlanOp
+	UINT32			offset;	// byte offset from the start of the object
+	UINT32			size;	// size of the memory span (or of the field), in bytes
+	const mxType *	type;	// type of the field (null for spans of bytes)
+};
+
+struct mxClassPlan
+{
+	TArray< mxPlanOp >	ops;
+
+	// only POD fields (there are no strings, arrays, pointers, etc.)
+	bool	isPlain;
+
+	// plain and without any padding, the whole object can be memcmp'ed
+	bool	isDense;
+
+	// ETypeContents of all fields, including elements of arrays
+	UINT32	contents;
+};
+
+namespace Reflection
+{
+	// Returns the flattened layout of the class, it's created on first use.
+	// NOTE: TypeRegistry::Initialize() creates plans for all registered classes,
+	// plans for other types are created lazily (which is not thread-safe!).
+	const mxClassPlan& GetClassPlan( const mxClass& _type );
+
+	// called by the type registry on shutdown
+	void ReleaseClassPlan( const mxClass& _type );
+
+	// returns true if objects of the given type can be compared/copied with memcmp/memcpy
+	bool IsDenseType( const mxType& _type );
+
+	// returns true if the type consists only of POD fields
+	// (e.g. arrays of such types can be processed in tight loops)
+	bool IsPlainType( const mxType& _type );
+
+	// returns ETypeContents flags (zero for plain data)
+	UINT32 GetTypeContents( const mxType& _type );
+
+	// returns true if values of the given type can be copied with memcpy
+	// (they don't own any memory and don't contain any pointers)
+	bool IsBitwiseCopyable( const mxType& _type );
+
+	// compares lengths first, then contents (shared by comparing and diffing)
+	bool StringsAreEqual( const String& _s1, const String& _s2 );
+
+	// returns true if the walker should skip values of the given type
+	inline bool CanSkipType( const mxType& _type, UINT32 _interests )
+	{
+		return _interests != TypeHas_Everything
+			&& !( GetTypeContents( _type ) & _interests );
+	}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,297 @@
+/*
+=============================================================================
+	File:	FieldIndex.cpp
+	Desc:	Per-class perfect hash tables for looking up fields by name.
+	Note:	see "Hash, displace, and compress" (Belazzougui, Botelho, Dietzfelbinger):
+			keys are split into buckets, the largest buckets are placed first,
+			each bucket stores a seed which maps its keys into free slots.
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <algorithm>
+
+#include <Base/Object/ClassDescriptor.h>
+#include <Base/Object/FieldIndex.h>
+
+namespace Reflection
+{
+
+enum
+{
+	EMPTY_SLOT = 0xFFFF,
+	MAX_SEEDS_PER_BUCKET = 4096,	// the table is enlarged if a bucket cannot be placed
+	MAX_TABLE_GROWTH = 4,
+};
+
+UINT32 HashFieldName( const char* _name, UINT32 _length )
+{
+	UINT32 hash = 2166136261U;
+	for( UINT32 i = 0; i < _length; i++ )
+	{
+		hash ^= (BYTE) _name[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+UINT32 HashFieldName( const char* _name )
+{
+	UINT32 hash = 2166136261U;
+	while( *_name )
+	{
+		hash ^= (BYTE) *_name++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+// the second hash function (the finalizer from MurmurHash3)
+static inline UINT32 MixHash( UINT32 _hash, UINT32 _seed )
+{
+	UINT32 h = _hash ^ _seed;
+	h ^= h >> 16;
+	h *= 0x85EBCA6B;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35;
+	h ^= h >> 16;
+	return h;
+}
+
+static inline bool NameEquals( const mxField& _field, const char* _name, UINT32 _length )
+{
+	return strncmp( _field.name, _name, _length ) == 0 && _field.name[ _length ] == '\0';
+}
+
+static inline UINT32 NextPowerOfTwo( UINT32 _value )
+{
+	UINT32 result = 1;
+	while( result < _value ) {
+		result <<= 1;
+	}
+	return result;
+}
+
+static void CollectFields( mxFieldIndex & _index, const mxClass& _type )
+{
+	// base classes start at offset 0
+	const mxClass* parentType = _type.GetParent();
+	if( parentType != nil ) {
+		CollectFields( _index, *parentType );
+	}
+
+	const mxClassLayout& layout = _type.GetLayout();
+	for( UINT fieldIndex = 0; fieldIndex < layout.numFields; fieldIndex++ )
+	{
+		const mxField& field = layout.fields[ fieldIndex ];
+		mxFieldInfo & newInfo = _index.fields.Add();
+		newInfo.field = &field;
+		newInfo.offset = field.offset;
+		newInfo.nameHash = HashFieldName( field.name );
+	}
+}
+
+struct SHashedKey
+{
+	UINT16	fieldIndex;
+	UINT16	bucketSize;
+	UINT32	bucket;
+public:
+	// larger buckets are placed first
+	bool operator < ( const SHashedKey& other ) const
+	{
+		return (bucketSize > other.bucketSize) || (bucketSize == other.bucketSize && bucket < other.bucket);
+	}
+};
+
+// tries to place all buckets into the table with the given number of slots
+static bool PlaceBuckets( mxFieldIndex & _index, const SHashedKey* _keys, UINT32 _numKeys, UINT32 _numSlots )
+{
+	if( _index.slots.SetNum( _numSlots ) != ALL_OK ) {
+		return false;
+	}
+	for( UINT32 i = 0; i < _numSlots; i++ ) {
+		_index.slots[i] = EMPTY_SLOT;
+	}
+	_index.slotMask = _numSlots - 1;
+
+	UINT32 bucketStart = 0;
+	while( bucketStart < _numKeys )
+	{
+		const UINT32 bucket = _keys[ bucketStart ].bucket;
+		const UINT32 bucketEnd = bucketStart + _keys[ bucketStart ].bucketSize;
+
+		bool placed = false;
+		for( UINT32 seed = 0; seed < MAX_SEEDS_PER_BUCKET && !placed; seed++ )
+		{
+			UINT32 i = bucketStart;
+			for( ; i < bucketEnd; i++ )
+			{
+				const mxFieldInfo& info = _index.fields[ _keys[i].fieldIndex ];
+				const UINT32 slot = MixHash( info.nameHash, seed ) & _index.slotMask;
+				if( _index.slots[ slot ] != EMPTY_SLOT ) {
+					break;
+				}
+				_index.slots[ slot ] = _keys[i].fieldIndex;
+			}
+			placed = (i == bucketEnd);
+			if( placed ) {
+				_index.displacements[ bucket ] = seed;
+			} else {
+				// undo the partial placement
+				while( i-- > bucketStart ) {
+					const mxFieldInfo& info = _index.fields[ _keys[i].fieldIndex ];
+					_index.slots[ MixHash( info.nameHash, seed ) & _index.slotMask ] = EMPTY_SLOT;
+				}
+			}
+		}
+		if( !placed ) {
+			return false;
+		}
+		bucketStart = bucketEnd;
+	}
+	return true;
+}
+
+static bool BuildPerfectHash( mxFieldIndex & _index )
+{
+	const UINT32 numFields = _index.fields.Num();
+	if( numFields >= EMPTY_SLOT ) {
+		return false;
+	}
+
+	// collect unique names, fields of derived classes shadow inherited fields
+	TArray< SHashedKey >	keys;
+	for( UINT32 i = numFields; i-- > 0; )
+	{
+		const mxFieldInfo& info = _index.fields[i];
+		bool isShadowed = false;
+		for( UINT32 k = 0; k < keys.Num(); k++ )
+		{
+			const mxFieldInfo& other = _index.fields[ keys[k].fieldIndex ];
+			if( other.nameHash == info.nameHash )
+			{
+				if( strcmp( other.field->name, info.field->name ) != 0 ) {
+					return false;	// hash collision
+				}
+				isShadowed = true;
+				break;
+			}
+		}
+		if( !isShadowed ) {
+			keys.Add().fieldIndex = i;
+		}
+	}
+
+	const UINT32 numKeys = keys.Num();
+	if( !numKeys ) {
+		return false;
+	}
+
+	// about two keys per bucket
+	const UINT32 numBuckets = NextPowerOfTwo( (numKeys + 1) / 2 );
+	_index.bucketMask = numBuckets - 1;
+	if( _index.displacements.SetNum( numBuckets ) != ALL_OK ) {
+		return false;
+	}
+	for( UINT32 i = 0; i < numBuckets; i++ ) {
+		_index.displacements[i] = 0;
+	}
+
+	// sort the keys by bucket, largest buckets first
+	for( UINT32 i = 0; i < numKeys; i++ ) {
+		keys[i].bucket = _index.fields[ keys[i].fieldIndex ].nameHash & _index.bucketMask;
+	}
+	for( UINT32 i = 0; i < numKeys; i++ )
+	{
+		UINT16 bucketSize = 0;
+		for( UINT32 k = 0; k < numKeys; k++ ) {
+			bucketSize += (keys[k].bucket == keys[i].bucket);
+		}
+		keys[i].bucketSize = bucketSize;
+	}
+	std::sort( keys.ToPtr(), keys.ToPtr() + numKeys );
+
+	UINT32 numSlots = NextPowerOfTwo( numKeys );
+	for( UINT32 attempt = 0; attempt < MAX_TABLE_GROWTH; attempt++ )
+	{
+		if( PlaceBuckets( _index, keys.ToPtr(), numKeys, numSlots ) ) {
+			return true;
+		}
+		numSlots *= 2;
+	}
+	return false;
+}
+
+static mxFieldIndex* CreateFieldIndex( const mxClass& _type )
+{
+	mxFieldIndex* index = new mxFieldIndex();
+	index->bucketMask = 0;
+	index->slotMask = 0;
+
+	CollectFields( *index, _type );
+
+	index->isPerfect = BuildPerfectHash( *index );
+	if( !index->isPerfect ) {
+		index->displacements.Empty();
+		index->slots.Empty();
+	}
+	return index;
+}
+
+const mxFieldIndex& GetFieldIndex( const mxClass& _type )
+{
+	if( _type.fieldIndex == nil ) {
+		_type.fieldIndex = CreateFieldIndex( _type );
+	}
+	return *_type.fieldIndex;
+}
+
+void ReleaseFieldIndex( const mxClass& _type )
+{
+	delete _type.fieldIndex;
+	_type.fieldIndex = nil;
+}
+
+const mxFieldInfo* FindField( const mxClass& _type, const char* _name, UINT32 _length )
+{
+	const mxFieldIndex& index = GetFieldIndex( _type );
+	const UINT32 hash = HashFieldName( _name, _length );
+
+	if( index.isPerfect )
+	{
+		const UINT32 seed = index.displacements[ hash & index.bucketMask ];
+		const UINT32 fieldIndex = index.slots[ MixHash( hash, seed ) & index.slotMask ];
+		if( fieldIndex != EMPTY_SLOT )
+		{
+			const mxFieldInfo& info = index.fields[ fieldIndex ];
+			if( info.nameHash == hash && NameEquals( *info.field, _name, _length ) ) {
+				return &info;
+			}
+		}
+		return nil;
+	}
+
+	// search from the most derived class
+	for( UINT32 i = index.fields.Num(); i-- > 0; )
+	{
+		const mxFieldInfo& info = index.fields[i];
+		if( info.nameHash == hash && NameEquals( *info.field, _name, _length ) ) {
+			return &info;
+		}
+	}
+	return nil;
+}
+
+const mxFieldInfo* FindField( const mxClass& _type, const char* _name )
+{
+	return FindField( _type, _name, strlen( _name ) );
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,67 @@
+/*
+=============================================================================
+	File:	FieldIndex.h
+	Desc:	Per-class perfect hash tables for looking up fields by name
+			(e.g. for dispatching keys in text decoders).
+=============================================================================
+*/
+#pragma once
+
+#include <Base/Object/Reflection.h>
+
+/*
+-----------------------------------------------------------------------------
+	mxFieldIndex
+
+	all fields of a class (including inherited ones)
+	and a perfect hash table ('hash and displace'):
+	any name is resolved with two table lookups and a single string comparison.
+	The table is not minimal: the slot count is rounded up to a power of two
+	(and doubled if the keys don't fit), so some slots stay empty.
+-----------------------------------------------------------------------------
+*/
+struct mxFieldInfo
+{
+	const mxField *	field;
+	UINT32			offset;		// byte offset from the start of the object
+	UINT32			nameHash;	// Reflection::HashFieldName( field->name )
+};
+
+struct mxFieldIndex
+{
+	// base class fields come first (the same order as visited by Walker)
+	TArray< mxFieldInfo >	fields;
+
+	TArray< UINT32 >		displacements;	// one per bucket, a seed for the second hash
+	TArray< UINT16 >		slots;			// indices into 'fields', ~0 if the slot is empty
+	UINT32					bucketMask;
+	UINT32					slotMask;
+
+	// false if the table couldn't be built (e.g. two names have the same hash),
+	// then the fields are searched linearly
+	bool					isPerfect;
+};
+
+namespace Reflection
+{
+	// FNV-1a
+	UINT32 HashFieldName( const char* _name, UINT32 _length );
+	UINT32 HashFieldName( const char* _name );
+
+	// Returns the field index of the class, it's created on first use.
+	// NOTE: TypeRegistry::Initialize() creates indices for all registered classes.
+	const mxFieldIndex& GetFieldIndex( const mxClass& _type );
+
+	// called by the type registry on shutdown
+	void ReleaseFieldIndex( const mxClass& _type );
+
+	// returns NULL if there's no field with the given name;
+	// if there are several fields with the same name, the most derived one is returned
+	const mxFieldInfo* FindField( const mxClass& _type, const char* _name, UINT32 _length );
+	const mxFieldInfo* FindField( const mxClass& _type, const char* _name );
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
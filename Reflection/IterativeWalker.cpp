@@ -0,0 +1,312 @@
+/*
+=============================================================================
+	File:	IterativeWalker.cpp
+	Desc:	Non-recursive, resumable version of Walker2.
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#if mxPLATFORM != mxPLATFORM_WINDOWS
+	#include <time.h>
+#endif
+
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/PointerType.h>
+#include <Base/Object/UserPointerType.h>
+#include <Base/Object/ClassPlan.h>
+#include <Base/Object/IterativeWalker.h>
+
+namespace Reflection
+{
+
+enum { TIME_CHECK_INTERVAL = 32 };	// the timer is queried every N visits
+
+UINT64 GetTimeMicroseconds()
+{
+#if mxPLATFORM == mxPLATFORM_WINDOWS
+	static LARGE_INTEGER frequency = { 0 };
+	if( !frequency.QuadPart ) {
+		::QueryPerformanceFrequency( &frequency );
+	}
+	LARGE_INTEGER counter;
+	::QueryPerformanceCounter( &counter );
+	return (UINT64) ( counter.QuadPart * 1000000 / frequency.QuadPart );
+#else
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (UINT64) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+// a nested object or an array which is being visited
+struct IterativeWalker::Frame
+{
+	void *			memory;			// start of the object or array elements
+	const mxClass *	objectType;		// null for arrays
+	const mxClass *	currentClass;	// base classes are visited first
+	const mxType *	itemType;		// for arrays
+	UINT32			itemStride;
+	UINT32			index;			// next field or array element
+	UINT32			count;			// number of array elements
+	AVisitor2::Context	context;	// passed to the fields/elements
+public:
+	Frame( int _depth )
+		: context( _depth )
+	{}
+};
+
+IterativeWalker::IterativeWalker()
+{
+	m_frames = NULL;
+	m_maxFrames = 0;
+	m_numFrames = 0;
+	m_overflow = false;
+	m_visitor = NULL;
+	m_numVisits = 0;
+	m_rootMemory = NULL;
+	m_rootType = NULL;
+	m_rootPending = false;
+}
+
+IterativeWalker::~IterativeWalker()
+{
+	this->Shutdown();
+}
+
+ERet IterativeWalker::Initialize( UINT32 _maxDepth )
+{
+	mxASSERT(_maxDepth > 0);
+	this->Shutdown();
+	// frames are never moved, because contexts point to their parents
+	m_frames = static_cast< Frame* >( mxAlloc( _maxDepth * sizeof(Frame) ) );
+	chkRET_X_IF_NIL(m_frames, ERR_OUT_OF_MEMORY);
+	m_maxFrames = _maxDepth;
+	return ALL_OK;
+}
+
+void IterativeWalker::Shutdown()
+{
+	this->Reset();
+	if( m_frames ) {
+		mxFree( m_frames );
+		m_frames = NULL;
+	}
+	m_maxFrames = 0;
+}
+
+void IterativeWalker::Start( void * _memory, const mxType& _type, AVisitor2* _visitor, void *_userData )
+{
+	mxASSERT_PTR(_memory);
+	mxASSERT_PTR(_visitor);
+	mxASSERT2(m_frames != NULL, "Initialize() must be called first");
+
+	this->Reset();
+
+	m_visitor = _visitor;
+	m_rootMemory = _memory;
+	m_rootType = &_type;
+	m_rootPending = true;
+	m_rootContext.userData = _userData;
+}
+
+void IterativeWalker::Reset()
+{
+	// contexts are trivially destructible
+	m_numFrames = 0;
+	m_overflow = false;
+	m_numVisits = 0;
+	m_rootPending = false;
+}
+
+EWalkStatus IterativeWalker::Step( UINT32 _maxVisits, UINT32 _maxMicroseconds )
+{
+	const UINT64 startTime = _maxMicroseconds ? GetTimeMicroseconds() : 0;
+	UINT32 numVisits = 0;
+
+	if( m_rootPending )
+	{
+		m_rootPending = false;
+		this->VisitValue( m_rootMemory, *m_rootType, m_rootContext );
+		numVisits++;
+	}
+
+	while( m_numFrames > 0 && !m_overflow )
+	{
+		if( _maxVisits && numVisits >= _maxVisits ) {
+			break;
+		}
+		if( _maxMicroseconds && (numVisits % TIME_CHECK_INTERVAL) == 0 && numVisits > 0
+			&& GetTimeMicroseconds() - startTime >= _maxMicroseconds )
+		{
+			break;
+		}
+
+		Frame & top = m_frames[ m_numFrames - 1 ];
+
+		if( top.objectType == NULL )
+		{
+			// array
+			if( top.index >= top.count ) {
+				m_numFrames--;
+				continue;
+			}
+			void* itemPtr = mxAddByteOffset( top.memory, top.index * top.itemStride );
+			top.index++;
+			numVisits++;
+			// callbacks may have changed userData for the previous element
+			top.context.userData = top.context.parent->userData;
+			this->VisitValue( itemPtr, *top.itemType, top.context );
+		}
+		else
+		{
+			// class fields
+			const mxClassLayout& layout = top.currentClass->GetLayout();
+			if( top.index >= layout.numFields )
+			{
+				if( top.currentClass == top.objectType ) {
+					m_numFrames--;
+				} else {
+					// parent classes are visited from the nearest one, the object's own fields come last
+					const mxClass* nextClass = top.currentClass->GetParent();
+					top.currentClass = nextClass ? nextClass : top.objectType;
+					top.index = 0;
+				}
+				continue;
+			}
+			const mxField& field = layout.fields[ top.index ];
+			top.index++;
+			if( CanSkipType( field.type, m_visitor->m_interests ) ) {
+				continue;
+			}
+			numVisits++;
+
+			void* memberVarPtr = mxAddByteOffset( top.memory, field.offset );
+			top.context.member = &field;
+			top.context.userData = top.context.parent->userData;
+			if( m_visitor->Visit_Field( memberVarPtr, field, top.context ) ) {
+				this->VisitValue( memberVarPtr, field.type, top.context );
+			}
+		}
+	}
+
+	m_numVisits += numVisits;
+
+	if( m_overflow ) {
+		ptERROR("IterativeWalker: stack overflow (max depth: %u)\n", m_maxFrames);
+		this->Reset();
+		return Walk_StackOverflow;
+	}
+	return this->IsFinished() ? Walk_Finished : Walk_Suspended;
+}
+
+void IterativeWalker::VisitValue( void * _memory, const mxType& _type, const AVisitor2::Context& _context )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Integer :
+	case ETypeKind::Type_Float :
+	case ETypeKind::Type_Bool :
+	case ETypeKind::Type_Enum :
+	case ETypeKind::Type_Flags :
+		m_visitor->Visit_POD( _memory, _type, _context );
+		break;
+
+	case ETypeKind::Type_String :
+		m_visitor->Visit_String( TPODCast< String >::GetNonConst( _memory ), _context );
+		break;
+
+	case ETypeKind::Type_Class :
+		{
+			const mxClass& classType = _type.UpCast< mxClass >();
+			if( m_visitor->Visit_Class( _memory, classType, _context ) ) {
+				this->PushClass( _memory, classType, _context );
+			}
+		}
+		break;
+
+	case ETypeKind::Type_Pointer :
+		m_visitor->Visit_Pointer( *static_cast< VoidPointer* >( _memory ), _type.UpCast< mxPointerType >(), _context );
+		break;
+
+	case ETypeKind::Type_AssetId :
+		m_visitor->Visit_AssetId( *static_cast< AssetID* >( _memory ), _context );
+		break;
+
+	case ETypeKind::Type_ClassId :
+		m_visitor->Visit_TypeId( static_cast< SClassId* >( _memory ), _context );
+		break;
+
+	case ETypeKind::Type_UserData :
+		m_visitor->Visit_UserPointer( _memory, _type.UpCast< mxUserPointerType >(), _context );
+		break;
+
+	case ETypeKind::Type_Blob :
+		Unimplemented;
+		break;
+
+	case ETypeKind::Type_Array :
+		{
+			const mxArray& arrayType = _type.UpCast< mxArray >();
+			if( m_visitor->Visit_Array( _memory, arrayType, _context ) ) {
+				this->PushArray( _memory, arrayType, _context );
+			}
+		}
+		break;
+
+		mxNO_SWITCH_DEFAULT;
+	}
+}
+
+void IterativeWalker::PushClass( void * _object, const mxClass& _type, const AVisitor2::Context& _context )
+{
+	if( m_numFrames >= m_maxFrames ) {
+		m_overflow = true;
+		return;
+	}
+	Frame* newFrame = new( &m_frames[ m_numFrames++ ] ) Frame( _context.depth + 1 );
+	newFrame->memory = _object;
+	newFrame->objectType = &_type;
+	newFrame->currentClass = _type.GetParent() ? _type.GetParent() : &_type;
+	newFrame->itemType = NULL;
+	newFrame->itemStride = 0;
+	newFrame->index = 0;
+	newFrame->count = 0;
+	newFrame->context.parent = &_context;
+	newFrame->context.userData = _context.userData;
+}
+
+void IterativeWalker::PushArray( void * _array, const mxArray& _type, const AVisitor2::Context& _context )
+{
+	const UINT32 count = _type.Generic_Get_Count( _array );
+	if( !count || CanSkipType( _type.m_itemType, m_visitor->m_interests ) ) {
+		return;
+	}
+	void* arrayBase = _type.Generic_Get_Data( _array );
+	if( IsPlainType( _type.m_itemType )
+		&& m_visitor->Visit_PODArray( arrayBase, _type.m_itemType, count, _type.m_itemSize, _context ) )
+	{
+		return;
+	}
+	if( m_numFrames >= m_maxFrames ) {
+		m_overflow = true;
+		return;
+	}
+	Frame* newFrame = new( &m_frames[ m_numFrames++ ] ) Frame( _context.depth + 1 );
+	newFrame->memory = arrayBase;
+	newFrame->objectType = NULL;
+	newFrame->currentClass = NULL;
+	newFrame->itemType = &_type.m_itemType;
+	newFrame->itemStride = _type.m_itemSize;
+	newFrame->index = 0;
+	newFrame->count = count;
+	newFrame->context.parent = &_context;
+	newFrame->context.userData = _context.userData;
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,89 @@
+/*
+=============================================================================
+	File:	IterativeWalker.h
+	Desc:	Non-recursive, resumable version of Walker2:
+			the traversal can be split into small time slices
+			(e.g. for background validation of large object graphs).
+=============================================================================
+*/
+#pragma once
+
+#include <Base/Object/Reflection.h>
+
+namespace Reflection
+{
+
+enum EWalkStatus
+{
+	Walk_Finished,		// all objects have been visited
+	Walk_Suspended,		// the budget has been exhausted, call Step() again
+	Walk_StackOverflow,	// the object graph is too deep, increase the stack size
+};
+
+// monotonic clock used for time slicing (and by walker benchmarks)
+UINT64 GetTimeMicroseconds();
+
+/*
+-----------------------------------------------------------------------------
+	IterativeWalker
+
+	visits objects in the same order as Walker2 and calls the same callbacks,
+	but keeps its state in an explicit, preallocated stack of frames.
+	NOTE: the objects must not be modified between calls to Step().
+-----------------------------------------------------------------------------
+*/
+class IterativeWalker
+{
+public:
+	IterativeWalker();
+	~IterativeWalker();
+
+	// preallocates the stack; each nested object or array takes one frame
+	ERet Initialize( UINT32 _maxDepth = 256 );
+	void Shutdown();
+
+	// prepares the traversal, doesn't visit anything
+	void Start( void * _memory, const mxType& _type, AVisitor2* _visitor, void *_userData = nil );
+
+	// visits at most '_maxVisits' fields/array elements (zero means no limit),
+	// stops after '_maxMicroseconds' (if not zero) elapse
+	EWalkStatus Step( UINT32 _maxVisits, UINT32 _maxMicroseconds = 0 );
+
+	bool IsFinished() const { return m_numFrames == 0 && !m_rootPending; }
+
+	// stops the traversal
+	void Reset();
+
+	// total number of visited fields and array elements since Start()
+	UINT32 NumVisits() const { return m_numVisits; }
+
+private:
+	struct Frame;
+
+	void VisitValue( void * _memory, const mxType& _type, const AVisitor2::Context& _context );
+	void PushClass( void * _object, const mxClass& _type, const AVisitor2::Context& _context );
+	void PushArray( void * _array, const mxArray& _type, const AVisitor2::Context& _context );
+
+private:
+	Frame *		m_frames;	// preallocated stack
+	UINT32		m_maxFrames;
+	UINT32		m_numFrames;
+	bool		m_overflow;
+
+	AVisitor2 *	m_visitor;
+	UINT32		m_numVisits;
+
+	void *			m_rootMemory;
+	const mxType *	m_rootType;
+	bool			m_rootPending;	// the root object hasn't been visited yet
+	AVisitor2::Context	m_rootContext;
+
+private:	NO_COPY_CONSTRUCTOR(IterativeWalker);
+private:	NO_ASSIGNMENT(IterativeWalker);
+};
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
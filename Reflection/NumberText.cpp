@@ -0,0 +1,770 @@
+/*
+=============================================================================
+	File:	NumberText.cpp
+	Desc:	Conversions between floating-point numbers and text.
+	Note:	formatting uses the Grisu2 algorithm
+			("Printing Floating-Point Numbers Quickly and Accurately with Integers", Loitsch),
+			the output always round-trips and is the shortest in >99.9% cases.
+			parsing uses Clinger's fast path for short numbers
+			and the Eisel-Lemire algorithm ("Number Parsing at a Gigabyte per Second", Lemire),
+			strtod() is called for rare ambiguous and out-of-range cases.
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <Base/Object/NumberText.h>
+
+namespace Reflection
+{
+
+/*
+-----------------------------------------------------------------------------
+	Grisu2
+-----------------------------------------------------------------------------
+*/
+namespace
+{
+
+// "do-it-yourself floating point": f * 2^e
+struct DiyFp
+{
+	UINT64	f;
+	int		e;
+public:
+	DiyFp() {}
+	DiyFp( UINT64 _f, int _e ) : f( _f ), e( _e ) {}
+
+	DiyFp operator - ( const DiyFp& other ) const
+	{
+		mxASSERT(e == other.e && f >= other.f);
+		return DiyFp( f - other.f, e );
+	}
+	// returns the upper (rounded) 64 bits of the product
+	DiyFp operator * ( const DiyFp& other ) const
+	{
+		const UINT64 M32 = 0xFFFFFFFF;
+		const UINT64 a = f >> 32;
+		const UINT64 b = f & M32;
+		const UINT64 c = other.f >> 32;
+		const UINT64 d = other.f & M32;
+		const UINT64 ac = a * c;
+		const UINT64 bc = b * c;
+		const UINT64 ad = a * d;
+		const UINT64 bd = b * d;
+		UINT64 tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+		tmp += UINT64(1) << 31;	// round
+		return DiyFp( ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + other.e + 64 );
+	}
+	DiyFp Normalize() const
+	{
+		DiyFp result( f, e );
+		while( !(result.f & (UINT64(1) << 63)) ) {
+			result.f <<= 1;
+			result.e--;
+		}
+		return result;
+	}
+};
+
+// normalized 10^k, k = -348, -340, ..., 340
+struct CachedPower
+{
+	UINT64	f;
+	int		e;
+};
+static const CachedPower gs_cachedPowers[] =
+{
+	{ 0xFA8FD5A0081C0288, -1220 },	// 1e-348
+	{ 0xBAAEE17FA23EBF76, -1193 },	// 1e-340
+	{ 0x8B16FB203055AC76, -1166 },	// 1e-332
+	{ 0xCF42894A5DCE35EA, -1140 },	// 1e-324
+	{ 0x9A6BB0AA55653B2D, -1113 },	// 1e-316
+	{ 0xE61ACF033D1A45DF, -1087 },	// 1e-308
+	{ 0xAB70FE17C79AC6CA, -1060 },	// 1e-300
+	{ 0xFF77B1FCBEBCDC4F, -1034 },	// 1e-292
+	{ 0xBE5691EF416BD60C, -1007 },	// 1e-284
+	{ 0x8DD01FAD907FFC3C,  -980 },	// 1e-276
+	{ 0xD3515C2831559A83,  -954 },	// 1e-268
+	{ 0x9D71AC8FADA6C9B5,  -927 },	// 1e-260
+	{ 0xEA9C227723EE8BCB,  -901 },	// 1e-252
+	{ 0xAECC49914078536D,  -874 },	// 1e-244
+	{ 0x823C12795DB6CE57,  -847 },	// 1e-236
+	{ 0xC21094364DFB5637,  -821 },	// 1e-228
+	{ 0x9096EA6F3848984F,  -794 },	// 1e-220
+	{ 0xD77485CB25823AC7,  -768 },	// 1e-212
+	{ 0xA086CFCD97BF97F4,  -741 },	// 1e-204
+	{ 0xEF340A98172AACE5,  -715 },	// 1e-196
+	{ 0xB23867FB2A35B28E,  -688 },	// 1e-188
+	{ 0x84C8D4DFD2C63F3B,  -661 },	// 1e-180
+	{ 0xC5DD44271AD3CDBA,  -635 },	// 1e-172
+	{ 0x936B9FCEBB25C996,  -608 },	// 1e-164
+	{ 0xDBAC6C247D62A584,  -582 },	// 1e-156
+	{ 0xA3AB66580D5FDAF6,  -555 },	// 1e-148
+	{ 0xF3E2F893DEC3F126,  -529 },	// 1e-140
+	{ 0xB5B5ADA8AAFF80B8,  -502 },	// 1e-132
+	{ 0x87625F056C7C4A8B,  -475 },	// 1e-124
+	{ 0xC9BCFF6034C13053,  -449 },	// 1e-116
+	{ 0x964E858C91BA2655,  -422 },	// 1e-108
+	{ 0xDFF9772470297EBD,  -396 },	// 1e-100
+	{ 0xA6DFBD9FB8E5B88F,  -369 },	// 1e-92
+	{ 0xF8A95FCF88747D94,  -343 },	// 1e-84
+	{ 0xB94470938FA89BCF,  -316 },	// 1e-76
+	{ 0x8A08F0F8BF0F156B,  -289 },	// 1e-68
+	{ 0xCDB02555653131B6,  -263 },	// 1e-60
+	{ 0x993FE2C6D07B7FAC,  -236 },	// 1e-52
+	{ 0xE45C10C42A2B3B06,  -210 },	// 1e-44
+	{ 0xAA242499697392D3,  -183 },	// 1e-36
+	{ 0xFD87B5F28300CA0E,  -157 },	// 1e-28
+	{ 0xBCE5086492111AEB,  -130 },	// 1e-20
+	{ 0x8CBCCC096F5088CC,  -103 },	// 1e-12
+	{ 0xD1B71758E219652C,   -77 },	// 1e-4
+	{ 0x9C40000000000000,   -50 },	// 1e4
+	{ 0xE8D4A51000000000,   -24 },	// 1e12
+	{ 0xAD78EBC5AC620000,     3 },	// 1e20
+	{ 0x813F3978F8940984,    30 },	// 1e28
+	{ 0xC097CE7BC90715B3,    56 },	// 1e36
+	{ 0x8F7E32CE7BEA5C70,    83 },	// 1e44
+	{ 0xD5D238A4ABE98068,   109 },	// 1e52
+	{ 0x9F4F2726179A2245,   136 },	// 1e60
+	{ 0xED63A231D4C4FB27,   162 },	// 1e68
+	{ 0xB0DE65388CC8ADA8,   189 },	// 1e76
+	{ 0x83C7088E1AAB65DB,   216 },	// 1e84
+	{ 0xC45D1DF942711D9A,   242 },	// 1e92
+	{ 0x924D692CA61BE758,   269 },	// 1e100
+	{ 0xDA01EE641A708DEA,   295 },	// 1e108
+	{ 0xA26DA3999AEF774A,   322 },	// 1e116
+	{ 0xF209787BB47D6B85,   348 },	// 1e124
+	{ 0xB454E4A179DD1877,   375 },	// 1e132
+	{ 0x865B86925B9BC5C2,   402 },	// 1e140
+	{ 0xC83553C5C8965D3D,   428 },	// 1e148
+	{ 0x952AB45CFA97A0B3,   455 },	// 1e156
+	{ 0xDE469FBD99A05FE3,   481 },	// 1e164
+	{ 0xA59BC234DB398C25,   508 },	// 1e172
+	{ 0xF6C69A72A3989F5C,   534 },	// 1e180
+	{ 0xB7DCBF5354E9BECE,   561 },	// 1e188
+	{ 0x88FCF317F22241E2,   588 },	// 1e196
+	{ 0xCC20CE9BD35C78A5,   614 },	// 1e204
+	{ 0x98165AF37B2153DF,   641 },	// 1e212
+	{ 0xE2A0B5DC971F303A,   667 },	// 1e220
+	{ 0xA8D9D1535CE3B396,   694 },	// 1e228
+	{ 0xFB9B7CD9A4A7443C,   720 },	// 1e236
+	{ 0xBB764C4CA7A44410,   747 },	// 1e244
+	{ 0x8BAB8EEFB6409C1A,   774 },	// 1e252
+	{ 0xD01FEF10A657842C,   800 },	// 1e260
+	{ 0x9B10A4E5E9913129,   827 },	// 1e268
+	{ 0xE7109BFBA19C0C9D,   853 },	// 1e276
+	{ 0xAC2820D9623BF429,   880 },	// 1e284
+	{ 0x80444B5E7AA7CF85,   907 },	// 1e292
+	{ 0xBF21E44003ACDD2D,   933 },	// 1e300
+	{ 0x8E679C2F5E44FF8F,   960 },	// 1e308
+	{ 0xD433179D9C8CB841,   986 },	// 1e316
+	{ 0x9E19DB92B4E31BA9,  1013 },	// 1e324
+	{ 0xEB96BF6EBADF77D9,  1039 },	// 1e332
+	{ 0xAF87023B9BF0EE6B,  1066 },	// 1e340
+};
+
+static const UINT32 gs_pow10_32[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+// returns the cached power which brings the binary exponent into the range [-60, -32]
+static DiyFp GetCachedPower( int e, int &_K )
+{
+	// dk must be positive, so we can use ceil() via int cast
+	const double dk = (-61 - e) * 0.30102999566398114 + 347;	// log10(2)
+	int k = (int) dk;
+	if( dk - k > 0.0 ) {
+		k++;
+	}
+	const UINT32 index = (UINT32)( (k >> 3) + 1 );
+	mxASSERT(index < mxCOUNT_OF(gs_cachedPowers));
+	_K = -(-348 + (int)index * 8);
+	return DiyFp( gs_cachedPowers[ index ].f, gs_cachedPowers[ index ].e );
+}
+
+static int CountDecimalDigits32( UINT32 n )
+{
+	int count = 1;
+	while( count < 10 && n >= gs_pow10_32[ count ] ) {
+		count++;
+	}
+	return count;
+}
+
+static void GrisuRound( char* buffer, int length, UINT64 delta, UINT64 rest, UINT64 ten_kappa, UINT64 wp_w )
+{
+	// move the last digit closer to the exact value while staying in the rounding interval
+	while( rest < wp_w && delta - rest >= ten_kappa
+		&& (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w) )
+	{
+		buffer[ length - 1 ]--;
+		rest += ten_kappa;
+	}
+}
+
+static void DigitGen( const DiyFp& W, const DiyFp& Mp, UINT64 delta, char* buffer, int &_length, int &_K )
+{
+	const DiyFp one( UINT64(1) << -Mp.e, Mp.e );
+	const DiyFp wp_w = Mp - W;
+	UINT32 p1 = (UINT32)( Mp.f >> -one.e );
+	UINT64 p2 = Mp.f & (one.f - 1);
+	int kappa = CountDecimalDigits32( p1 );
+	_length = 0;
+
+	// integral part
+	while( kappa > 0 )
+	{
+		const UINT32 divisor = gs_pow10_32[ kappa - 1 ];
+		const UINT32 d = p1 / divisor;
+		p1 %= divisor;
+		if( d || _length ) {
+			buffer[ _length++ ] = (char)( '0' + d );
+		}
+		kappa--;
+		const UINT64 rest = (UINT64(p1) << -one.e) + p2;
+		if( rest <= delta )
+		{
+			_K += kappa;
+			GrisuRound( buffer, _length, delta, rest, UINT64(gs_pow10_32[ kappa ]) << -one.e, wp_w.f );
+			return;
+		}
+	}
+
+	// fractional part
+	for(;;)
+	{
+		p2 *= 10;
+		delta *= 10;
+		const char d = (char)( p2 >> -one.e );
+		if( d || _length ) {
+			buffer[ _length++ ] = (char)( '0' + d );
+		}
+		p2 &= one.f - 1;
+		kappa--;
+		if( p2 < delta )
+		{
+			_K += kappa;
+			const int index = -kappa;
+			GrisuRound( buffer, _length, delta, p2, one.f, wp_w.f * (index < 10 ? gs_pow10_32[ index ] : 0) );
+			return;
+		}
+	}
+}
+
+// _f * 2^_e - the value (with the hidden bit);
+// writes the digits, the value is 'digits' * 10^K
+static void Grisu2( UINT64 _f, int _e, bool _lowerBoundaryIsCloser, char* buffer, int &_length, int &_K )
+{
+	// the boundaries are halfway to the neighbouring values
+	const DiyFp plus = DiyFp( (_f << 1) + 1, _e - 1 ).Normalize();
+	DiyFp minus = _lowerBoundaryIsCloser ? DiyFp( (_f << 2) - 1, _e - 2 ) : DiyFp( (_f << 1) - 1, _e - 1 );
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+
+	const DiyFp c_mk = GetCachedPower( plus.e, _K );
+	const DiyFp W = DiyFp( _f, _e ).Normalize() * c_mk;
+	DiyFp Wp = plus * c_mk;
+	DiyFp Wm = minus * c_mk;
+	// the products are imprecise, shrink the interval to be safe
+	Wm.f++;
+	Wp.f--;
+	DigitGen( W, Wp, Wp.f - Wm.f, buffer, _length, _K );
+}
+
+// writes 'digits' * 10^K in the shortest form, like JavaScript
+static UINT32 Prettify( char* buffer, int length, int K )
+{
+	const int kk = length + K;	// 10^(kk-1) <= value < 10^kk
+
+	if( K >= 0 && kk <= 21 )
+	{
+		// 1234e7 -> 12340000000.0
+		for( int i = length; i < kk; i++ ) {
+			buffer[ i ] = '0';
+		}
+		buffer[ kk ] = '.';
+		buffer[ kk + 1 ] = '0';
+		buffer[ kk + 2 ] = '\0';
+		return kk + 2;
+	}
+	if( 0 < kk && kk <= 21 )
+	{
+		// 1234e-2 -> 12.34
+		memmove( &buffer[ kk + 1 ], &buffer[ kk ], length - kk );
+		buffer[ kk ] = '.';
+		buffer[ length + 1 ] = '\0';
+		return length + 1;
+	}
+	if( -6 < kk && kk <= 0 )
+	{
+		// 1234e-6 -> 0.001234
+		const int offset = 2 - kk;
+		memmove( &buffer[ offset ], &buffer[ 0 ], length );
+		buffer[ 0 ] = '0';
+		buffer[ 1 ] = '.';
+		for( int i = 2; i < offset; i++ ) {
+			buffer[ i ] = '0';
+		}
+		buffer[ length + offset ] = '\0';
+		return length + offset;
+	}
+
+	// exponential form: 1e30, 1.234e-30
+	int pos;
+	if( length == 1 ) {
+		pos = 1;
+	} else {
+		memmove( &buffer[ 2 ], &buffer[ 1 ], length - 1 );
+		buffer[ 1 ] = '.';
+		pos = length + 1;
+	}
+	buffer[ pos++ ] = 'e';
+	int exponent = kk - 1;
+	if( exponent < 0 ) {
+		buffer[ pos++ ] = '-';
+		exponent = -exponent;
+	}
+	if( exponent >= 100 ) {
+		buffer[ pos++ ] = (char)( '0' + exponent / 100 );
+		exponent %= 100;
+		buffer[ pos++ ] = (char)( '0' + exponent / 10 );
+	} else if( exponent >= 10 ) {
+		buffer[ pos++ ] = (char)( '0' + exponent / 10 );
+	}
+	buffer[ pos++ ] = (char)( '0' + exponent % 10 );
+	buffer[ pos ] = '\0';
+	return pos;
+}
+
+// _significandBits - without the hidden bit
+static UINT32 FormatBinary( UINT64 _bits, int _significandBits, int _exponentBits, char* _buffer )
+{
+	const UINT64 significandMask = (UINT64(1) << _significandBits) - 1;
+	const UINT32 exponentMask = (1U << _exponentBits) - 1;
+	const int exponentBias = (int)(exponentMask >> 1) + _significandBits;
+
+	const bool isNegative = (_bits >> (_significandBits + _exponentBits)) != 0;
+	const UINT32 biasedExponent = (UINT32)( (_bits >> _significandBits) & exponentMask );
+	const UINT64 significand = _bits & significandMask;
+
+	char* buffer = _buffer;
+	if( isNegative ) {
+		*buffer++ = '-';
+	}
+
+	if( biasedExponent == exponentMask || (biasedExponent == 0 && significand == 0) )
+	{
+		// zero, NaN or infinity
+		if( biasedExponent == exponentMask ) {
+			buffer = _buffer;
+		}
+		strcpy( buffer, "0.0" );
+		return (buffer - _buffer) + 3;
+	}
+
+	UINT64 f;
+	int e;
+	if( biasedExponent ) {
+		f = significand | (UINT64(1) << _significandBits);
+		e = (int)biasedExponent - exponentBias;
+	} else {
+		f = significand;
+		e = 1 - exponentBias;
+	}
+	// the gap to the previous value is smaller at powers of two
+	const bool lowerBoundaryIsCloser = (significand == 0 && biasedExponent > 1);
+
+	int length, K;
+	Grisu2( f, e, lowerBoundaryIsCloser, buffer, length, K );
+	return (buffer - _buffer) + Prettify( buffer, length, K );
+}
+
+}//namespace
+
+UINT32 FormatFloat( float _value, char _buffer[MAX_NUMBER_TEXT_LENGTH] )
+{
+	UINT32 bits;
+	memcpy( &bits, &_value, sizeof(bits) );
+	return FormatBinary( bits, 23, 8, _buffer );
+}
+
+UINT32 FormatDouble( double _value, char _buffer[MAX_NUMBER_TEXT_LENGTH] )
+{
+	UINT64 bits;
+	memcpy( &bits, &_value, sizeof(bits) );
+	return FormatBinary( bits, 52, 11, _buffer );
+}
+
+/*
+-----------------------------------------------------------------------------
+	Eisel-Lemire
+-----------------------------------------------------------------------------
+*/
+namespace
+{
+
+enum
+{
+	MAX_DIGITS = 19,	// the mantissa must fit into UINT64
+	MIN_POW5 = -64,		// the powers of five in the table,
+	MAX_POW5 = 64,		// larger/smaller exponents are handled by strtod()
+};
+
+// 128-bit approximations of 5^q, normalized (the highest bit is set),
+// rounded up for negative powers and truncated for positive ones
+struct Pow5
+{
+	UINT64	hi;
+	UINT64	lo;
+};
+static const Pow5 gs_pow5[] =
+{
+	{ 0xA87FEA27A539E9A5, 0x3F2398D747B36224 },	// 5^-64
+	{ 0xD29FE4B18E88640E, 0x8EEC7F0D19A03AAD },	// 5^-63
+	{ 0x83A3EEEEF9153E89, 0x1953CF68300424AC },	// 5^-62
+	{ 0xA48CEAAAB75A8E2B, 0x5FA8C3423C052DD7 },	// 5^-61
+	{ 0xCDB02555653131B6, 0x3792F412CB06794D },	// 5^-60
+	{ 0x808E17555F3EBF11, 0xE2BBD88BBEE40BD0 },	// 5^-59
+	{ 0xA0B19D2AB70E6ED6, 0x5B6ACEAEAE9D0EC4 },	// 5^-58
+	{ 0xC8DE047564D20A8B, 0xF245825A5A445275 },	// 5^-57
+	{ 0xFB158592BE068D2E, 0xEED6E2F0F0D56712 },	// 5^-56
+	{ 0x9CED737BB6C4183D, 0x55464DD69685606B },	// 5^-55
+	{ 0xC428D05AA4751E4C, 0xAA97E14C3C26B886 },	// 5^-54
+	{ 0xF53304714D9265DF, 0xD53DD99F4B3066A8 },	// 5^-53
+	{ 0x993FE2C6D07B7FAB, 0xE546A8038EFE4029 },	// 5^-52
+	{ 0xBF8FDB78849A5F96, 0xDE98520472BDD033 },	// 5^-51
+	{ 0xEF73D256A5C0F77C, 0x963E66858F6D4440 },	// 5^-50
+	{ 0x95A8637627989AAD, 0xDDE7001379A44AA8 },	// 5^-49
+	{ 0xBB127C53B17EC159, 0x5560C018580D5D52 },	// 5^-48
+	{ 0xE9D71B689DDE71AF, 0xAAB8F01E6E10B4A6 },	// 5^-47
+	{ 0x9226712162AB070D, 0xCAB3961304CA70E8 },	// 5^-46
+	{ 0xB6B00D69BB55C8D1, 0x3D607B97C5FD0D22 },	// 5^-45
+	{ 0xE45C10C42A2B3B05, 0x8CB89A7DB77C506A },	// 5^-44
+	{ 0x8EB98A7A9A5B04E3, 0x77F3608E92ADB242 },	// 5^-43
+	{ 0xB267ED1940F1C61C, 0x55F038B237591ED3 },	// 5^-42
+	{ 0xDF01E85F912E37A3, 0x6B6C46DEC52F6688 },	// 5^-41
+	{ 0x8B61313BBABCE2C6, 0x2323AC4B3B3DA015 },	// 5^-40
+	{ 0xAE397D8AA96C1B77, 0xABEC975E0A0D081A },	// 5^-39
+	{ 0xD9C7DCED53C72255, 0x96E7BD358C904A21 },	// 5^-38
+	{ 0x881CEA14545C7575, 0x7E50D64177DA2E54 },	// 5^-37
+	{ 0xAA242499697392D2, 0xDDE50BD1D5D0B9E9 },	// 5^-36
+	{ 0xD4AD2DBFC3D07787, 0x955E4EC64B44E864 },	// 5^-35
+	{ 0x84EC3C97DA624AB4, 0xBD5AF13BEF0B113E },	// 5^-34
+	{ 0xA6274BBDD0FADD61, 0xECB1AD8AEACDD58E },	// 5^-33
+	{ 0xCFB11EAD453994BA, 0x67DE18EDA5814AF2 },	// 5^-32
+	{ 0x81CEB32C4B43FCF4, 0x80EACF948770CED7 },	// 5^-31
+	{ 0xA2425FF75E14FC31, 0xA1258379A94D028D },	// 5^-30
+	{ 0xCAD2F7F5359A3B3E, 0x096EE45813A04330 },	// 5^-29
+	{ 0xFD87B5F28300CA0D, 0x8BCA9D6E188853FC },	// 5^-28
+	{ 0x9E74D1B791E07E48, 0x775EA264CF55347E },	// 5^-27
+	{ 0xC612062576589DDA, 0x95364AFE032A819E },	// 5^-26
+	{ 0xF79687AED3EEC551, 0x3A83DDBD83F52205 },	// 5^-25
+	{ 0x9ABE14CD44753B52, 0xC4926A9672793543 },	// 5^-24
+	{ 0xC16D9A0095928A27, 0x75B7053C0F178294 },	// 5^-23
+	{ 0xF1C90080BAF72CB1, 0x5324C68B12DD6339 },	// 5^-22
+	{ 0x971DA05074DA7BEE, 0xD3F6FC16EBCA5E04 },	// 5^-21
+	{ 0xBCE5086492111AEA, 0x88F4BB1CA6BCF585 },	// 5^-20
+	{ 0xEC1E4A7DB69561A5, 0x2B31E9E3D06C32E6 },	// 5^-19
+	{ 0x9392EE8E921D5D07, 0x3AFF322E62439FD0 },	// 5^-18
+	{ 0xB877AA3236A4B449, 0x09BEFEB9FAD487C3 },	// 5^-17
+	{ 0xE69594BEC44DE15B, 0x4C2EBE687989A9B4 },	// 5^-16
+	{ 0x901D7CF73AB0ACD9, 0x0F9D37014BF60A11 },	// 5^-15
+	{ 0xB424DC35095CD80F, 0x538484C19EF38C95 },	// 5^-14
+	{ 0xE12E13424BB40E13, 0x2865A5F206B06FBA },	// 5^-13
+	{ 0x8CBCCC096F5088CB, 0xF93F87B7442E45D4 },	// 5^-12
+	{ 0xAFEBFF0BCB24AAFE, 0xF78F69A51539D749 },	// 5^-11
+	{ 0xDBE6FECEBDEDD5BE, 0xB573440E5A884D1C },	// 5^-10
+	{ 0x89705F4136B4A597, 0x31680A88F8953031 },	// 5^-9
+	{ 0xABCC77118461CEFC, 0xFDC20D2B36BA7C3E },	// 5^-8
+	{ 0xD6BF94D5E57A42BC, 0x3D32907604691B4D },	// 5^-7
+	{ 0x8637BD05AF6C69B5, 0xA63F9A49C2C1B110 },	// 5^-6
+	{ 0xA7C5AC471B478423, 0x0FCF80DC33721D54 },	// 5^-5
+	{ 0xD1B71758E219652B, 0xD3C36113404EA4A9 },	// 5^-4
+	{ 0x83126E978D4FDF3B, 0x645A1CAC083126EA },	// 5^-3
+	{ 0xA3D70A3D70A3D70A, 0x3D70A3D70A3D70A4 },	// 5^-2
+	{ 0xCCCCCCCCCCCCCCCC, 0xCCCCCCCCCCCCCCCD },	// 5^-1
+	{ 0x8000000000000000, 0x0000000000000000 },	// 5^0
+	{ 0xA000000000000000, 0x0000000000000000 },	// 5^1
+	{ 0xC800000000000000, 0x0000000000000000 },	// 5^2
+	{ 0xFA00000000000000, 0x0000000000000000 },	// 5^3
+	{ 0x9C40000000000000, 0x0000000000000000 },	// 5^4
+	{ 0xC350000000000000, 0x0000000000000000 },	// 5^5
+	{ 0xF424000000000000, 0x0000000000000000 },	// 5^6
+	{ 0x9896800000000000, 0x0000000000000000 },	// 5^7
+	{ 0xBEBC200000000000, 0x0000000000000000 },	// 5^8
+	{ 0xEE6B280000000000, 0x0000000000000000 },	// 5^9
+	{ 0x9502F90000000000, 0x0000000000000000 },	// 5^10
+	{ 0xBA43B74000000000, 0x0000000000000000 },	// 5^11
+	{ 0xE8D4A51000000000, 0x0000000000000000 },	// 5^12
+	{ 0x9184E72A00000000, 0x0000000000000000 },	// 5^13
+	{ 0xB5E620F480000000, 0x0000000000000000 },	// 5^14
+	{ 0xE35FA931A0000000, 0x0000000000000000 },	// 5^15
+	{ 0x8E1BC9BF04000000, 0x0000000000000000 },	// 5^16
+	{ 0xB1A2BC2EC5000000, 0x0000000000000000 },	// 5^17
+	{ 0xDE0B6B3A76400000, 0x0000000000000000 },	// 5^18
+	{ 0x8AC7230489E80000, 0x0000000000000000 },	// 5^19
+	{ 0xAD78EBC5AC620000, 0x0000000000000000 },	// 5^20
+	{ 0xD8D726B7177A8000, 0x0000000000000000 },	// 5^21
+	{ 0x878678326EAC9000, 0x0000000000000000 },	// 5^22
+	{ 0xA968163F0A57B400, 0x0000000000000000 },	// 5^23
+	{ 0xD3C21BCECCEDA100, 0x0000000000000000 },	// 5^24
+	{ 0x84595161401484A0, 0x0000000000000000 },	// 5^25
+	{ 0xA56FA5B99019A5C8, 0x0000000000000000 },	// 5^26
+	{ 0xCECB8F27F4200F3A, 0x0000000000000000 },	// 5^27
+	{ 0x813F3978F8940984, 0x4000000000000000 },	// 5^28
+	{ 0xA18F07D736B90BE5, 0x5000000000000000 },	// 5^29
+	{ 0xC9F2C9CD04674EDE, 0xA400000000000000 },	// 5^30
+	{ 0xFC6F7C4045812296, 0x4D00000000000000 },	// 5^31
+	{ 0x9DC5ADA82B70B59D, 0xF020000000000000 },	// 5^32
+	{ 0xC5371912364CE305, 0x6C28000000000000 },	// 5^33
+	{ 0xF684DF56C3E01BC6, 0xC732000000000000 },	// 5^34
+	{ 0x9A130B963A6C115C, 0x3C7F400000000000 },	// 5^35
+	{ 0xC097CE7BC90715B3, 0x4B9F100000000000 },	// 5^36
+	{ 0xF0BDC21ABB48DB20, 0x1E86D40000000000 },	// 5^37
+	{ 0x96769950B50D88F4, 0x1314448000000000 },	// 5^38
+	{ 0xBC143FA4E250EB31, 0x17D955A000000000 },	// 5^39
+	{ 0xEB194F8E1AE525FD, 0x5DCFAB0800000000 },	// 5^40
+	{ 0x92EFD1B8D0CF37BE, 0x5AA1CAE500000000 },	// 5^41
+	{ 0xB7ABC627050305AD, 0xF14A3D9E40000000 },	// 5^42
+	{ 0xE596B7B0C643C719, 0x6D9CCD05D0000000 },	// 5^43
+	{ 0x8F7E32CE7BEA5C6F, 0xE4820023A2000000 },	// 5^44
+	{ 0xB35DBF821AE4F38B, 0xDDA2802C8A800000 },	// 5^45
+	{ 0xE0352F62A19E306E, 0xD50B2037AD200000 },	// 5^46
+	{ 0x8C213D9DA502DE45, 0x4526F422CC340000 },	// 5^47
+	{ 0xAF298D050E4395D6, 0x9670B12B7F410000 },	// 5^48
+	{ 0xDAF3F04651D47B4C, 0x3C0CDD765F114000 },	// 5^49
+	{ 0x88D8762BF324CD0F, 0xA5880A69FB6AC800 },	// 5^50
+	{ 0xAB0E93B6EFEE0053, 0x8EEA0D047A457A00 },	// 5^51
+	{ 0xD5D238A4ABE98068, 0x72A4904598D6D880 },	// 5^52
+	{ 0x85A36366EB71F041, 0x47A6DA2B7F864750 },	// 5^53
+	{ 0xA70C3C40A64E6C51, 0x999090B65F67D924 },	// 5^54
+	{ 0xD0CF4B50CFE20765, 0xFFF4B4E3F741CF6D },	// 5^55
+	{ 0x82818F1281ED449F, 0xBFF8F10E7A8921A4 },	// 5^56
+	{ 0xA321F2D7226895C7, 0xAFF72D52192B6A0D },	// 5^57
+	{ 0xCBEA6F8CEB02BB39, 0x9BF4F8A69F764490 },	// 5^58
+	{ 0xFEE50B7025C36A08, 0x02F236D04753D5B4 },	// 5^59
+	{ 0x9F4F2726179A2245, 0x01D762422C946590 },	// 5^60
+	{ 0xC722F0EF9D80AAD6, 0x424D3AD2B7B97EF5 },	// 5^61
+	{ 0xF8EBAD2B84E0D58B, 0xD2E0898765A7DEB2 },	// 5^62
+	{ 0x9B934C3B330C8577, 0x63CC55F49F88EB2F },	// 5^63
+	{ 0xC2781F49FFCFA6D5, 0x3CBF6B71C76B25FB },	// 5^64
+};
+mxSTATIC_ASSERT( mxCOUNT_OF(gs_pow5) == MAX_POW5 - MIN_POW5 + 1 );
+
+// the powers of ten which are exactly representable as doubles
+static const double gs_exactPow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static void Multiply64( UINT64 a, UINT64 b, UINT64 &_hi, UINT64 &_lo )
+{
+	const UINT64 M32 = 0xFFFFFFFF;
+	const UINT64 aLo = a & M32, aHi = a >> 32;
+	const UINT64 bLo = b & M32, bHi = b >> 32;
+	const UINT64 lolo = aLo * bLo;
+	const UINT64 hilo = aHi * bLo;
+	const UINT64 lohi = aLo * bHi;
+	const UINT64 hihi = aHi * bHi;
+	const UINT64 cross = (lolo >> 32) + (hilo & M32) + lohi;
+	_hi = hihi + (hilo >> 32) + (cross >> 32);
+	_lo = (cross << 32) | (lolo & M32);
+}
+
+static int CountLeadingZeros64( UINT64 x )
+{
+	int n = 0;
+	if( !(x & 0xFFFFFFFF00000000ULL) ) { n += 32; x <<= 32; }
+	if( !(x & 0xFFFF000000000000ULL) ) { n += 16; x <<= 16; }
+	if( !(x & 0xFF00000000000000ULL) ) { n += 8; x <<= 8; }
+	if( !(x & 0xF000000000000000ULL) ) { n += 4; x <<= 4; }
+	if( !(x & 0xC000000000000000ULL) ) { n += 2; x <<= 2; }
+	if( !(x & 0x8000000000000000ULL) ) { n += 1; }
+	return n;
+}
+
+// computes w * 10^q, returns false if the result cannot be determined quickly
+static bool ComputeDouble( UINT64 w, int q, bool isNegative, double &_value )
+{
+	if( w == 0 ) {
+		_value = isNegative ? -0.0 : 0.0;
+		return true;
+	}
+
+	// Clinger's fast path: both w and 10^q are exact doubles, the result is correctly rounded
+	if( w <= (UINT64(1) << 53) && q >= -22 && q <= 22 )
+	{
+		double value = (double) w;
+		value = (q < 0) ? value / gs_exactPow10[ -q ] : value * gs_exactPow10[ q ];
+		_value = isNegative ? -value : value;
+		return true;
+	}
+
+	if( q < MIN_POW5 || q > MAX_POW5 ) {
+		return false;
+	}
+	const Pow5& power = gs_pow5[ q - MIN_POW5 ];
+
+	int lz = CountLeadingZeros64( w );
+	w <<= lz;
+
+	UINT64 upper, lower;
+	Multiply64( w, power.hi, upper, lower );
+
+	if( (upper & 0x1FF) == 0x1FF && lower + w < lower )
+	{
+		// the lower bits may affect rounding, use the full 128-bit power
+		UINT64 upper2, lower2;
+		Multiply64( w, power.lo, upper2, lower2 );
+		const UINT64 middle = lower + upper2;
+		if( middle < lower ) {
+			upper++;
+		}
+		if( middle + 1 == 0 && (upper & 0x1FF) == 0x1FF && lower2 + w < lower2 ) {
+			return false;
+		}
+		lower = middle;
+	}
+
+	const UINT64 upperBit = upper >> 63;
+	UINT64 mantissa = upper >> (upperBit + 9);
+	lz += (int)(1 ^ upperBit);
+
+	// exactly halfway between two doubles?
+	if( lower == 0 && (upper & 0x1FF) == 0 && (mantissa & 3) == 1 ) {
+		return false;
+	}
+
+	// round to even
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+	if( mantissa >= (UINT64(1) << 53) ) {
+		mantissa = UINT64(1) << 52;
+		lz--;
+	}
+	mantissa &= ~(UINT64(1) << 52);
+
+	// floor(log2(10^q)) + exponent bias + 64
+	const INT64 biasedExponent = ((INT64(152170 + 65536) * q) >> 16) + 1087 - lz;
+	if( biasedExponent < 1 || biasedExponent > 2046 ) {
+		return false;	// denormals and infinities
+	}
+
+	UINT64 bits = mantissa | (UINT64(biasedExponent) << 52);
+	if( isNegative ) {
+		bits |= UINT64(1) << 63;
+	}
+	memcpy( &_value, &bits, sizeof(_value) );
+	return true;
+}
+
+static inline bool IsDigit( char c )
+{
+	return c >= '0' && c <= '9';
+}
+
+}//namespace
+
+const char* ParseDouble( const char* _text, double &_value )
+{
+	const char* p = _text;
+
+	bool isNegative = false;
+	if( *p == '-' ) {
+		isNegative = true;
+		p++;
+	} else if( *p == '+' ) {
+		p++;
+	}
+
+	UINT64 mantissa = 0;
+	int numDigits = 0;		// significant digits
+	int exponent = 0;
+	bool isTruncated = false;
+	bool hasDigits = false;
+
+	// integer part
+	while( IsDigit( *p ) )
+	{
+		hasDigits = true;
+		if( numDigits < MAX_DIGITS ) {
+			mantissa = mantissa * 10 + (*p - '0');
+			numDigits += (mantissa != 0);
+		} else {
+			isTruncated |= (*p != '0');
+			exponent++;
+		}
+		p++;
+	}
+
+	// fractional part
+	if( *p == '.' )
+	{
+		p++;
+		while( IsDigit( *p ) )
+		{
+			hasDigits = true;
+			if( numDigits < MAX_DIGITS ) {
+				mantissa = mantissa * 10 + (*p - '0');
+				numDigits += (mantissa != 0);
+				exponent--;
+			} else {
+				isTruncated |= (*p != '0');
+			}
+			p++;
+		}
+	}
+
+	if( !hasDigits )
+	{
+		// e.g. "inf", "nan"
+		char* end;
+		_value = strtod( _text, &end );
+		return (end != _text) ? end : NULL;
+	}
+
+	// exponent
+	if( *p == 'e' || *p == 'E' )
+	{
+		const char* exponentStart = p;
+		p++;
+		bool isNegativeExponent = false;
+		if( *p == '-' ) {
+			isNegativeExponent = true;
+			p++;
+		} else if( *p == '+' ) {
+			p++;
+		}
+		if( IsDigit( *p ) )
+		{
+			int explicitExponent = 0;
+			while( IsDigit( *p ) ) {
+				if( explicitExponent < 100000 ) {
+					explicitExponent = explicitExponent * 10 + (*p - '0');
+				}
+				p++;
+			}
+			exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+		}
+		else {
+			p = exponentStart;	// not an exponent
+		}
+	}
+
+	if( isTruncated || !ComputeDouble( mantissa, exponent, isNegative, _value ) )
+	{
+		// slow, but always correct
+		char* end;
+		_value = strtod( _text, &end );
+		mxASSERT(end == p);
+	}
+	return p;
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,35 @@
+/*
+=============================================================================
+	File:	NumberText.h
+	Desc:	Conversions between floating-point numbers and text
+			for text serializers (JSON, XML, SON).
+=============================================================================
+*/
+#pragma once
+
+namespace Reflection
+{
+	enum
+	{
+		// enough for any float/double, including the sign, the exponent and the terminating null
+		MAX_NUMBER_TEXT_LENGTH = 32
+	};
+
+	// Writes the shortest decimal representation which is read back as the same value
+	// (e.g. 0.1f is written as "0.1" rather than "0.10000000149011612");
+	// the text always contains '.' or 'e', so it's never parsed as an integer.
+	// Returns the length of the string (without the terminating null).
+	// NOTE: NaNs and infinities are written as "0.0".
+	UINT32 FormatFloat( float _value, char _buffer[MAX_NUMBER_TEXT_LENGTH] );
+	UINT32 FormatDouble( double _value, char _buffer[MAX_NUMBER_TEXT_LENGTH] );
+
+	// Parses a decimal number (e.g. "-12.5e-3"), the result is correctly rounded.
+	// Returns the pointer to the first character after the number or NULL if there's no number.
+	// NOTE: leading whitespace is not skipped.
+	const char* ParseDouble( const char* _text, double &_value );
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
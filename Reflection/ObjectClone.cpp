@@ -0,0 +1,397 @@
+/*
+=============================================================================
+	File:	ObjectClone.cpp
+	Desc:	Reflection-based deep copying of objects.
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <algorithm>
+
+#include <Base/Object/BaseType.h>
+#include <Base/Object/Reflection.h>
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/PointerType.h>
+#include <Base/Object/ClassPlan.h>
+#include <Base/Text/String.h>
+
+namespace Reflection
+{
+
+// copies adjacent POD fields with a single memcpy()
+static void CopyPlainFields( void * _dst, const void* _src, const mxClass& _type )
+{
+	const mxClass* currentType = &_type;
+	while( currentType != nil )
+	{
+		const mxClassLayout& layout = currentType->GetLayout();
+
+		UINT32 spanStart = 0;
+		UINT32 spanEnd = 0;	// zero if there's no span
+		for( UINT fieldIndex = 0; fieldIndex < layout.numFields; fieldIndex++ )
+		{
+			const mxField& field = layout.fields[ fieldIndex ];
+			if( !ETypeKind_Is_Bitwise_Serializable( field.type.m_kind ) ) {
+				continue;
+			}
+			if( spanEnd != 0 && field.offset == spanEnd ) {
+				spanEnd += field.type.m_size;
+				continue;
+			}
+			if( spanEnd != 0 ) {
+				memcpy( mxAddByteOffset( _dst, spanStart ), mxAddByteOffset( c_cast(void*)_src, spanStart ), spanEnd - spanStart );
+			}
+			spanStart = field.offset;
+			spanEnd = field.offset + field.type.m_size;
+		}
+		if( spanEnd != 0 ) {
+			memcpy( mxAddByteOffset( _dst, spanStart ), mxAddByteOffset( c_cast(void*)_src, spanStart ), spanEnd - spanStart );
+		}
+
+		currentType = currentType->GetParent();
+	}
+}
+
+/*
+-----------------------------------------------------------------------------
+	ObjectCloner
+	walks the source object, the context's user data points at the destination
+-----------------------------------------------------------------------------
+*/
+class ObjectCloner : public AVisitor2
+{
+	// maps a source memory block to the copied one
+	struct SMemoryBlock
+	{
+		const void *	source;
+		void *			clone;
+		UINT32			size;
+	public:
+		bool operator < ( const SMemoryBlock& other ) const
+		{
+			return source < other.source;
+		}
+	};
+	struct SPointerFixup
+	{
+		void **			address;	// pointer in the cloned object
+		const void *	target;		// pointee in the source object
+	};
+	TArray< SMemoryBlock >	m_blocks;
+	TArray< SPointerFixup >	m_pointers;
+
+	// if not NULL, all memory is allocated here
+	BYTE *	m_arena;
+	UINT32	m_arenaSize;
+	UINT32	m_arenaUsed;
+
+	ERet	m_status;
+
+public:
+	ObjectCloner()
+		: AVisitor2( TypeHas_Everything, Visitor_TrackPath )	// the context points at the destination
+	{
+		m_arena = NULL;
+		m_arenaSize = 0;
+		m_arenaUsed = 0;
+		m_status = ALL_OK;
+	}
+	void SetArena( void* _arena, UINT32 _size, UINT32 _used )
+	{
+		m_arena = static_cast< BYTE* >( _arena );
+		m_arenaSize = _size;
+		m_arenaUsed = _used;
+	}
+
+	ERet CloneObject( void * _dst, const void* _src, const mxClass& _type )
+	{
+		this->AddBlock( _src, _dst, _type.m_size );
+
+		Context	context;
+		context.userName = _type.GetTypeName();
+		context.userData = _dst;
+		Walker2::Visit( c_cast(void*)_src, _type, this, context );
+		mxDO(m_status);
+
+		this->RemapPointers();
+		return ALL_OK;
+	}
+
+	//-- AVisitor2
+	virtual bool Visit_Field( void * _memory, const mxField& _field, const Context& _context ) override
+	{
+		if( ETypeKind_Is_Bitwise_Serializable( _field.type.m_kind ) ) {
+			return false;	// already copied by the enclosing class
+		}
+		_context.userData = mxAddByteOffset( _context.userData, _field.offset );
+		return true;
+	}
+	virtual bool Visit_Class( void * _object, const mxClass& _type, const Context& _context ) override
+	{
+		if( m_arena ) {
+			// the object has already been copied bit-by-bit
+			return !IsBitwiseCopyable( _type );
+		}
+		if( IsBitwiseCopyable( _type ) ) {
+			memcpy( _context.userData, _object, _type.m_size );
+			return false;
+		}
+		CopyPlainFields( _context.userData, _object, _type );
+		return true;
+	}
+	virtual bool Visit_Array( void * _array, const mxArray& _type, const Context& _context ) override
+	{
+		void* dstArray = _context.userData;
+
+		const UINT32 count = _type.Generic_Get_Count( _array );
+		const void* srcData = _type.Generic_Get_Data( _array );
+		const mxType& itemType = _type.m_itemType;
+		const UINT32 itemStride = _type.m_itemSize;
+
+		void* dstData = NULL;
+		if( _type.IsDynamic() )
+		{
+			if( m_arena )
+			{
+				// the clone doesn't own the memory and cannot shrink the array,
+				// so the whole capacity must be reserved
+				const UINT32 capacity = _type.Generic_Get_Capacity( _array );
+				if( capacity )
+				{
+					dstData = this->AllocateFromArena( capacity * itemStride, itemType.m_align );
+					if( count ) {
+						memcpy( dstData, srcData, count * itemStride );
+					}
+					*(void**) _type.Get_Array_Pointer_Address( dstArray ) = dstData;
+					_type.SetDontFreeMemory( dstArray );
+				}
+			}
+			else
+			{
+				// allocate exactly as much memory as needed
+				if( !_type.Generic_Set_Capacity( dstArray, count ) || !_type.Generic_Set_Count( dstArray, count ) ) {
+					m_status = ERR_OUT_OF_MEMORY;
+					return false;
+				}
+				dstData = _type.Generic_Get_Data( dstArray );
+			}
+		}
+		else
+		{
+			// the array is embedded into the object
+			dstData = _type.Generic_Get_Data( dstArray );
+		}
+
+		if( !count ) {
+			return false;
+		}
+
+		// embedded arrays lie inside the block of the enclosing object,
+		// only separately allocated memory is registered, so the blocks never overlap
+		if( _type.IsDynamic() ) {
+			this->AddBlock( srcData, dstData, count * itemStride );
+		}
+
+		if( IsBitwiseCopyable( itemType ) )
+		{
+			if( !m_arena ) {
+				memcpy( dstData, srcData, count * itemStride );
+			}
+			return false;
+		}
+
+		// copy elements one by one
+		Context	itemContext( _context.depth + 1 );
+		itemContext.parent = &_context;
+		for( UINT32 i = 0; i < count; i++ )
+		{
+			itemContext.userData = mxAddByteOffset( dstData, i * itemStride );
+			Walker2::Visit( mxAddByteOffset( c_cast(void*)srcData, i * itemStride ), itemType, this, itemContext );
+		}
+		// the elements have already been visited
+		return false;
+	}
+	virtual void Visit_POD( void * _memory, const mxType& _type, const Context& _context ) override
+	{
+		// e.g. elements of dynamic arrays
+		memcpy( _context.userData, _memory, _type.m_size );
+	}
+	virtual void Visit_String( String & _string, const Context& _context ) override
+	{
+		String& dstString = *static_cast< String* >( _context.userData );
+		if( m_arena )
+		{
+			// the clone contains a bitwise copy of the source string
+			new(&dstString) String();
+			if( _string.NonEmpty() )
+			{
+				char* chars = (char*) this->AllocateFromArena( _string.Length() + 1, 1 );
+				memcpy( chars, _string.ToPtr(), _string.Length() + 1 );
+				dstString.SetReference( Chars( chars ) );
+			}
+		}
+		else
+		{
+			Str::CopyS( dstString, _string.ToPtr(), _string.Length() );
+		}
+	}
+	virtual void Visit_TypeId( SClassId * _class, const Context& _context ) override
+	{
+		*static_cast< SClassId* >( _context.userData ) = *_class;
+	}
+	virtual void Visit_AssetId( AssetID & _assetId, const Context& _context ) override
+	{
+		// in the arena, the destination contains a bitwise copy of the source
+		AssetID* dstAssetId = static_cast< AssetID* >( _context.userData );
+		CopyAssetID( dstAssetId, _assetId, m_arena == NULL );
+	}
+	virtual void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context ) override
+	{
+		// pointers are patched after all memory blocks have been copied
+		SPointerFixup & newFixup = m_pointers.Add();
+		newFixup.address = static_cast< void** >( _context.userData );
+		newFixup.target = _pointer.o;
+	}
+	virtual void Visit_UserPointer( void * _pointer, const mxUserPointerType& _type, const Context& _context ) override
+	{
+		memcpy( _context.userData, _pointer, _type.m_size );
+	}
+
+private:
+	void AddBlock( const void* _source, void* _clone, UINT32 _size )
+	{
+		SMemoryBlock & newBlock = m_blocks.Add();
+		newBlock.source = _source;
+		newBlock.clone = _clone;
+		newBlock.size = _size;
+	}
+	void* AllocateFromArena( UINT32 _size, UINT32 _alignment )
+	{
+		const UINT32 offset = AlignUp( m_arenaUsed, largest( _alignment, 1U ) );
+		mxASSERT( offset + _size <= m_arenaSize );
+		m_arenaUsed = offset + _size;
+		return m_arena + offset;
+	}
+	// pointers into the copied memory blocks are redirected to the clone,
+	// pointers to external memory are copied as-is
+	void RemapPointers()
+	{
+		const UINT32 numBlocks = m_blocks.Num();
+		SMemoryBlock* blocks = m_blocks.ToPtr();
+		std::sort( blocks, blocks + numBlocks );
+
+		for( UINT32 iPointer = 0; iPointer < m_pointers.Num(); iPointer++ )
+		{
+			const SPointerFixup& fixup = m_pointers[ iPointer ];
+			void* newTarget = c_cast(void*) fixup.target;
+			if( fixup.target != nil )
+			{
+				// find the last block starting at or before the target
+				// (the blocks don't overlap, so it's the only one which can contain it)
+				UINT32 lo = 0;
+				UINT32 hi = numBlocks;
+				while( lo < hi )
+				{
+					const UINT32 mid = lo + (hi - lo) / 2;
+					if( blocks[ mid ].source <= fixup.target ) {
+						lo = mid + 1;
+					} else {
+						hi = mid;
+					}
+				}
+				if( lo > 0 )
+				{
+					const SMemoryBlock& block = blocks[ lo - 1 ];
+					const ptrdiff_t offset = (const char*)fixup.target - (const char*)block.source;
+					if( offset < block.size ) {
+						newTarget = mxAddByteOffset( block.clone, offset );
+					}
+				}
+			}
+			*fixup.address = newTarget;
+		}
+	}
+};
+
+/*
+-----------------------------------------------------------------------------
+	ArenaSizeCounter
+	calculates the size of the memory block needed for cloning the object
+-----------------------------------------------------------------------------
+*/
+class ArenaSizeCounter : public AVisitor2
+{
+public:
+	UINT32	m_totalSize;
+public:
+	ArenaSizeCounter( UINT32 _initialSize )
+		: m_totalSize( _initialSize )
+	{}
+	virtual bool Visit_Class( void * _object, const mxClass& _type, const Context& _context ) override
+	{
+		return !IsBitwiseCopyable( _type );
+	}
+	virtual bool Visit_Array( void * _array, const mxArray& _type, const Context& _context ) override
+	{
+		if( _type.IsDynamic() )
+		{
+			const UINT32 capacity = _type.Generic_Get_Capacity( _array );
+			if( capacity ) {
+				m_totalSize = AlignUp( m_totalSize, largest( _type.m_itemType.m_align, 1U ) );
+				m_totalSize += capacity * _type.m_itemSize;
+			}
+		}
+		return !IsBitwiseCopyable( _type.m_itemType );
+	}
+	virtual void Visit_String( String & _string, const Context& _context ) override
+	{
+		if( _string.NonEmpty() ) {
+			m_totalSize += _string.Length() + 1;
+		}
+	}
+};
+
+ERet Clone( void * _dst, const void* _src, const mxClass& _type )
+{
+	mxASSERT_PTR(_dst);
+	mxASSERT_PTR(_src);
+	mxASSERT(_dst != _src);
+
+	ObjectCloner	cloner;
+	mxDO(cloner.CloneObject( _dst, _src, _type ));
+	return ALL_OK;
+}
+
+ERet CloneIntoSingleBlock( void *& _clone, const void* _src, const mxClass& _type )
+{
+	mxASSERT_PTR(_src);
+	mxASSERT(_type.m_align <= EFFICIENT_ALIGNMENT);
+
+	ArenaSizeCounter	sizeCounter( _type.m_size );
+	Walker2::Visit( c_cast(void*)_src, _type, &sizeCounter );
+
+	void* arena = mxAlloc( sizeCounter.m_totalSize );
+	chkRET_X_IF_NIL(arena, ERR_OUT_OF_MEMORY);
+
+	// all fields are copied bit-by-bit, strings and arrays are fixed up by the cloner
+	memcpy( arena, _src, _type.m_size );
+
+	ObjectCloner	cloner;
+	cloner.SetArena( arena, sizeCounter.m_totalSize, _type.m_size );
+	const ERet result = cloner.CloneObject( arena, _src, _type );
+	if( result != ALL_OK ) {
+		mxFree( arena );
+		return result;
+	}
+
+	_clone = arena;
+	return ALL_OK;
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,180 @@
+/*
+=============================================================================
+	File:	ObjectCompare.cpp
+	Desc:	Reflection-based comparison of objects.
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/ClassPlan.h>
+#include <Base/Text/String.h>
+
+namespace Reflection
+{
+
+static bool ObjectsAreEqual( const mxClassPlan& _plan, const void* _o1, const void* _o2 );
+static bool ArraysAreEqual( const mxArray& _type, const void* _a1, const void* _a2 );
+
+bool StringsAreEqual( const String& _s1, const String& _s2 )
+{
+	// compare lengths first
+	const UINT32 length = _s1.Length();
+	return length == _s2.Length()
+		&& (length == 0 || memcmp( _s1.ToPtr(), _s2.ToPtr(), length ) == 0)
+		;
+}
+
+bool ValuesAreEqual( const mxType& _type, const void* _v1, const void* _v2 )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Integer :
+	case ETypeKind::Type_Float :
+	case ETypeKind::Type_Bool :
+	case ETypeKind::Type_Enum :
+	case ETypeKind::Type_Flags :
+	case ETypeKind::Type_ClassId :
+	case ETypeKind::Type_Pointer :
+	case ETypeKind::Type_UserData :
+		return memcmp( _v1, _v2, _type.m_size ) == 0;
+
+	case ETypeKind::Type_String :
+		return StringsAreEqual( *static_cast< const String* >( _v1 ), *static_cast< const String* >( _v2 ) );
+
+	case ETypeKind::Type_Class :
+		return ObjectsAreEqual( GetClassPlan( _type.UpCast< mxClass >() ), _v1, _v2 );
+
+	case ETypeKind::Type_AssetId :
+		return strcmp( GetAssetIDName( *static_cast< const AssetID* >( _v1 ) ), GetAssetIDName( *static_cast< const AssetID* >( _v2 ) ) ) == 0;
+
+	case ETypeKind::Type_Array :
+		return ArraysAreEqual( _type.UpCast< mxArray >(), _v1, _v2 );
+
+	case ETypeKind::Type_Blob :
+		Unimplemented;
+		break;
+
+		mxNO_SWITCH_DEFAULT;
+	}
+	return false;
+}
+
+static bool ArraysAreEqual( const mxArray& _type, const void* _a1, const void* _a2 )
+{
+	// compare counts first
+	const UINT32 count = _type.Generic_Get_Count( _a1 );
+	if( count != _type.Generic_Get_Count( _a2 ) ) {
+		return false;
+	}
+	if( !count ) {
+		return true;
+	}
+
+	const void* data1 = _type.Generic_Get_Data( _a1 );
+	const void* data2 = _type.Generic_Get_Data( _a2 );
+	if( data1 == data2 ) {
+		return true;
+	}
+
+	const mxType& itemType = _type.m_itemType;
+	const UINT32 itemStride = _type.m_itemSize;
+
+	// arrays of POD elements without padding are compared in bulk
+	if( itemStride == itemType.m_size && IsDenseType( itemType ) ) {
+		return memcmp( data1, data2, count * itemStride ) == 0;
+	}
+
+	if( itemType.m_kind == ETypeKind::Type_Class )
+	{
+		const mxClassPlan& itemPlan = GetClassPlan( itemType.UpCast< mxClass >() );
+		for( UINT32 i = 0; i < count; i++ )
+		{
+			const UINT32 itemOffset = i * itemStride;
+			if( !ObjectsAreEqual( itemPlan, mxAddByteOffset( c_cast(void*)data1, itemOffset ), mxAddByteOffset( c_cast(void*)data2, itemOffset ) ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	for( UINT32 i = 0; i < count; i++ )
+	{
+		const UINT32 itemOffset = i * itemStride;
+		if( !ValuesAreEqual( itemType, mxAddByteOffset( c_cast(void*)data1, itemOffset ), mxAddByteOffset( c_cast(void*)data2, itemOffset ) ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool ObjectsAreEqual( const mxClassPlan& _plan, const void* _o1, const void* _o2 )
+{
+	const mxPlanOp* ops = _plan.ops.ToPtr();
+	const UINT32 numOps = _plan.ops.Num();
+
+	for( UINT32 i = 0; i < numOps; i++ )
+	{
+		const mxPlanOp& op = ops[i];
+		const void* field1 = mxAddByteOffset( c_cast(void*)_o1, op.offset );
+		const void* field2 = mxAddByteOffset( c_cast(void*)_o2, op.offset );
+
+		switch( op.op )
+		{
+		case PlanOp_Bytes :
+		case PlanOp_ClassId :
+		case PlanOp_UserPointer :
+		case PlanOp_Pointer :	// pointers are compared by address
+			if( memcmp( field1, field2, op.size ) != 0 ) {
+				return false;
+			}
+			break;
+
+		case PlanOp_String :
+			if( !StringsAreEqual( *static_cast< const String* >( field1 ), *static_cast< const String* >( field2 ) ) ) {
+				return false;
+			}
+			break;
+
+		case PlanOp_Array :
+			if( !ArraysAreEqual( op.type->UpCast< mxArray >(), field1, field2 ) ) {
+				return false;
+			}
+			break;
+
+		case PlanOp_AssetId :
+			if( !ValuesAreEqual( *op.type, field1, field2 ) ) {
+				return false;
+			}
+			break;
+
+			mxNO_SWITCH_DEFAULT;
+		}
+	}
+	return true;
+}
+
+bool ObjectsAreEqual( const mxClass& _type1, const void* _o1, const mxClass& _type2, const void* _o2 )
+{
+	mxASSERT_PTR(_o1);
+	mxASSERT_PTR(_o2);
+	if( _type1 != _type2 ) {
+		return false;
+	}
+	if( _o1 == _o2 ) {
+		return true;
+	}
+	const mxClassPlan& plan = GetClassPlan( _type1 );
+	if( plan.isDense ) {
+		return memcmp( _o1, _o2, _type1.m_size ) == 0;
+	}
+	return ObjectsAreEqual( plan, _o1, _o2 );
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
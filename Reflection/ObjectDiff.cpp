@@ -0,0 +1,939 @@
+/*
+=============================================================================
+	File:	ObjectDiff.cpp
+	Desc:	Reflection-based binary diffs (patches) between two versions
+			of an object (e.g. for undo/redo, hot-reloading and networking).
+
+	Patch format:
+		TypeID of the patched class, then the object patch:
+			{ UINT32 op index (in the class plan), op patch }, terminated with END_OF_OBJECT.
+
+		Spans of POD fields:	UINT32 start, UINT32 length, new bytes.
+		Strings:				UINT32 length, characters.
+		Class ids:				TypeID (mxNULL_TYPE_ID for null).
+		User pointers:			UINT32 persistent id.
+		Arrays:					UINT32 EArrayPatch, then
+			ArrayPatch_Elements:	UINT32 count, { UINT32 index, element patch }
+			ArrayPatch_Splice:		UINT32 start, UINT32 remove count, UINT32 insert count, new elements.
+
+		Elements of arrays are patched as objects (classes), arrays (nested arrays)
+		or written in full (all other types).
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/UserPointerType.h>
+#include <Base/Object/TypeRegistry.h>
+#include <Base/Object/ClassPlan.h>
+#include <Base/Text/String.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define MX_USE_SSE2_DIFF	(1)
+	#include <emmintrin.h>
+#else
+	#define MX_USE_SSE2_DIFF	(0)
+#endif
+
+namespace Reflection
+{
+
+static const UINT32 END_OF_OBJECT = ~0U;
+
+enum EArrayPatch
+{
+	ArrayPatch_Elements,	// the number of elements didn't change, only modified elements are stored
+	ArrayPatch_Splice,		// a range of elements has been replaced
+};
+
+/*
+-----------------------------------------------------------------------------
+	Byte range comparison
+-----------------------------------------------------------------------------
+*/
+
+// returns the offset of the first differing byte or _size if the memory blocks are equal
+static UINT32 FindFirstDifference( const BYTE* _a, const BYTE* _b, UINT32 _size )
+{
+	UINT32 i = 0;
+#if MX_USE_SSE2_DIFF
+	// skip equal 64-byte blocks
+	for( ; i + 64 <= _size; i += 64 )
+	{
+		const __m128i eq0 = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) (_a + i) ), _mm_loadu_si128( (const __m128i*) (_b + i) ) );
+		const __m128i eq1 = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) (_a + i + 16) ), _mm_loadu_si128( (const __m128i*) (_b + i + 16) ) );
+		const __m128i eq2 = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) (_a + i + 32) ), _mm_loadu_si128( (const __m128i*) (_b + i + 32) ) );
+		const __m128i eq3 = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) (_a + i + 48) ), _mm_loadu_si128( (const __m128i*) (_b + i + 48) ) );
+		const __m128i eq = _mm_and_si128( _mm_and_si128( eq0, eq1 ), _mm_and_si128( eq2, eq3 ) );
+		if( _mm_movemask_epi8( eq ) != 0xFFFF ) {
+			break;
+		}
+	}
+	// skip equal 16-byte blocks
+	for( ; i + 16 <= _size; i += 16 )
+	{
+		const __m128i eq = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) (_a + i) ), _mm_loadu_si128( (const __m128i*) (_b + i) ) );
+		if( _mm_movemask_epi8( eq ) != 0xFFFF ) {
+			break;
+		}
+	}
+#endif
+	for( ; i < _size; i++ )
+	{
+		if( _a[i] != _b[i] ) {
+			return i;
+		}
+	}
+	return _size;
+}
+
+// returns the offset past the last differing byte or 0 if the memory blocks are equal
+static UINT32 FindLastDifference( const BYTE* _a, const BYTE* _b, UINT32 _size )
+{
+	UINT32 i = _size;
+#if MX_USE_SSE2_DIFF
+	for( ; i >= 64; i -= 64 )
+	{
+		const BYTE* a = _a + i - 64;
+		const BYTE* b = _b + i - 64;
+		const __m128i eq0 = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) a ), _mm_loadu_si128( (const __m128i*) b ) );
+		const __m128i eq1 = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) (a + 16) ), _mm_loadu_si128( (const __m128i*) (b + 16) ) );
+		const __m128i eq2 = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) (a + 32) ), _mm_loadu_si128( (const __m128i*) (b + 32) ) );
+		const __m128i eq3 = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) (a + 48) ), _mm_loadu_si128( (const __m128i*) (b + 48) ) );
+		const __m128i eq = _mm_and_si128( _mm_and_si128( eq0, eq1 ), _mm_and_si128( eq2, eq3 ) );
+		if( _mm_movemask_epi8( eq ) != 0xFFFF ) {
+			break;
+		}
+	}
+	for( ; i >= 16; i -= 16 )
+	{
+		const __m128i eq = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) (_a + i - 16) ), _mm_loadu_si128( (const __m128i*) (_b + i - 16) ) );
+		if( _mm_movemask_epi8( eq ) != 0xFFFF ) {
+			break;
+		}
+	}
+#endif
+	for( ; i > 0; i-- )
+	{
+		if( _a[i-1] != _b[i-1] ) {
+			return i;
+		}
+	}
+	return 0;
+}
+
+// arrays of POD elements without padding are compared/copied in bulk
+static inline bool HasDenseItems( const mxArray& _type )
+{
+	return _type.m_itemSize == _type.m_itemType.m_size && IsDenseType( _type.m_itemType );
+}
+
+static inline TypeID GetClassIdValue( const void* _classId )
+{
+	const mxClass* classType = static_cast< const SClassId* >( _classId )->type;
+	return classType ? classType->GetTypeID() : mxNULL_TYPE_ID;
+}
+
+/*
+-----------------------------------------------------------------------------
+	PatchWriter
+-----------------------------------------------------------------------------
+*/
+class PatchWriter
+{
+	TArray< BYTE > &	m_buffer;
+public:
+	PatchWriter( TArray< BYTE > & _buffer )
+		: m_buffer( _buffer )
+	{}
+	ERet Write( const void* _data, UINT32 _size )
+	{
+		const UINT32 oldSize = m_buffer.Num();
+		mxDO(m_buffer.SetNum( oldSize + _size ));
+		memcpy( m_buffer.ToPtr() + oldSize, _data, _size );
+		return ALL_OK;
+	}
+	ERet WriteU32( UINT32 _value )
+	{
+		return this->Write( &_value, sizeof(_value) );
+	}
+	UINT32 Tell() const
+	{
+		return m_buffer.Num();
+	}
+	// discards everything written after the given position
+	void Truncate( UINT32 _position )
+	{
+		mxASSERT( _position <= m_buffer.Num() );
+		m_buffer.SetNum( _position );
+	}
+	void OverwriteU32( UINT32 _position, UINT32 _value )
+	{
+		mxASSERT( _position + sizeof(_value) <= m_buffer.Num() );
+		memcpy( m_buffer.ToPtr() + _position, &_value, sizeof(_value) );
+	}
+private:	NO_COPY_CONSTRUCTOR(PatchWriter);
+private:	NO_ASSIGNMENT(PatchWriter);
+};
+
+/*
+-----------------------------------------------------------------------------
+	PatchReader
+	all reads are bounds-checked, patches can come from untrusted sources
+-----------------------------------------------------------------------------
+*/
+class PatchReader
+{
+	const BYTE *	m_data;
+	UINT32			m_size;
+	UINT32			m_position;
+public:
+	PatchReader( const void* _data, UINT32 _size )
+		: m_data( static_cast< const BYTE* >( _data ) ), m_size( _size ), m_position( 0 )
+	{}
+	// returns NULL if there's not enough data
+	const void* Skip( UINT32 _size )
+	{
+		if( _size > m_size - m_position ) {
+			return NULL;
+		}
+		const void* start = m_data + m_position;
+		m_position += _size;
+		return start;
+	}
+	ERet Read( void * _buffer, UINT32 _size )
+	{
+		const void* source = this->Skip( _size );
+		chkRET_X_IF_NIL(source, ERR_FAILED_TO_PARSE_DATA);
+		memcpy( _buffer, source, _size );
+		return ALL_OK;
+	}
+	ERet ReadU32( UINT32 &_value )
+	{
+		return this->Read( &_value, sizeof(_value) );
+	}
+	UINT32 Remaining() const
+	{
+		return m_size - m_position;
+	}
+};
+
+/*
+-----------------------------------------------------------------------------
+	Full values (new array elements)
+	pointers and asset ids are not stored
+-----------------------------------------------------------------------------
+*/
+static ERet WriteValue( PatchWriter & _writer, const mxType& _type, const void* _value );
+
+static ERet WriteString( PatchWriter & _writer, const String& _string )
+{
+	const UINT32 length = _string.Length();
+	mxDO(_writer.WriteU32( length ));
+	if( length ) {
+		mxDO(_writer.Write( _string.ToPtr(), length ));
+	}
+	return ALL_OK;
+}
+
+static ERet WriteArray( PatchWriter & _writer, const mxArray& _type, const void* _array )
+{
+	const UINT32 count = _type.Generic_Get_Count( _array );
+	mxDO(_writer.WriteU32( count ));
+	if( !count ) {
+		return ALL_OK;
+	}
+	const void* data = _type.Generic_Get_Data( _array );
+	if( HasDenseItems( _type ) ) {
+		return _writer.Write( data, count * _type.m_itemSize );
+	}
+	for( UINT32 i = 0; i < count; i++ )
+	{
+		mxDO(WriteValue( _writer, _type.m_itemType, mxAddByteOffset( c_cast(void*)data, i * _type.m_itemSize ) ));
+	}
+	return ALL_OK;
+}
+
+static ERet WriteObject( PatchWriter & _writer, const mxClassPlan& _plan, const void* _o )
+{
+	for( UINT32 i = 0; i < _plan.ops.Num(); i++ )
+	{
+		const mxPlanOp& op = _plan.ops[i];
+		const void* field = mxAddByteOffset( c_cast(void*)_o, op.offset );
+		if( op.op == PlanOp_Bytes ) {
+			mxDO(_writer.Write( field, op.size ));
+		} else {
+			mxDO(WriteValue( _writer, *op.type, field ));
+		}
+	}
+	return ALL_OK;
+}
+
+static ERet WriteValue( PatchWriter & _writer, const mxType& _type, const void* _value )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Integer :
+	case ETypeKind::Type_Float :
+	case ETypeKind::Type_Bool :
+	case ETypeKind::Type_Enum :
+	case ETypeKind::Type_Flags :
+		return _writer.Write( _value, _type.m_size );
+
+	case ETypeKind::Type_String :
+		return WriteString( _writer, *static_cast< const String* >( _value ) );
+
+	case ETypeKind::Type_Class :
+		return WriteObject( _writer, GetClassPlan( _type.UpCast< mxClass >() ), _value );
+
+	case ETypeKind::Type_Array :
+		return WriteArray( _writer, _type.UpCast< mxArray >(), _value );
+
+	case ETypeKind::Type_ClassId :
+		return _writer.WriteU32( GetClassIdValue( _value ) );
+
+	case ETypeKind::Type_UserData :
+		return _writer.WriteU32( _type.UpCast< mxUserPointerType >().GetPersistentBinaryId( _value ) );
+
+	case ETypeKind::Type_Pointer :
+	case ETypeKind::Type_AssetId :
+		return ALL_OK;
+
+	case ETypeKind::Type_Blob :
+		Unimplemented;
+		break;
+
+		mxNO_SWITCH_DEFAULT;
+	}
+	return ERR_INVALID_PARAMETER;
+}
+
+// the destination must be a constructed value
+static ERet ReadValue( PatchReader & _reader, const mxType& _type, void * _value );
+
+static ERet ReadString( PatchReader & _reader, String & _string )
+{
+	UINT32 length;
+	mxDO(_reader.ReadU32( length ));
+	const void* chars = _reader.Skip( length );
+	chkRET_X_IF_NIL(chars, ERR_FAILED_TO_PARSE_DATA);
+	Str::CopyS( _string, static_cast< const char* >( chars ), length );
+	return ALL_OK;
+}
+
+static ERet ReadClassId( PatchReader & _reader, void * _classId )
+{
+	TypeID typeId;
+	mxDO(_reader.ReadU32( typeId ));
+	const mxClass* classType = nil;
+	if( typeId != mxNULL_TYPE_ID ) {
+		classType = TypeRegistry::Get().FindClassByGuid( typeId );
+		chkRET_X_IF_NIL(classType, ERR_OBJECT_OF_WRONG_TYPE);
+	}
+	static_cast< SClassId* >( _classId )->type = classType;
+	return ALL_OK;
+}
+
+static ERet ReadUserPointer( PatchReader & _reader, const mxUserPointerType& _type, void * _pointer )
+{
+	UINT32 id;
+	mxDO(_reader.ReadU32( id ));
+	_type.SetFromBinaryId( _pointer, id );
+	return ALL_OK;
+}
+
+// resizes the array, static arrays cannot change their size
+static ERet ResizeArray( const mxArray& _type, void * _array, UINT32 _newCount )
+{
+	if( _type.Generic_Get_Count( _array ) == _newCount ) {
+		return ALL_OK;
+	}
+	chkRET_X_IF_NOT(_type.IsDynamic(), ERR_FAILED_TO_PARSE_DATA);
+	chkRET_X_IF_NOT(_type.Generic_Set_Count( _array, _newCount ), ERR_OUT_OF_MEMORY);
+	return ALL_OK;
+}
+
+static ERet ReadElements( PatchReader & _reader, const mxArray& _type, void * _data, UINT32 _count )
+{
+	if( HasDenseItems( _type ) ) {
+		return _reader.Read( _data, _count * _type.m_itemSize );
+	}
+	for( UINT32 i = 0; i < _count; i++ )
+	{
+		mxDO(ReadValue( _reader, _type.m_itemType, mxAddByteOffset( _data, i * _type.m_itemSize ) ));
+	}
+	return ALL_OK;
+}
+
+static ERet ReadArray( PatchReader & _reader, const mxArray& _type, void * _array )
+{
+	UINT32 count;
+	mxDO(_reader.ReadU32( count ));
+	// don't allocate huge arrays for corrupted patches
+	if( HasDenseItems( _type ) ) {
+		chkRET_X_IF_NOT(count <= _reader.Remaining() / _type.m_itemSize, ERR_FAILED_TO_PARSE_DATA);
+	}
+	mxDO(ResizeArray( _type, _array, count ));
+	if( !count ) {
+		return ALL_OK;
+	}
+	return ReadElements( _reader, _type, _type.Generic_Get_Data( _array ), count );
+}
+
+static ERet ReadObject( PatchReader & _reader, const mxClassPlan& _plan, void * _o )
+{
+	for( UINT32 i = 0; i < _plan.ops.Num(); i++ )
+	{
+		const mxPlanOp& op = _plan.ops[i];
+		void* field = mxAddByteOffset( _o, op.offset );
+		if( op.op == PlanOp_Bytes ) {
+			mxDO(_reader.Read( field, op.size ));
+		} else {
+			mxDO(ReadValue( _reader, *op.type, field ));
+		}
+	}
+	return ALL_OK;
+}
+
+static ERet ReadValue( PatchReader & _reader, const mxType& _type, void * _value )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Integer :
+	case ETypeKind::Type_Float :
+	case ETypeKind::Type_Bool :
+	case ETypeKind::Type_Enum :
+	case ETypeKind::Type_Flags :
+		return _reader.Read( _value, _type.m_size );
+
+	case ETypeKind::Type_String :
+		return ReadString( _reader, *static_cast< String* >( _value ) );
+
+	case ETypeKind::Type_Class :
+		return ReadObject( _reader, GetClassPlan( _type.UpCast< mxClass >() ), _value );
+
+	case ETypeKind::Type_Array :
+		return ReadArray( _reader, _type.UpCast< mxArray >(), _value );
+
+	case ETypeKind::Type_ClassId :
+		return ReadClassId( _reader, _value );
+
+	case ETypeKind::Type_UserData :
+		return ReadUserPointer( _reader, _type.UpCast< mxUserPointerType >(), _value );
+
+	case ETypeKind::Type_Pointer :
+	case ETypeKind::Type_AssetId :
+		return ALL_OK;
+
+	case ETypeKind::Type_Blob :
+		Unimplemented;
+		break;
+
+		mxNO_SWITCH_DEFAULT;
+	}
+	return ERR_INVALID_PARAMETER;
+}
+
+// deep assignment, used for moving elements of arrays
+static ERet AssignValue( const mxType& _type, void * _dst, const void* _src );
+
+static ERet AssignArray( const mxArray& _type, void * _dst, const void* _src )
+{
+	const UINT32 count = _type.Generic_Get_Count( _src );
+	mxDO(ResizeArray( _type, _dst, count ));
+	if( !count ) {
+		return ALL_OK;
+	}
+	void* dstData = _type.Generic_Get_Data( _dst );
+	const void* srcData = _type.Generic_Get_Data( _src );
+	if( HasDenseItems( _type ) ) {
+		memcpy( dstData, srcData, count * _type.m_itemSize );
+		return ALL_OK;
+	}
+	for( UINT32 i = 0; i < count; i++ )
+	{
+		const UINT32 itemOffset = i * _type.m_itemSize;
+		mxDO(AssignValue( _type.m_itemType, mxAddByteOffset( dstData, itemOffset ), mxAddByteOffset( c_cast(void*)srcData, itemOffset ) ));
+	}
+	return ALL_OK;
+}
+
+static ERet AssignObject( const mxClassPlan& _plan, void * _dst, const void* _src )
+{
+	for( UINT32 i = 0; i < _plan.ops.Num(); i++ )
+	{
+		const mxPlanOp& op = _plan.ops[i];
+		void* dstField = mxAddByteOffset( _dst, op.offset );
+		const void* srcField = mxAddByteOffset( c_cast(void*)_src, op.offset );
+		if( op.op == PlanOp_Bytes ) {
+			memcpy( dstField, srcField, op.size );
+		} else {
+			mxDO(AssignValue( *op.type, dstField, srcField ));
+		}
+	}
+	return ALL_OK;
+}
+
+static ERet AssignValue( const mxType& _type, void * _dst, const void* _src )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Integer :
+	case ETypeKind::Type_Float :
+	case ETypeKind::Type_Bool :
+	case ETypeKind::Type_Enum :
+	case ETypeKind::Type_Flags :
+	case ETypeKind::Type_ClassId :
+	case ETypeKind::Type_Pointer :
+	case ETypeKind::Type_UserData :
+		memcpy( _dst, _src, _type.m_size );
+		return ALL_OK;
+
+	case ETypeKind::Type_String :
+		{
+			const String& srcString = *static_cast< const String* >( _src );
+			Str::CopyS( *static_cast< String* >( _dst ), srcString.ToPtr(), srcString.Length() );
+		}
+		return ALL_OK;
+
+	case ETypeKind::Type_Class :
+		return AssignObject( GetClassPlan( _type.UpCast< mxClass >() ), _dst, _src );
+
+	case ETypeKind::Type_Array :
+		return AssignArray( _type.UpCast< mxArray >(), _dst, _src );
+
+	case ETypeKind::Type_AssetId :
+		CopyAssetID( static_cast< AssetID* >( _dst ), *static_cast< const AssetID* >( _src ), true );
+		return ALL_OK;
+
+	case ETypeKind::Type_Blob :
+		Unimplemented;
+		break;
+
+		mxNO_SWITCH_DEFAULT;
+	}
+	return ERR_INVALID_PARAMETER;
+}
+
+/*
+-----------------------------------------------------------------------------
+	Diff
+-----------------------------------------------------------------------------
+*/
+static ERet DiffObjects( PatchWriter & _writer, const mxClassPlan& _plan, const void* _old, const void* _new, bool &_changed );
+static ERet DiffArrays( PatchWriter & _writer, const mxArray& _type, const void* _old, const void* _new, bool &_changed );
+
+// writes the patch for a single array element
+static ERet DiffElements( PatchWriter & _writer, const mxType& _type, const void* _old, const void* _new, bool &_changed )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Class :
+		return DiffObjects( _writer, GetClassPlan( _type.UpCast< mxClass >() ), _old, _new, _changed );
+
+	case ETypeKind::Type_Array :
+		return DiffArrays( _writer, _type.UpCast< mxArray >(), _old, _new, _changed );
+
+	case ETypeKind::Type_Pointer :
+	case ETypeKind::Type_AssetId :
+		_changed = false;	// not patched
+		return ALL_OK;
+
+	default:
+		_changed = !ValuesAreEqual( _type, _old, _new );
+		return _changed ? WriteValue( _writer, _type, _new ) : ALL_OK;
+	}
+}
+
+static ERet DiffArrays( PatchWriter & _writer, const mxArray& _type, const void* _old, const void* _new, bool &_changed )
+{
+	const UINT32 oldCount = _type.Generic_Get_Count( _old );
+	const UINT32 newCount = _type.Generic_Get_Count( _new );
+	const BYTE* oldData = static_cast< const BYTE* >( _type.Generic_Get_Data( _old ) );
+	const BYTE* newData = static_cast< const BYTE* >( _type.Generic_Get_Data( _new ) );
+
+	const mxType& itemType = _type.m_itemType;
+	const UINT32 itemStride = _type.m_itemSize;
+	const bool isDense = HasDenseItems( _type );
+
+	const UINT32 start = _writer.Tell();
+
+	if( oldCount == newCount )
+	{
+		mxDO(_writer.WriteU32( ArrayPatch_Elements ));
+		const UINT32 numChangedPosition = _writer.Tell();
+		mxDO(_writer.WriteU32( 0 ));
+
+		UINT32 numChanged = 0;
+		UINT32 itemIndex = 0;
+		while( itemIndex < oldCount )
+		{
+			if( isDense )
+			{
+				// quickly skip equal elements
+				const UINT32 totalSize = oldCount * itemStride;
+				const UINT32 offset = itemIndex * itemStride;
+				const UINT32 firstDifference = offset + FindFirstDifference( oldData + offset, newData + offset, totalSize - offset );
+				if( firstDifference == totalSize ) {
+					break;
+				}
+				itemIndex = firstDifference / itemStride;
+			}
+
+			const UINT32 itemOffset = itemIndex * itemStride;
+			const UINT32 itemStart = _writer.Tell();
+			mxDO(_writer.WriteU32( itemIndex ));
+
+			bool itemChanged = false;
+			mxDO(DiffElements( _writer, itemType, oldData + itemOffset, newData + itemOffset, itemChanged ));
+			if( itemChanged ) {
+				numChanged++;
+			} else {
+				_writer.Truncate( itemStart );
+			}
+			itemIndex++;
+		}
+
+		_changed = (numChanged > 0);
+		if( _changed ) {
+			_writer.OverwriteU32( numChangedPosition, numChanged );
+		} else {
+			_writer.Truncate( start );
+		}
+		return ALL_OK;
+	}
+
+	// find the range of replaced elements
+	const UINT32 minCount = smallest( oldCount, newCount );
+
+	UINT32 prefix = 0;
+	if( isDense ) {
+		prefix = FindFirstDifference( oldData, newData, minCount * itemStride ) / itemStride;
+	} else {
+		while( prefix < minCount && ValuesAreEqual( itemType, oldData + prefix * itemStride, newData + prefix * itemStride ) ) {
+			prefix++;
+		}
+	}
+
+	const UINT32 maxSuffix = minCount - prefix;
+	UINT32 suffix = 0;
+	if( isDense ) {
+		const UINT32 tailSize = maxSuffix * itemStride;
+		const UINT32 lastDifference = FindLastDifference( oldData + oldCount * itemStride - tailSize, newData + newCount * itemStride - tailSize, tailSize );
+		suffix = maxSuffix - (lastDifference + itemStride - 1) / itemStride;
+	} else {
+		while( suffix < maxSuffix && ValuesAreEqual( itemType, oldData + (oldCount - suffix - 1) * itemStride, newData + (newCount - suffix - 1) * itemStride ) ) {
+			suffix++;
+		}
+	}
+
+	const UINT32 numRemoved = oldCount - prefix - suffix;
+	const UINT32 numInserted = newCount - prefix - suffix;
+
+	mxDO(_writer.WriteU32( ArrayPatch_Splice ));
+	mxDO(_writer.WriteU32( prefix ));
+	mxDO(_writer.WriteU32( numRemoved ));
+	mxDO(_writer.WriteU32( numInserted ));
+
+	if( isDense ) {
+		mxDO(_writer.Write( newData + prefix * itemStride, numInserted * itemStride ));
+	} else {
+		for( UINT32 i = 0; i < numInserted; i++ ) {
+			mxDO(WriteValue( _writer, itemType, newData + (prefix + i) * itemStride ));
+		}
+	}
+
+	_changed = true;
+	return ALL_OK;
+}
+
+static ERet DiffObjects( PatchWriter & _writer, const mxClassPlan& _plan, const void* _old, const void* _new, bool &_changed )
+{
+	_changed = false;
+
+	for( UINT32 opIndex = 0; opIndex < _plan.ops.Num(); opIndex++ )
+	{
+		const mxPlanOp& op = _plan.ops[ opIndex ];
+		const void* oldField = mxAddByteOffset( c_cast(void*)_old, op.offset );
+		const void* newField = mxAddByteOffset( c_cast(void*)_new, op.offset );
+
+		switch( op.op )
+		{
+		case PlanOp_Bytes :
+			{
+				const BYTE* oldBytes = static_cast< const BYTE* >( oldField );
+				const BYTE* newBytes = static_cast< const BYTE* >( newField );
+				const UINT32 first = FindFirstDifference( oldBytes, newBytes, op.size );
+				if( first < op.size )
+				{
+					const UINT32 last = FindLastDifference( oldBytes, newBytes, op.size );
+					mxDO(_writer.WriteU32( opIndex ));
+					mxDO(_writer.WriteU32( first ));
+					mxDO(_writer.WriteU32( last - first ));
+					mxDO(_writer.Write( newBytes + first, last - first ));
+					_changed = true;
+				}
+			}
+			break;
+
+		case PlanOp_String :
+			{
+				const String& newString = *static_cast< const String* >( newField );
+				if( !StringsAreEqual( *static_cast< const String* >( oldField ), newString ) )
+				{
+					mxDO(_writer.WriteU32( opIndex ));
+					mxDO(WriteString( _writer, newString ));
+					_changed = true;
+				}
+			}
+			break;
+
+		case PlanOp_ClassId :
+			{
+				const TypeID newTypeId = GetClassIdValue( newField );
+				if( GetClassIdValue( oldField ) != newTypeId )
+				{
+					mxDO(_writer.WriteU32( opIndex ));
+					mxDO(_writer.WriteU32( newTypeId ));
+					_changed = true;
+				}
+			}
+			break;
+
+		case PlanOp_UserPointer :
+			{
+				const mxUserPointerType& userPointerType = op.type->UpCast< mxUserPointerType >();
+				const UINT32 newId = userPointerType.GetPersistentBinaryId( newField );
+				if( userPointerType.GetPersistentBinaryId( oldField ) != newId )
+				{
+					mxDO(_writer.WriteU32( opIndex ));
+					mxDO(_writer.WriteU32( newId ));
+					_changed = true;
+				}
+			}
+			break;
+
+		case PlanOp_Array :
+			{
+				const UINT32 opStart = _writer.Tell();
+				mxDO(_writer.WriteU32( opIndex ));
+				bool arrayChanged = false;
+				mxDO(DiffArrays( _writer, op.type->UpCast< mxArray >(), oldField, newField, arrayChanged ));
+				if( arrayChanged ) {
+					_changed = true;
+				} else {
+					_writer.Truncate( opStart );
+				}
+			}
+			break;
+
+		case PlanOp_Pointer :
+		case PlanOp_AssetId :
+			// heap addresses and asset references are not patched
+			break;
+
+			mxNO_SWITCH_DEFAULT;
+		}
+	}
+
+	return _writer.WriteU32( END_OF_OBJECT );
+}
+
+/*
+-----------------------------------------------------------------------------
+	ApplyPatch
+-----------------------------------------------------------------------------
+*/
+static ERet PatchObject( PatchReader & _reader, const mxClassPlan& _plan, void * _o );
+static ERet PatchArray( PatchReader & _reader, const mxArray& _type, void * _array );
+
+static ERet PatchElement( PatchReader & _reader, const mxType& _type, void * _value )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Class :
+		return PatchObject( _reader, GetClassPlan( _type.UpCast< mxClass >() ), _value );
+
+	case ETypeKind::Type_Array :
+		return PatchArray( _reader, _type.UpCast< mxArray >(), _value );
+
+	default:
+		return ReadValue( _reader, _type, _value );
+	}
+}
+
+static ERet PatchArray( PatchReader & _reader, const mxArray& _type, void * _array )
+{
+	const mxType& itemType = _type.m_itemType;
+	const UINT32 itemStride = _type.m_itemSize;
+	const UINT32 count = _type.Generic_Get_Count( _array );
+
+	UINT32 patchType;
+	mxDO(_reader.ReadU32( patchType ));
+
+	if( patchType == ArrayPatch_Elements )
+	{
+		UINT32 numChanged;
+		mxDO(_reader.ReadU32( numChanged ));
+
+		void* data = _type.Generic_Get_Data( _array );
+		for( UINT32 i = 0; i < numChanged; i++ )
+		{
+			UINT32 itemIndex;
+			mxDO(_reader.ReadU32( itemIndex ));
+			chkRET_X_IF_NOT(itemIndex < count, ERR_FAILED_TO_PARSE_DATA);
+			mxDO(PatchElement( _reader, itemType, mxAddByteOffset( data, itemIndex * itemStride ) ));
+		}
+		return ALL_OK;
+	}
+
+	chkRET_X_IF_NOT(patchType == ArrayPatch_Splice, ERR_FAILED_TO_PARSE_DATA);
+
+	UINT32 start, numRemoved, numInserted;
+	mxDO(_reader.ReadU32( start ));
+	mxDO(_reader.ReadU32( numRemoved ));
+	mxDO(_reader.ReadU32( numInserted ));
+	chkRET_X_IF_NOT(start <= count && numRemoved <= count - start, ERR_FAILED_TO_PARSE_DATA);
+
+	const bool isDense = HasDenseItems( _type );
+	if( isDense ) {
+		chkRET_X_IF_NOT(numInserted <= _reader.Remaining() / itemStride, ERR_FAILED_TO_PARSE_DATA);
+	}
+	chkRET_X_IF_NOT(numInserted <= ~0U - (count - numRemoved), ERR_FAILED_TO_PARSE_DATA);
+
+	const UINT32 newCount = count - numRemoved + numInserted;
+	const UINT32 tailCount = count - start - numRemoved;
+	const UINT32 oldTail = start + numRemoved;	// index of the first element after the removed range
+	const UINT32 newTail = start + numInserted;
+
+	if( newCount > count )
+	{
+		// grow the array, then move the tail backwards
+		mxDO(ResizeArray( _type, _array, newCount ));
+		void* data = _type.Generic_Get_Data( _array );
+		if( isDense ) {
+			memmove( mxAddByteOffset( data, newTail * itemStride ), mxAddByteOffset( data, oldTail * itemStride ), tailCount * itemStride );
+		} else {
+			for( UINT32 i = tailCount; i > 0; i-- ) {
+				mxDO(AssignValue( itemType, mxAddByteOffset( data, (newTail + i - 1) * itemStride ), mxAddByteOffset( data, (oldTail + i - 1) * itemStride ) ));
+			}
+		}
+	}
+	else if( newCount < count )
+	{
+		// move the tail forward, then shrink the array
+		void* data = _type.Generic_Get_Data( _array );
+		if( isDense ) {
+			memmove( mxAddByteOffset( data, newTail * itemStride ), mxAddByteOffset( data, oldTail * itemStride ), tailCount * itemStride );
+		} else {
+			for( UINT32 i = 0; i < tailCount; i++ ) {
+				mxDO(AssignValue( itemType, mxAddByteOffset( data, (newTail + i) * itemStride ), mxAddByteOffset( data, (oldTail + i) * itemStride ) ));
+			}
+		}
+		mxDO(ResizeArray( _type, _array, newCount ));
+	}
+
+	if( !numInserted ) {
+		return ALL_OK;
+	}
+	void* data = _type.Generic_Get_Data( _array );
+	return ReadElements( _reader, _type, mxAddByteOffset( data, start * itemStride ), numInserted );
+}
+
+static ERet PatchObject( PatchReader & _reader, const mxClassPlan& _plan, void * _o )
+{
+	for(;;)
+	{
+		UINT32 opIndex;
+		mxDO(_reader.ReadU32( opIndex ));
+		if( opIndex == END_OF_OBJECT ) {
+			break;
+		}
+		chkRET_X_IF_NOT(opIndex < _plan.ops.Num(), ERR_FAILED_TO_PARSE_DATA);
+
+		const mxPlanOp& op = _plan.ops[ opIndex ];
+		void* field = mxAddByteOffset( _o, op.offset );
+
+		switch( op.op )
+		{
+		case PlanOp_Bytes :
+			{
+				UINT32 start, length;
+				mxDO(_reader.ReadU32( start ));
+				mxDO(_reader.ReadU32( length ));
+				chkRET_X_IF_NOT(length <= op.size && start <= op.size - length, ERR_FAILED_TO_PARSE_DATA);
+				mxDO(_reader.Read( mxAddByteOffset( field, start ), length ));
+			}
+			break;
+
+		case PlanOp_String :
+			mxDO(ReadString( _reader, *static_cast< String* >( field ) ));
+			break;
+
+		case PlanOp_ClassId :
+			mxDO(ReadClassId( _reader, field ));
+			break;
+
+		case PlanOp_UserPointer :
+			mxDO(ReadUserPointer( _reader, op.type->UpCast< mxUserPointerType >(), field ));
+			break;
+
+		case PlanOp_Array :
+			mxDO(PatchArray( _reader, op.type->UpCast< mxArray >(), field ));
+			break;
+
+		case PlanOp_Pointer :
+		case PlanOp_AssetId :
+			// never written by Diff()
+			return ERR_FAILED_TO_PARSE_DATA;
+
+			mxNO_SWITCH_DEFAULT;
+		}
+	}
+	return ALL_OK;
+}
+
+ERet Diff( const void* _old, const void* _new, const mxClass& _type, TArray< BYTE > & _patch )
+{
+	mxASSERT_PTR(_old);
+	mxASSERT_PTR(_new);
+
+	_patch.Empty();
+
+	PatchWriter	writer( _patch );
+	mxDO(writer.WriteU32( _type.GetTypeID() ));
+
+	bool changed = false;
+	mxDO(DiffObjects( writer, GetClassPlan( _type ), _old, _new, changed ));
+	if( !changed ) {
+		_patch.Empty();
+	}
+	return ALL_OK;
+}
+
+ERet ApplyPatch( void * _o, const mxClass& _type, const void* _patch, UINT32 _size )
+{
+	mxASSERT_PTR(_o);
+	if( !_size ) {
+		return ALL_OK;	// nothing has changed
+	}
+	mxASSERT_PTR(_patch);
+
+	PatchReader	reader( _patch, _size );
+
+	TypeID typeId;
+	mxDO(reader.ReadU32( typeId ));
+	chkRET_X_IF_NOT(typeId == _type.GetTypeID(), ERR_OBJECT_OF_WRONG_TYPE);
+
+	mxDO(PatchObject( reader, GetClassPlan( _type ), _o ));
+	chkRET_X_IF_NOT(reader.Remaining() == 0, ERR_FAILED_TO_PARSE_DATA);
+	return ALL_OK;
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,374 @@
+/*
+=============================================================================
+	File:	ObjectHash.cpp
+	Desc:	Reflection-based content hashing of objects.
+	Note:	the hash function is modelled after XXH3 (by Yann Collet):
+			64-byte stripes are mixed into eight 64-bit accumulators.
+			It's NOT compatible with the real XXH3!
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/UserPointerType.h>
+#include <Base/Object/ClassPlan.h>
+#include <Base/Text/String.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define MX_USE_SSE2_HASH	(1)
+	#include <emmintrin.h>
+#else
+	#define MX_USE_SSE2_HASH	(0)
+#endif
+
+namespace Reflection
+{
+
+enum
+{
+	STRIPE_SIZE = 64,			// bytes consumed by one round
+	NUM_ACCUMULATORS = 8,
+	STRIPES_PER_BLOCK = 16,		// accumulators are scrambled after each block
+};
+
+static const UINT64 PRIME32_1 = 0x9E3779B1ULL;
+static const UINT64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const UINT64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const UINT64 PRIME64_3 = 0x165667B19E3779F9ULL;
+static const UINT64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const UINT64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+// 'secret' keys which are mixed with input data
+mxPREALIGN(16) static const UINT64 STRIPE_KEY[ NUM_ACCUMULATORS ] mxPOSTALIGN(16) =
+{
+	0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL, 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL,
+	0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL, 0x8E2443F7744608B8ULL, 0x4C263A81E69035E0ULL,
+};
+static const UINT64 SCRAMBLE_KEY[ NUM_ACCUMULATORS ] =
+{
+	0xCB00C391BB52283CULL, 0xA32E531B8B65D088ULL, 0x4EF90DA297486471ULL, 0xD8ACDEA946EF1938ULL,
+	0x3F349CE33F76FAA8ULL, 0x1D4F0BC7C7BBDCF9ULL, 0x3159B4CD4BE0518AULL, 0x647378D9C97E9FC8ULL,
+};
+
+static inline UINT64 ReadU64( const BYTE* _p )
+{
+	UINT64 value;
+	memcpy( &value, _p, sizeof(value) );
+	return value;
+}
+
+// 64x64 -> 128 bit multiplication, the high and low halves are XOR'ed
+static inline UINT64 Mul128Fold64( UINT64 _a, UINT64 _b )
+{
+	const UINT64 lo_lo = (_a & 0xFFFFFFFF) * (_b & 0xFFFFFFFF);
+	const UINT64 hi_lo = (_a >> 32) * (_b & 0xFFFFFFFF);
+	const UINT64 lo_hi = (_a & 0xFFFFFFFF) * (_b >> 32);
+	const UINT64 hi_hi = (_a >> 32) * (_b >> 32);
+	const UINT64 cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+	const UINT64 upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	const UINT64 lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+	return lower ^ upper;
+}
+
+static inline UINT64 Avalanche( UINT64 _h )
+{
+	_h ^= _h >> 37;
+	_h *= 0x165667919E3779F9ULL;
+	_h ^= _h >> 32;
+	return _h;
+}
+
+// mixes one 64-byte stripe into the accumulators
+static mxFORCEINLINE void AccumulateStripe( UINT64 * __restrict _acc, const BYTE* __restrict _data )
+{
+#if MX_USE_SSE2_HASH
+	__m128i* acc = (__m128i*) _acc;
+	const __m128i* key = (const __m128i*) STRIPE_KEY;
+	for( int i = 0; i < NUM_ACCUMULATORS / 2; i++ )
+	{
+		const __m128i data = _mm_loadu_si128( (const __m128i*) (_data + i * 16) );
+		const __m128i dataKey = _mm_xor_si128( data, _mm_load_si128( key + i ) );
+		// multiply low and high 32-bit halves of each 64-bit lane
+		const __m128i dataKeyHi = _mm_shuffle_epi32( dataKey, _MM_SHUFFLE(0, 3, 0, 1) );
+		const __m128i product = _mm_mul_epu32( dataKey, dataKeyHi );
+		// swap 64-bit lanes of the input so that it's added to the neighbouring accumulator
+		const __m128i dataSwapped = _mm_shuffle_epi32( data, _MM_SHUFFLE(1, 0, 3, 2) );
+		const __m128i sum = _mm_add_epi64( _mm_load_si128( acc + i ), dataSwapped );
+		_mm_store_si128( acc + i, _mm_add_epi64( product, sum ) );
+	}
+#else
+	for( int i = 0; i < NUM_ACCUMULATORS; i++ )
+	{
+		const UINT64 data = ReadU64( _data + i * 8 );
+		const UINT64 dataKey = data ^ STRIPE_KEY[i];
+		_acc[ i ^ 1 ] += data;
+		_acc[ i ] += (dataKey & 0xFFFFFFFF) * (dataKey >> 32);
+	}
+#endif
+}
+
+static mxFORCEINLINE void ScrambleAccumulators( UINT64 * _acc )
+{
+	for( int i = 0; i < NUM_ACCUMULATORS; i++ )
+	{
+		UINT64 acc = _acc[i];
+		acc ^= acc >> 47;
+		acc ^= SCRAMBLE_KEY[i];
+		acc *= PRIME32_1;
+		_acc[i] = acc;
+	}
+}
+
+/*
+-----------------------------------------------------------------------------
+	ContentHasher
+	streaming hasher, small inputs are buffered until a whole stripe is collected
+-----------------------------------------------------------------------------
+*/
+class ContentHasher
+{
+	mxPREALIGN(16) UINT64	m_acc[ NUM_ACCUMULATORS ];
+	BYTE	m_buffer[ STRIPE_SIZE ];
+	UINT32	m_bufferedSize;
+	UINT32	m_stripesInBlock;
+	UINT64	m_totalLength;
+
+public:
+	ContentHasher( UINT64 _seed )
+	{
+		m_acc[0] = PRIME32_1;
+		m_acc[1] = PRIME64_1;
+		m_acc[2] = PRIME64_2;
+		m_acc[3] = PRIME64_3;
+		m_acc[4] = PRIME64_4;
+		m_acc[5] = 0x85EBCA77ULL;
+		m_acc[6] = PRIME64_5;
+		m_acc[7] = 0x165667B1ULL;
+		for( int i = 0; i < NUM_ACCUMULATORS; i++ ) {
+			m_acc[i] += (i & 1) ? (0 - _seed) : _seed;
+		}
+		m_bufferedSize = 0;
+		m_stripesInBlock = 0;
+		m_totalLength = 0;
+	}
+
+	void Update( const void* _data, size_t _size )
+	{
+		const BYTE* bytes = static_cast< const BYTE* >( _data );
+		m_totalLength += _size;
+
+		// fill the partially filled stripe
+		if( m_bufferedSize )
+		{
+			const UINT32 bytesToCopy = (UINT32) smallest( _size, (size_t)(STRIPE_SIZE - m_bufferedSize) );
+			memcpy( m_buffer + m_bufferedSize, bytes, bytesToCopy );
+			m_bufferedSize += bytesToCopy;
+			bytes += bytesToCopy;
+			_size -= bytesToCopy;
+			if( m_bufferedSize < STRIPE_SIZE ) {
+				return;
+			}
+			this->ConsumeStripe( m_buffer );
+			m_bufferedSize = 0;
+		}
+
+		// process big inputs without copying
+		while( _size >= STRIPE_SIZE )
+		{
+			this->ConsumeStripe( bytes );
+			bytes += STRIPE_SIZE;
+			_size -= STRIPE_SIZE;
+		}
+
+		if( _size ) {
+			memcpy( m_buffer, bytes, _size );
+			m_bufferedSize = (UINT32) _size;
+		}
+	}
+
+	template< typename TYPE >
+	void UpdateValue( const TYPE& _value )
+	{
+		this->Update( &_value, sizeof(_value) );
+	}
+
+	void Digest( UINT64 _hash[2] )
+	{
+		mxPREALIGN(16) UINT64 acc[ NUM_ACCUMULATORS ];
+		memcpy( acc, m_acc, sizeof(acc) );
+
+		// the last, partial stripe is padded with zeros
+		if( m_bufferedSize )
+		{
+			BYTE lastStripe[ STRIPE_SIZE ];
+			memset( lastStripe, 0, sizeof(lastStripe) );
+			memcpy( lastStripe, m_buffer, m_bufferedSize );
+			AccumulateStripe( acc, lastStripe );
+		}
+
+		UINT64 low = m_totalLength * PRIME64_1;
+		UINT64 high = ~(m_totalLength * PRIME64_2);
+		for( int i = 0; i < NUM_ACCUMULATORS; i += 2 )
+		{
+			low += Mul128Fold64( acc[i] ^ SCRAMBLE_KEY[i], acc[i+1] ^ SCRAMBLE_KEY[i+1] );
+			high += Mul128Fold64( acc[i] ^ STRIPE_KEY[i+1], acc[i+1] ^ STRIPE_KEY[i] );
+		}
+		_hash[0] = Avalanche( low );
+		_hash[1] = Avalanche( high );
+	}
+
+private:
+	mxFORCEINLINE void ConsumeStripe( const BYTE* _stripe )
+	{
+		AccumulateStripe( m_acc, _stripe );
+		if( ++m_stripesInBlock == STRIPES_PER_BLOCK ) {
+			ScrambleAccumulators( m_acc );
+			m_stripesInBlock = 0;
+		}
+	}
+};
+
+/*
+-----------------------------------------------------------------------------
+	the data is fed in the order of fields,
+	so the hash doesn't depend on the layout (alignment and padding) of objects.
+-----------------------------------------------------------------------------
+*/
+static void HashValue( ContentHasher & _hasher, const mxType& _type, const void* _value );
+
+static void HashString( ContentHasher & _hasher, const String& _string )
+{
+	const UINT32 length = _string.Length();
+	_hasher.UpdateValue( length );
+	if( length ) {
+		_hasher.Update( _string.ToPtr(), length );
+	}
+}
+
+static void HashArray( ContentHasher & _hasher, const mxArray& _type, const void* _array )
+{
+	const UINT32 count = _type.Generic_Get_Count( _array );
+	_hasher.UpdateValue( count );
+	if( !count ) {
+		return;
+	}
+
+	const void* data = _type.Generic_Get_Data( _array );
+	const mxType& itemType = _type.m_itemType;
+	const UINT32 itemStride = _type.m_itemSize;
+
+	// arrays of POD elements without padding are hashed in bulk
+	if( itemStride == itemType.m_size && IsDenseType( itemType ) ) {
+		_hasher.Update( data, count * itemStride );
+		return;
+	}
+
+	for( UINT32 i = 0; i < count; i++ ) {
+		HashValue( _hasher, itemType, mxAddByteOffset( c_cast(void*)data, i * itemStride ) );
+	}
+}
+
+static void HashObject( ContentHasher & _hasher, const mxClassPlan& _plan, const void* _o )
+{
+	const mxPlanOp* ops = _plan.ops.ToPtr();
+	const UINT32 numOps = _plan.ops.Num();
+
+	for( UINT32 i = 0; i < numOps; i++ )
+	{
+		const mxPlanOp& op = ops[i];
+		const void* field = mxAddByteOffset( c_cast(void*)_o, op.offset );
+		if( op.op == PlanOp_Bytes ) {
+			_hasher.Update( field, op.size );
+		} else {
+			HashValue( _hasher, *op.type, field );
+		}
+	}
+}
+
+static void HashValue( ContentHasher & _hasher, const mxType& _type, const void* _value )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Integer :
+	case ETypeKind::Type_Float :
+	case ETypeKind::Type_Bool :
+	case ETypeKind::Type_Enum :
+	case ETypeKind::Type_Flags :
+		_hasher.Update( _value, _type.m_size );
+		break;
+
+	case ETypeKind::Type_String :
+		HashString( _hasher, *static_cast< const String* >( _value ) );
+		break;
+
+	case ETypeKind::Type_Class :
+		HashObject( _hasher, GetClassPlan( _type.UpCast< mxClass >() ), _value );
+		break;
+
+	case ETypeKind::Type_Pointer :
+		{
+			// heap addresses are not stable, only null-ness is hashed
+			const BYTE isNull = (static_cast< const VoidPointer* >( _value )->o == nil);
+			_hasher.UpdateValue( isNull );
+		}
+		break;
+
+	case ETypeKind::Type_AssetId :
+		{
+			const char* assetName = GetAssetIDName( *static_cast< const AssetID* >( _value ) );
+			const UINT32 length = strlen( assetName );
+			_hasher.UpdateValue( length );
+			_hasher.Update( assetName, length );
+		}
+		break;
+
+	case ETypeKind::Type_ClassId :
+		{
+			const mxClass* classType = static_cast< const SClassId* >( _value )->type;
+			const TypeID typeId = classType ? classType->GetTypeID() : mxNULL_TYPE_ID;
+			_hasher.UpdateValue( typeId );
+		}
+		break;
+
+	case ETypeKind::Type_UserData :
+		{
+			const mxUserPointerType& userPointerType = _type.UpCast< mxUserPointerType >();
+			const UINT32 persistentId = userPointerType.GetPersistentBinaryId( _value );
+			_hasher.UpdateValue( persistentId );
+		}
+		break;
+
+	case ETypeKind::Type_Array :
+		HashArray( _hasher, _type.UpCast< mxArray >(), _value );
+		break;
+
+	case ETypeKind::Type_Blob :
+		Unimplemented;
+		break;
+
+		mxNO_SWITCH_DEFAULT;
+	}
+}
+
+UINT64 HashObject( const void* _o, const mxType& _type, UINT64 _seed )
+{
+	UINT64 hash[2];
+	HashObject128( _o, _type, hash, _seed );
+	return hash[0];
+}
+
+void HashObject128( const void* _o, const mxType& _type, UINT64 _hash[2], UINT64 _seed )
+{
+	mxASSERT_PTR(_o);
+	ContentHasher	hasher( _seed );
+	HashValue( hasher, _type, _o );
+	hasher.Digest( _hash );
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,319 @@
+/*
+=============================================================================
+	File:	ParallelWalker.cpp
+	Desc:	Version of Walker2 which splits large arrays across threads.
+	Note:	each worker owns a range of array elements, packed into a single atomic
+			(begin in the high 32 bits, end in the low 32 bits).
+			The owner takes grains from the front of its range,
+			idle workers steal the back half of other workers' ranges.
+			Workers other than the calling thread run on the shared pool
+			of persistent threads (see WorkerPool.h).
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <atomic>
+#include <thread>
+
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/PointerType.h>
+#include <Base/Object/UserPointerType.h>
+#include <Base/Object/ClassPlan.h>
+#include <Base/Object/ParallelWalker.h>
+#include <Base/Object/WorkerPool.h>
+
+namespace Reflection
+{
+
+// padded to avoid false sharing
+struct SWorkRange
+{
+	std::atomic< UINT64 >	range;
+	char	pad[ 64 - sizeof(UINT64) ];
+};
+
+struct SParallelArrayTask
+{
+	void *				arrayBase;
+	const mxType *		itemType;
+	UINT32				itemStride;
+	UINT32				grainSize;
+	UINT32				numWorkers;
+	SWorkRange *		ranges;
+	const AVisitor2::Context *	itemContext;
+	AParallelVisitor **	visitors;	// per worker
+};
+
+static inline UINT64 PackRange( UINT32 _begin, UINT32 _end )
+{
+	return ((UINT64)_begin << 32) | _end;
+}
+static inline UINT32 RangeBegin( UINT64 _range ) { return (UINT32)(_range >> 32); }
+static inline UINT32 RangeEnd( UINT64 _range ) { return (UINT32)_range; }
+
+// takes a grain from the front of the worker's own range
+static bool PopGrain( SWorkRange & _work, UINT32 _grainSize, UINT32 &_begin, UINT32 &_end )
+{
+	UINT64 range = _work.range.load( std::memory_order_acquire );
+	for(;;)
+	{
+		const UINT32 begin = RangeBegin( range );
+		const UINT32 end = RangeEnd( range );
+		if( begin >= end ) {
+			return false;
+		}
+		const UINT32 newBegin = smallest( begin + _grainSize, end );
+		if( _work.range.compare_exchange_weak( range, PackRange( newBegin, end ), std::memory_order_acq_rel ) )
+		{
+			_begin = begin;
+			_end = newBegin;
+			return true;
+		}
+	}
+}
+
+// takes the back half of the victim's range
+static bool StealHalf( SWorkRange & _victim, UINT32 _grainSize, UINT32 &_begin, UINT32 &_end )
+{
+	UINT64 range = _victim.range.load( std::memory_order_acquire );
+	for(;;)
+	{
+		const UINT32 begin = RangeBegin( range );
+		const UINT32 end = RangeEnd( range );
+		if( begin >= end || end - begin <= _grainSize ) {
+			return false;	// the owner will finish it soon
+		}
+		const UINT32 middle = begin + (end - begin) / 2;
+		if( _victim.range.compare_exchange_weak( range, PackRange( begin, middle ), std::memory_order_acq_rel ) )
+		{
+			_begin = middle;
+			_end = end;
+			return true;
+		}
+	}
+}
+
+static void RunWorker( const SParallelArrayTask& _task, UINT32 _workerIndex, AVisitor2* _visitor )
+{
+	SWorkRange & ownWork = _task.ranges[ _workerIndex ];
+	for(;;)
+	{
+		UINT32 begin, end;
+		while( PopGrain( ownWork, _task.grainSize, begin, end ) )
+		{
+			for( UINT32 iObject = begin; iObject < end; iObject++ )
+			{
+				void* itemPtr = mxAddByteOffset( _task.arrayBase, iObject * _task.itemStride );
+				Walker2::Visit( itemPtr, *_task.itemType, _visitor, *_task.itemContext );
+			}
+		}
+
+		// only the owner (i.e. this thread) can refill an empty range
+		bool stolen = false;
+		for( UINT32 i = 1; i < _task.numWorkers && !stolen; i++ )
+		{
+			const UINT32 victimIndex = (_workerIndex + i) % _task.numWorkers;
+			if( StealHalf( _task.ranges[ victimIndex ], _task.grainSize, begin, end ) )
+			{
+				ownWork.range.store( PackRange( begin, end ), std::memory_order_release );
+				stolen = true;
+			}
+		}
+		if( !stolen ) {
+			break;
+		}
+	}
+}
+
+// called by RunOnWorkers()
+static void RunWorkerJob( void* _context, UINT32 _workerIndex )
+{
+	const SParallelArrayTask& task = *static_cast< const SParallelArrayTask* >( _context );
+	RunWorker( task, _workerIndex, task.visitors[ _workerIndex ] );
+}
+
+UINT32 ParallelWalker::CalcGrainSize( UINT32 _itemSize, UINT32 _count, const ParallelWalkSettings& _settings )
+{
+	const UINT64 arraySize = (UINT64)_itemSize * _count;
+	if( arraySize < _settings.minParallelBytes ) {
+		return 0;
+	}
+	const UINT32 grainSize = largest( _settings.grainBytes / largest( _itemSize, 1U ), 1U );
+	if( _count < grainSize * 2 ) {
+		return 0;
+	}
+	return grainSize;
+}
+
+void ParallelWalker::Visit( void * _memory, const mxType& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, void *_userData )
+{
+	mxASSERT_PTR(_memory);
+
+	AVisitor2::Context	context;
+	context.userData = _userData;
+
+	Visit( _memory, _type, _visitor, _settings, context );
+}
+
+void ParallelWalker::Visit( void * _memory, const mxType& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, const AVisitor2::Context& _context )
+{
+	switch( _type.m_kind )
+	{
+	case ETypeKind::Type_Class :
+		VisitAggregate( _memory, _type.UpCast< mxClass >(), _visitor, _settings, _context );
+		break;
+
+	case ETypeKind::Type_Array :
+		VisitArray( _memory, _type.UpCast< mxArray >(), _visitor, _settings, _context );
+		break;
+
+	default:
+		// leaf types
+		Walker2::Visit( _memory, _type, _visitor, _context );
+	}
+}
+
+void ParallelWalker::VisitArray( void * _array, const mxArray& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, const AVisitor2::Context& _context )
+{
+	mxASSERT_PTR(_array);
+	if( !_visitor->Visit_Array( _array, _type, _context ) ) {
+		return;
+	}
+
+	const UINT32 numObjects = _type.Generic_Get_Count( _array );
+	void* arrayBase = _type.Generic_Get_Data( _array );
+
+	const mxType& itemType = _type.m_itemType;
+	const UINT32 itemStride = _type.m_itemSize;
+
+	if( CanSkipType( itemType, _visitor->m_interests ) ) {
+		return;
+	}
+
+	if( numObjects && IsPlainType( itemType )
+		&& _visitor->Visit_PODArray( arrayBase, itemType, numObjects, itemStride, _context ) )
+	{
+		return;
+	}
+
+	AVisitor2::Context	itemContext( _context.depth + 1 );
+	itemContext.parent = &_context;
+	itemContext.userData = _context.userData;
+
+	UINT32 numWorkers = _settings.numThreads ? _settings.numThreads : std::thread::hardware_concurrency();
+	const UINT32 grainSize = CalcGrainSize( itemStride, numObjects, _settings );
+	if( grainSize ) {
+		numWorkers = smallest( numWorkers, (numObjects + grainSize - 1) / grainSize );
+		numWorkers = smallest( numWorkers, (UINT32)MAX_WORKERS );
+	}
+
+	if( !grainSize || numWorkers < 2 )
+	{
+		// nested arrays can still be large
+		for( UINT32 iObject = 0; iObject < numObjects; iObject++ )
+		{
+			void* itemPtr = mxAddByteOffset( arrayBase, iObject * itemStride );
+			Visit( itemPtr, itemType, _visitor, _settings, itemContext );
+		}
+		return;
+	}
+
+	// split the array evenly, the workers will balance the load by stealing
+	SWorkRange	ranges[ MAX_WORKERS ];
+	for( UINT32 i = 0; i < numWorkers; i++ )
+	{
+		const UINT32 begin = (UINT32)( (UINT64)numObjects * i / numWorkers );
+		const UINT32 end = (UINT32)( (UINT64)numObjects * (i + 1) / numWorkers );
+		ranges[i].range.store( PackRange( begin, end ), std::memory_order_relaxed );
+	}
+
+	// the calling thread is the first worker and uses the original visitor
+	AParallelVisitor *	visitors[ MAX_WORKERS ];
+	visitors[0] = _visitor;
+	for( UINT32 i = 1; i < numWorkers; i++ )
+	{
+		visitors[i] = _visitor->Fork();
+		mxASSERT_PTR(visitors[i]);
+	}
+
+	SParallelArrayTask	task;
+	task.arrayBase = arrayBase;
+	task.itemType = &itemType;
+	task.itemStride = itemStride;
+	task.grainSize = grainSize;
+	task.numWorkers = numWorkers;
+	task.ranges = ranges;
+	task.itemContext = &itemContext;
+	task.visitors = visitors;
+
+	RunOnWorkers( &RunWorkerJob, &task, numWorkers );
+
+	for( UINT32 i = 1; i < numWorkers; i++ )
+	{
+		_visitor->Join( visitors[i] );
+		delete visitors[i];
+	}
+}
+
+void ParallelWalker::VisitAggregate( void * _struct, const mxClass& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, const AVisitor2::Context& _context )
+{
+	mxASSERT_PTR(_struct);
+	if( _visitor->Visit_Class( _struct, _type, _context ) )
+	{
+		// First recursively visit the parent classes.
+		const mxClass* parentType = _type.GetParent();
+		while( parentType != nil )
+		{
+			VisitStructFields( _struct, *parentType, _visitor, _settings, _context );
+			parentType = parentType->GetParent();
+		}
+
+		// Now visit the members of this class.
+		VisitStructFields( _struct, _type, _visitor, _settings, _context );
+	}
+}
+
+void ParallelWalker::VisitStructFields( void * _struct, const mxClass& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, const AVisitor2::Context& _context )
+{
+	const bool trackPath = (_visitor->m_flags & Visitor_TrackPath) != 0;
+
+	const mxClassLayout& layout = _type.GetLayout();
+	for( UINT fieldIndex = 0 ; fieldIndex < layout.numFields; fieldIndex++ )
+	{
+		const mxField& field = layout.fields[ fieldIndex ];
+
+		if( CanSkipType( field.type, _visitor->m_interests ) ) {
+			continue;
+		}
+
+		if( !trackPath )
+		{
+			// the context is only used for passing userData
+			void* memberVarPtr = mxAddByteOffset( _struct, field.offset );
+			if( _visitor->Visit_Field( memberVarPtr, field, _context ) ) {
+				Visit( memberVarPtr, field.type, _visitor, _settings, _context );
+			}
+			continue;
+		}
+
+		AVisitor2::Context	fieldContext( _context.depth + 1 );
+		fieldContext.parent = &_context;
+		fieldContext.member = &field;
+		fieldContext.userData = _context.userData;
+
+		void* memberVarPtr = mxAddByteOffset( _struct, field.offset );
+
+		if( _visitor->Visit_Field( memberVarPtr, field, fieldContext ) )
+		{
+			Visit( memberVarPtr, field.type, _visitor, _settings, fieldContext );
+		}
+	}
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,51 @@
+/*
+=============================================================================
+	File:	ParallelWalker.h
+	Desc:	Version of Walker2 which splits large arrays across threads.
+=============================================================================
+*/
+#pragma once
+
+#include <Base/Object/Reflection.h>
+
+namespace Reflection
+{
+
+struct ParallelWalkSettings
+{
+	UINT32	numThreads;			// including the calling thread, 0 = number of hardware threads
+	UINT32	minParallelBytes;	// smaller arrays (m_itemSize * count) are visited sequentially
+	UINT32	grainBytes;			// the minimum amount of array memory visited as a single task
+public:
+	ParallelWalkSettings()
+	{
+		numThreads = 0;
+		minParallelBytes = 256 * mxKILOBYTE;
+		grainBytes = 16 * mxKILOBYTE;
+	}
+};
+
+// Object/Field iterator
+// the calling thread walks the object graph in the same order as Walker2,
+// large arrays are visited in parallel (using work-stealing)
+// by the calling thread and a pool of persistent worker threads.
+// NOTE: the visitor must derive from AParallelVisitor (see Reflection.h).
+// NOTE: elements of the arrays are visited with Walker2.
+struct ParallelWalker
+{
+	static void Visit( void * _memory, const mxType& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, void *_userData = nil );
+
+	static void Visit( void * _memory, const mxType& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, const AVisitor2::Context& _context );
+	static void VisitArray( void * _array, const mxArray& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, const AVisitor2::Context& _context );
+	static void VisitAggregate( void * _struct, const mxClass& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, const AVisitor2::Context& _context );
+	static void VisitStructFields( void * _struct, const mxClass& _type, AParallelVisitor* _visitor, const ParallelWalkSettings& _settings, const AVisitor2::Context& _context );
+
+	// returns the number of elements per task or 0 if the array should be visited sequentially
+	static UINT32 CalcGrainSize( UINT32 _itemSize, UINT32 _count, const ParallelWalkSettings& _settings );
+};
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
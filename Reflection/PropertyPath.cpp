@@ -0,0 +1,167 @@
+/*
+=============================================================================
+	File:	PropertyPath.cpp
+	Desc:	Compiled paths to reflected properties.
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/PointerType.h>
+#include <Base/Object/FieldIndex.h>
+#include <Base/Object/PropertyPath.h>
+
+namespace Reflection
+{
+
+static inline bool IsIdentifierChar( char c )
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static ERet AddStep( mxPropertyPath &_compiled, EPathStep _op, const mxArray* _array, UINT32 _index, const char* _path )
+{
+	if( _compiled.numSteps >= mxCOUNT_OF(_compiled.steps) ) {
+		ptWARN("property path is too long: '%s'\n", _path);
+		return ERR_BUFFER_TOO_SMALL;
+	}
+	mxPathStep & newStep = _compiled.steps[ _compiled.numSteps++ ];
+	newStep.op = _op;
+	newStep.offset = _compiled.offset;
+	newStep.index = _index;
+	newStep.array = _array;
+	// subsequent offsets are relative to the pointee/array element
+	_compiled.offset = 0;
+	return ALL_OK;
+}
+
+ERet CompilePath( const mxClass& _type, const char* _path, mxPropertyPath &_compiled )
+{
+	mxASSERT_PTR(_path);
+
+	_compiled = mxPropertyPath();
+	_compiled.rootType = &_type;
+
+	const mxType* currentType = &_type;
+	const char* p = _path;
+
+	for(;;)
+	{
+		// implicitly dereference pointers to objects
+		if( currentType->m_kind == ETypeKind::Type_Pointer )
+		{
+			mxDO(AddStep( _compiled, PathStep_Pointer, nil, 0, _path ));
+			currentType = &currentType->UpCast< mxPointerType >().pointee;
+		}
+		if( currentType->m_kind != ETypeKind::Type_Class ) {
+			ptWARN("'%s': cannot access members of '%s'\n", _path, currentType->m_name.buffer);
+			return ERR_INVALID_PARAMETER;
+		}
+
+		// parse the field name
+		const char* name = p;
+		while( IsIdentifierChar( *p ) ) {
+			p++;
+		}
+		const UINT32 nameLength = p - name;
+		chkRET_X_IF_NOT(nameLength > 0, ERR_FAILED_TO_PARSE_DATA);
+
+		const mxFieldInfo* fieldInfo = FindField( currentType->UpCast< mxClass >(), name, nameLength );
+		if( !fieldInfo ) {
+			ptWARN("'%s': no field named '%.*s' in '%s'\n", _path, nameLength, name, currentType->m_name.buffer);
+			return ERR_INVALID_PARAMETER;
+		}
+		const mxField* field = fieldInfo->field;
+		_compiled.offset += fieldInfo->offset;
+		currentType = &field->type;
+
+		// parse array subscripts
+		while( *p == '[' )
+		{
+			p++;
+			if( currentType->m_kind != ETypeKind::Type_Array ) {
+				ptWARN("'%s': '%s' is not an array\n", _path, field->name);
+				return ERR_INVALID_PARAMETER;
+			}
+			chkRET_X_IF_NOT(*p >= '0' && *p <= '9', ERR_FAILED_TO_PARSE_DATA);
+			UINT32 index = 0;
+			while( *p >= '0' && *p <= '9' ) {
+				const UINT32 digit = *p - '0';
+				if( index > (UINT32(~0) - digit) / 10 ) {
+					ptWARN("'%s': array index is too large\n", _path);
+					return ERR_INVALID_PARAMETER;
+				}
+				index = index * 10 + digit;
+				p++;
+			}
+			chkRET_X_IF_NOT(*p == ']', ERR_FAILED_TO_PARSE_DATA);
+			p++;
+
+			const mxArray& arrayType = currentType->UpCast< mxArray >();
+			mxDO(AddStep( _compiled, PathStep_Array, &arrayType, index, _path ));
+			currentType = &arrayType.m_itemType;
+		}
+
+		if( *p == '\0' ) {
+			break;
+		}
+		chkRET_X_IF_NOT(*p == '.', ERR_FAILED_TO_PARSE_DATA);
+		p++;
+	}
+
+	_compiled.type = currentType;
+	return ALL_OK;
+}
+
+void* ResolvePathWithSteps( const mxPropertyPath& _path, void* _o )
+{
+	void* current = _o;
+	for( UINT32 i = 0; i < _path.numSteps; i++ )
+	{
+		const mxPathStep& step = _path.steps[i];
+		void* address = mxAddByteOffset( current, step.offset );
+		if( step.op == PathStep_Pointer )
+		{
+			current = *static_cast< void** >( address );
+			if( !current ) {
+				return nil;
+			}
+		}
+		else
+		{
+			const mxArray& arrayType = *step.array;
+			if( step.index >= arrayType.Generic_Get_Count( address ) ) {
+				return nil;
+			}
+			current = mxAddByteOffset( arrayType.Generic_Get_Data( address ), step.index * arrayType.m_itemSize );
+		}
+	}
+	return mxAddByteOffset( current, _path.offset );
+}
+
+void ResolvePaths( const mxPropertyPath& _path, void* _objects, UINT32 _count, UINT32 _stride, void* _properties[] )
+{
+	mxASSERT(_path.IsValid());
+	if( _path.IsDirect() )
+	{
+		BYTE* property = static_cast< BYTE* >( _objects ) + _path.offset;
+		for( UINT32 i = 0; i < _count; i++ )
+		{
+			_properties[i] = property;
+			property += _stride;
+		}
+		return;
+	}
+	for( UINT32 i = 0; i < _count; i++ )
+	{
+		_properties[i] = ResolvePathWithSteps( _path, mxAddByteOffset( _objects, i * _stride ) );
+	}
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
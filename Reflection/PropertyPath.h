@@ -0,0 +1,205 @@
+/*
+=============================================================================
+	File:	PropertyPath.h
+	Desc:	Compiled paths to reflected properties,
+			e.g. "bindings.uniforms[3].name" for tools, scripting and animation.
+=============================================================================
+*/
+#pragma once
+
+#include <Base/Object/Reflection.h>
+
+/*
+-----------------------------------------------------------------------------
+	mxPropertyPath
+
+	a property path resolved into a chain of byte offsets:
+	field names are looked up only once (in CompilePath()),
+	evaluating the path only dereferences pointers and indexes arrays.
+-----------------------------------------------------------------------------
+*/
+enum EPathStep
+{
+	PathStep_Pointer,	// dereference the pointer
+	PathStep_Array,		// index the array
+};
+
+struct mxPathStep
+{
+	UINT32			op;		// EPathStep
+	UINT32			offset;	// byte offset of the pointer/array from the current address
+	UINT32			index;	// array index
+	const mxArray *	array;
+};
+
+struct mxPropertyPath
+{
+	enum { MAX_STEPS = 8 };
+
+	mxPathStep		steps[MAX_STEPS];
+	UINT32			numSteps;
+	UINT32			offset;		// byte offset of the property after the last step
+	const mxType *	type;		// type of the property
+	const mxClass *	rootType;	// type of the object the path starts from
+
+public:
+	mxPropertyPath()
+	{
+		numSteps = 0;
+		offset = 0;
+		type = nil;
+		rootType = nil;
+	}
+	bool IsValid() const
+	{
+		return type != nil;
+	}
+	// the property is embedded into the object (there are no pointers and arrays in the path)
+	bool IsDirect() const
+	{
+		return numSteps == 0;
+	}
+};
+
+namespace Reflection
+{
+	// Resolves the path (a sequence of field names separated by '.',
+	// array elements are addressed with '[index]') into a chain of offsets.
+	// Pointers to objects are dereferenced implicitly: "mesh.material.name".
+	ERet CompilePath( const mxClass& _type, const char* _path, mxPropertyPath &_compiled );
+
+	// returns NULL if a pointer in the path is null or an array index is out of range
+	void* ResolvePathWithSteps( const mxPropertyPath& _path, void* _o );
+
+	inline void* ResolvePath( const mxPropertyPath& _path, void* _o )
+	{
+		mxASSERT(_path.IsValid());
+		if( _path.IsDirect() ) {
+			return mxAddByteOffset( _o, _path.offset );
+		}
+		return ResolvePathWithSteps( _path, _o );
+	}
+
+	template< typename TYPE >
+	inline TYPE* GetPropertyPtr( const mxPropertyPath& _path, void* _o )
+	{
+		mxASSERT(_path.type->m_size == sizeof(TYPE));
+		mxASSERT(_path.type->m_kind == T_DeduceTypeInfo< TYPE >().m_kind);
+		return static_cast< TYPE* >( ResolvePath( _path, _o ) );
+	}
+
+	template< typename TYPE >
+	inline bool GetProperty( const mxPropertyPath& _path, const void* _o, TYPE &_value )
+	{
+		const TYPE* property = GetPropertyPtr< TYPE >( _path, c_cast(void*)_o );
+		if( property ) {
+			_value = *property;
+			return true;
+		}
+		return false;
+	}
+
+	template< typename TYPE >
+	inline bool SetProperty( const mxPropertyPath& _path, void* _o, const TYPE& _value )
+	{
+		TYPE* property = GetPropertyPtr< TYPE >( _path, _o );
+		if( property ) {
+			*property = _value;
+			return true;
+		}
+		return false;
+	}
+
+	//
+	//	Batch API: applies the path to an array of objects.
+	//
+
+	// resolves the path for each object, unresolved properties are set to NULL
+	void ResolvePaths( const mxPropertyPath& _path, void* _objects, UINT32 _count, UINT32 _stride, void* _properties[] );
+
+	// assigns the same value to all objects, returns the number of modified objects
+	template< typename TYPE >
+	UINT32 SetProperties( const mxPropertyPath& _path, void* _objects, UINT32 _count, UINT32 _stride, const TYPE& _value )
+	{
+		mxASSERT(_path.type->m_size == sizeof(TYPE));
+		mxASSERT(_path.type->m_kind == T_DeduceTypeInfo< TYPE >().m_kind);
+		UINT32 numSet = 0;
+		if( _path.IsDirect() )
+		{
+			// a tight strided loop
+			BYTE* property = static_cast< BYTE* >( _objects ) + _path.offset;
+			for( UINT32 i = 0; i < _count; i++ )
+			{
+				*reinterpret_cast< TYPE* >( property ) = _value;
+				property += _stride;
+			}
+			return _count;
+		}
+		for( UINT32 i = 0; i < _count; i++ )
+		{
+			TYPE* property = static_cast< TYPE* >( ResolvePathWithSteps( _path, mxAddByteOffset( _objects, i * _stride ) ) );
+			if( property ) {
+				*property = _value;
+				numSet++;
+			}
+		}
+		return numSet;
+	}
+
+	// assigns individual values (one for each object)
+	template< typename TYPE >
+	UINT32 SetPropertyValues( const mxPropertyPath& _path, void* _objects, UINT32 _count, UINT32 _stride, const TYPE* _values )
+	{
+		mxASSERT(_path.type->m_size == sizeof(TYPE));
+		mxASSERT(_path.type->m_kind == T_DeduceTypeInfo< TYPE >().m_kind);
+		UINT32 numSet = 0;
+		for( UINT32 i = 0; i < _count; i++ )
+		{
+			TYPE* property = static_cast< TYPE* >( ResolvePath( _path, mxAddByteOffset( _objects, i * _stride ) ) );
+			if( property ) {
+				*property = _values[i];
+				numSet++;
+			}
+		}
+		return numSet;
+	}
+
+	// unresolved properties are not written, returns the number of read values
+	template< typename TYPE >
+	UINT32 GetProperties( const mxPropertyPath& _path, const void* _objects, UINT32 _count, UINT32 _stride, TYPE* _values )
+	{
+		mxASSERT(_path.type->m_size == sizeof(TYPE));
+		mxASSERT(_path.type->m_kind == T_DeduceTypeInfo< TYPE >().m_kind);
+		UINT32 numRead = 0;
+		for( UINT32 i = 0; i < _count; i++ )
+		{
+			const TYPE* property = static_cast< const TYPE* >( ResolvePath( _path, mxAddByteOffset( c_cast(void*)_objects, i * _stride ) ) );
+			if( property ) {
+				_values[i] = *property;
+				numRead++;
+			}
+		}
+		return numRead;
+	}
+
+	// OBJECT_LIST is an ObjectList (declared in the core engine module)
+	template< class OBJECT_LIST, typename TYPE >
+	UINT32 SetPropertyForAll( const mxPropertyPath& _path, OBJECT_LIST& _objectList, const TYPE& _value )
+	{
+		mxASSERT(_objectList.GetType().IsDerivedFrom( *_path.rootType ));
+		return SetProperties( _path, _objectList.GetArrayPtr(), _objectList.Num(), _objectList.GetStride(), _value );
+	}
+
+	// the number of values must be equal to the number of objects in the list
+	template< class OBJECT_LIST, typename TYPE >
+	UINT32 GetPropertyForAll( const mxPropertyPath& _path, const OBJECT_LIST& _objectList, TYPE* _values )
+	{
+		mxASSERT(_objectList.GetType().IsDerivedFrom( *_path.rootType ));
+		return GetProperties( _path, const_cast< OBJECT_LIST& >( _objectList ).GetArrayPtr(), _objectList.Num(), _objectList.GetStride(), _values );
+	}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -12,6 +12,8 @@
 
 #include <Base/Object/BaseType.h>
 #include <Base/Object/Reflection.h>
+#include <Base/Object/ClassPlan.h>
+#include <Base/Object/ParallelWalker.h>
 #include <Base/Text/String.h>
 
 #define MX_DEBUG_REFLECTION		(0)
@@ -228,61 +230,15 @@ void* PointerChecker::Visit_Pointer( VoidPointer& p, const mxPointerType& type,
 
 void ValidatePointers( const void* o, const mxClass& type )
 {
-	PointerChecker	pointerChecker;
-	Walker::Visit( const_cast<void*>(o), type, &pointerChecker, nil );
+	HeapPointerValidator	pointerChecker;
+	Walker2::Visit( const_cast<void*>(o), type, &pointerChecker );
 }
 
 void CheckAllPointersAreInRange( const void* o, const mxClass& type, const void* start, UINT32 size )
 {
-	class PointerRangeValidator : public Reflection::AVisitor
-	{
-		const void *	m_start;
-		const UINT		m_size;
-
-	public:
-		PointerRangeValidator( const void* start, UINT size )
-			: m_start( start ), m_size( size )
-		{}
-		virtual void* Visit_String( String & s, void* _userData ) override
-		{
-			if( s.NonEmpty() ) {
-				this->ValidatePointer( s.GetBufferAddress() );
-			}
-			return _userData;
-		}
-		virtual void* Visit_Array( void * arrayObject, const mxArray& arrayType, void* _userData ) override
-		{
-			if( arrayType.IsDynamic() )
-			{
-				const UINT32 capacity = arrayType.Generic_Get_Capacity( arrayObject );
-				if( capacity > 0 )
-				{
-					const void* arrayBase = arrayType.Generic_Get_Data( arrayObject );
-					this->ValidatePointer( arrayBase );
-				}
-			}
-			return Reflection::AVisitor::Visit_Array( arrayObject, arrayType, _userData );
-		}
-		virtual void* Visit_Pointer( VoidPointer& p, const mxPointerType& type, void* _userData ) override
-		{
-			if( p.o != nil )
-			{
-				this->ValidatePointer( p.o );
-			}
-			return _userData;
-		}
-
-	private:
-		void ValidatePointer( const void* pointer )
-		{
-			if( !mxPointerInRange( pointer, m_start, m_size ) )
-			{
-				ptERROR("Invalid pointer\n");
-			}
-		}
-	};
+	// large arrays of objects are checked on several threads
 	PointerRangeValidator	pointerChecker( start, size );
-	Reflection::Walker::Visit( const_cast<void*>(o), type, &pointerChecker, nil );
+	ParallelWalker::Visit( const_cast<void*>(o), type, &pointerChecker, ParallelWalkSettings() );
 }
 
 //=====================================================================
@@ -394,6 +350,16 @@ void Walker2::VisitArray( void * _array, const mxArray& _type, AVisitor2* _visit
 		mxASSERT( arrayContentsSize < DBG_MAX_ARRAY_CONTENTS_SIZE );
 #endif // MX_DEBUG
 
+		if( CanSkipType( itemType, _visitor->m_interests ) ) {
+			return;
+		}
+
+		if( numObjects && IsPlainType( itemType )
+			&& _visitor->Visit_PODArray( c_cast(void*)arrayBase, itemType, numObjects, itemStride, _context ) )
+		{
+			return;
+		}
+
 		AVisitor2::Context	itemContext( _context.depth + 1 );
 		itemContext.parent = &_context;
 		itemContext.userData = _context.userData;
@@ -434,11 +400,27 @@ void Walker2::VisitAggregate( void * _struct, const mxClass& _type, AVisitor2* _
 
 void Walker2::VisitStructFields( void * _struct, const mxClass& _type, AVisitor2* _visitor, const AVisitor2::Context& _context )
 {
+	const bool trackPath = (_visitor->m_flags & Visitor_TrackPath) != 0;
+
 	const mxClassLayout& layout = _type.GetLayout();
 	for( UINT fieldIndex = 0 ; fieldIndex < layout.numFields; fieldIndex++ )
 	{
 		const mxField& field = layout.fields[ fieldIndex ];
-		
+
+		if( CanSkipType( field.type, _visitor->m_interests ) ) {
+			continue;
+		}
+
+		if( !trackPath )
+		{
+			// the context is only used for passing userData
+			void* memberVarPtr = mxAddByteOffset( _struct, field.offset );
+			if( _visitor->Visit_Field( memberVarPtr, field, _context ) ) {
+				Visit( memberVarPtr, field.type, _visitor, _context );
+			}
+			continue;
+		}
+
 		AVisitor2::Context	fieldContext( _context.depth + 1 );
 		fieldContext.parent = &_context;
 		fieldContext.member = &field;
@@ -476,6 +458,89 @@ void MarkMemoryAsExternallyAllocated( void* _memory, const mxClass& _type )
 	Reflection::Walker2::Visit( _memory, _type, &markMemoryAsExternallyAllocated );
 }
 
+UINT32 AVisitor2::Context::GetPath( char *_buffer, UINT32 _bufferSize ) const
+{
+	mxASSERT(_bufferSize > 0);
+
+	// collect the members from the root
+	enum { MAX_DEPTH = 64 };
+	const mxField *	members[ MAX_DEPTH ];
+	UINT32 numMembers = 0;
+	for( const Context* current = this; current != nil; current = current->parent )
+	{
+		if( current->member && numMembers < MAX_DEPTH ) {
+			members[ numMembers++ ] = current->member;
+		}
+	}
+
+	UINT32 length = 0;
+	while( numMembers-- > 0 )
+	{
+		const char* name = members[ numMembers ]->name;
+		if( length && length + 1 < _bufferSize ) {
+			_buffer[ length++ ] = '.';
+		}
+		while( *name && length + 1 < _bufferSize ) {
+			_buffer[ length++ ] = *name++;
+		}
+	}
+	_buffer[ length ] = '\0';
+	return length;
+}
+
+bool HeapPointerValidator::Visit_Array( void * _array, const mxArray& _type, const Context& _context )
+{
+	ValidatePointer( _type.Generic_Get_Data( _array ) );
+	return true;
+}
+
+void HeapPointerValidator::Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context )
+{
+	ValidatePointer( _pointer.o );
+}
+
+bool PointerRangeValidator::Visit_Array( void * _array, const mxArray& _type, const Context& _context )
+{
+	if( _type.IsDynamic() && _type.Generic_Get_Capacity( _array ) > 0 )
+	{
+		this->ValidatePointer( _type.Generic_Get_Data( _array ), _context );
+	}
+	return true;
+}
+
+void PointerRangeValidator::Visit_String( String & _string, const Context& _context )
+{
+	if( _string.NonEmpty() ) {
+		this->ValidatePointer( _string.GetBufferAddress(), _context );
+	}
+}
+
+void PointerRangeValidator::Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context )
+{
+	if( _pointer.o != nil ) {
+		this->ValidatePointer( _pointer.o, _context );
+	}
+}
+
+AParallelVisitor* PointerRangeValidator::Fork()
+{
+	return new PointerRangeValidator( m_start, m_size );
+}
+
+void PointerRangeValidator::Join( AParallelVisitor* _forked )
+{
+	m_numErrors += static_cast< PointerRangeValidator* >( _forked )->m_numErrors;
+}
+
+void PointerRangeValidator::ValidatePointer( const void* _pointer, const Context& _context )
+{
+	if( !mxPointerInRange( _pointer, m_start, m_size ) )
+	{
+		ptERROR("Invalid pointer in '%s' (%s)\n", _context.GetMemberName(), _context.GetMemberType());
+		m_numErrors++;
+	}
+}
+
 }//namespace Reflection
 
 //--------------------------------------------------------------//
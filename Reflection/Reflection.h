@@ -23,6 +23,16 @@
 // this is defined in the core engine module
 struct AssetID;
 
+namespace Reflection
+{
+	// this is implemented in the core engine module (see Serialization.cpp) (used for cloning objects);
+	// if '_isConstructed' is false, the destination is constructed in-place.
+	void CopyAssetID( AssetID * _dst, const AssetID& _src, bool _isConstructed );
+
+	// returns the name (path) of the asset, used for comparing and hashing asset ids
+	const char* GetAssetIDName( const AssetID& _assetId );
+}
+
 enum EFieldFlags
 {
 	// The field won't be initialized with default values (e.g. fallback resources).
@@ -294,9 +304,33 @@ protected:
 };
 
 
+// summary of what values of a type contain (including array elements and base classes),
+// walkers use this to skip subtrees which are of no interest to the visitor.
+enum ETypeContents
+{
+	TypeHas_Pointers	= BIT(0),	// raw pointers and user pointers
+	TypeHas_OwnedMemory	= BIT(1),	// strings and dynamic arrays
+	TypeHas_ClassIds	= BIT(2),
+	TypeHas_AssetIds	= BIT(3),
+
+	// the walkers visit everything (including plain data)
+	TypeHas_Everything	= ~0
+};
+
+// visitor options
+enum EVisitorFlags
+{
+	// build a new context for every field (with the parent, member and depth),
+	// otherwise all callbacks receive the context passed to the walker.
+	// NOTE: required if the visitor changes userData for the children in callbacks.
+	Visitor_TrackPath	= BIT(0),
+};
+
 class AVisitor2
 {
 	friend class Walker2;
+	friend class IterativeWalker;
+	friend struct ParallelWalker;
 
 public:
 	// for passing parameters between callbacks
@@ -324,6 +358,9 @@ public:
 		const char* GetMemberType() const {
 			return member ? member->type.m_name.buffer : userName;
 		}
+		// writes the path from the root, e.g. "meshes.parts.material";
+		// returns the length of the path (the path is truncated if the buffer is too small)
+		UINT32 GetPath( char *_buffer, UINT32 _bufferSize ) const;
 	};
 protected:
 	// return false to skip further processing
@@ -347,6 +384,13 @@ protected:
 	// return false to skip processing the array elements
 	virtual bool Visit_Array( void * _array, const mxArray& _type, const Context& _context ) {return true;}
 
+	// arrays of plain data (integers, floats, bools, enums, flags
+	// and classes without strings, arrays, pointers, etc.), called after Visit_Array().
+	// return true if all elements have been processed,
+	// otherwise they will be visited one by one.
+	virtual bool Visit_PODArray( void * _base, const mxType& _itemType, UINT32 _count, UINT32 _stride, const Context& _context )
+	{ return false; }
+
 	// 'Leaf' types:
 
 	// built-in types (int, float, bool), enums, bitmasks
@@ -360,10 +404,52 @@ protected:
 	virtual void Visit_UserPointer( void * _pointer, const mxUserPointerType& _type, const Context& _context ) {}
 
 protected:
+	// the visitor will only be called for values of types containing these (ETypeContents),
+	// e.g. TypeHas_OwnedMemory means: skip pointers and plain data
+	// '_flags' - EVisitorFlags, path tracking is disabled by default
+	AVisitor2( UINT32 _interests = TypeHas_Everything, UINT32 _flags = 0 )
+		: m_interests( _interests )
+		, m_flags( _flags )
+	{}
 	virtual ~AVisitor2() {}
+
+protected:
+	const UINT32	m_interests;
+	const UINT32	m_flags;
+};
+
+/*
+-----------------------------------------------------------------------------
+	AParallelVisitor
+
+	read-only visitor which can be used on several threads at once.
+	"fork/join" contract:
+	- before a large array is split, Fork() is called on the calling thread
+	  for each additional worker, the forked visitor holds per-worker state;
+	- elements of the array are visited by the original visitor
+	  and by the forked ones in parallel (in no particular order);
+	- after all elements have been visited, Join() is called on the original visitor
+	  for each forked visitor (in the order they were forked), then the forked visitor is deleted.
+	NOTE: the reduction in Join() must not depend on the order of elements
+	(e.g. counting, summing, validation, logical AND),
+	otherwise store per-element results by the element's index.
+-----------------------------------------------------------------------------
+*/
+class AParallelVisitor : public AVisitor2
+{
+public:
+	AParallelVisitor( UINT32 _interests = TypeHas_Everything, UINT32 _flags = 0 )
+		: AVisitor2( _interests, _flags )
+	{}
+
+	virtual AParallelVisitor* Fork() = 0;
+	virtual void Join( AParallelVisitor* _forked ) = 0;
+
+	virtual ~AParallelVisitor() {}
 };
 
 // Object/Field iterator
+// NOTE: see TWalker.h for the static version (with inlined callbacks)
 struct Walker2 {
 	static void Visit( void * _memory, const mxType& _type, AVisitor2* _visitor, void *_userData = nil );
 	static void VisitArray( void * _array, const mxArray& _type, AVisitor2* _visitor, void* _userData = nil );
@@ -379,6 +465,8 @@ struct Walker2 {
 struct TellNotToFreeMemory : public Reflection::AVisitor2
 {
 	typedef Reflection::AVisitor Super;
+	TellNotToFreeMemory() : AVisitor2( TypeHas_OwnedMemory )
+	{}
 	//-- Reflection::AVisitor
 	virtual bool Visit_Array( void * _array, const mxArray& _type, const Context& _context ) override;
 	virtual void Visit_String( String & _string, const Context& _context ) override;
@@ -386,10 +474,91 @@ struct TellNotToFreeMemory : public Reflection::AVisitor2
 
 void MarkMemoryAsExternallyAllocated( void* _memory, const mxClass& _type );
 
+// AVisitor2 versions of ValidatePointers() and CheckAllPointersAreInRange(),
+// e.g. for validating large object graphs in the background with IterativeWalker.
+class HeapPointerValidator : public Reflection::AVisitor2
+{
+public:
+	HeapPointerValidator() : AVisitor2( TypeHas_Pointers | TypeHas_OwnedMemory )
+	{}
+protected:
+	virtual bool Visit_Array( void * _array, const mxArray& _type, const Context& _context ) override;
+	virtual void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context ) override;
+};
+
+// can be used with ParallelWalker, the forked validators count their own errors
+class PointerRangeValidator : public Reflection::AParallelVisitor
+{
+	const void *	m_start;
+	const UINT32	m_size;
+	UINT32			m_numErrors;
+public:
+	PointerRangeValidator( const void* _start, UINT32 _size )
+		: AParallelVisitor( TypeHas_Pointers | TypeHas_OwnedMemory, Visitor_TrackPath )
+		, m_start( _start ), m_size( _size ), m_numErrors( 0 )
+	{}
+	UINT32 NumErrors() const { return m_numErrors; }
+	//-- AParallelVisitor
+	virtual AParallelVisitor* Fork() override;
+	virtual void Join( AParallelVisitor* _forked ) override;
+protected:
+	virtual bool Visit_Array( void * _array, const mxArray& _type, const Context& _context ) override;
+	virtual void Visit_String( String & _string, const Context& _context ) override;
+	virtual void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context ) override;
+private:
+	void ValidatePointer( const void* _pointer, const Context& _context );
+};
+
 bool HasCrossPlatformLayout( const mxClass& _type );
 
+// Deep comparison: compares strings and contents of arrays,
+// pointers are compared by address, padding bytes are ignored.
+// NOTE: floating-point values are compared bitwise.
 bool ObjectsAreEqual( const mxClass& _type1, const void* _o1, const mxClass& _type2, const void* _o2 );
 
+// compares two values of any type (e.g. array elements)
+bool ValuesAreEqual( const mxType& _type, const void* _v1, const void* _v2 );
+
+// skips the deep comparison if the (cached) content hashes don't match
+inline bool ObjectsAreEqual( const mxClass& _type, const void* _o1, UINT64 _hash1, const void* _o2, UINT64 _hash2 )
+{
+	return _hash1 == _hash2 && ObjectsAreEqual( _type, _o1, _type, _o2 );
+}
+
+// Content hash: follows strings and arrays, ignores padding bytes
+// and doesn't depend on memory layout (e.g. field alignment).
+// NOTE: pointers only contribute their null-ness (heap addresses are not stable).
+UINT64 HashObject( const void* _o, const mxType& _type, UINT64 _seed = 0 );
+void HashObject128( const void* _o, const mxType& _type, UINT64 _hash[2], UINT64 _seed = 0 );
+
+// Deep copy: duplicates strings and arrays (with exact capacity)
+// and redirects pointers into the copied memory to the clone
+// (pointers to external objects are copied as-is).
+// NOTE: the destination must be a default-constructed object of the same type.
+ERet Clone( void * _dst, const void* _src, const mxClass& _type );
+
+template< class CLASS >
+ERet Clone( CLASS & _dst, const CLASS& _src )
+{
+	return Clone( &_dst, &_src, mxCLASS_OF(_src) );
+}
+
+// Clones the object into a single memory block,
+// arrays and strings of the clone point into this block and don't own their memory.
+// NOTE: arrays keep the capacity of the source, so that the clone can be modified.
+// The returned memory must be released with mxFree() (after calling the destructor, if needed).
+ERet CloneIntoSingleBlock( void *& _clone, const void* _src, const mxClass& _type );
+
+// Binary diff: stores only the modified fields (identified by indices in the class plan),
+// the changed bytes of POD spans and inserted/removed/modified ranges of array elements.
+// The patch is empty if the objects are equal.
+// NOTE: pointers and asset ids are not patched.
+ERet Diff( const void* _old, const void* _new, const mxClass& _type, TArray< BYTE > & _patch );
+
+// Applies the patch created by Diff() to the old version of the object.
+// NOTE: the patch is validated, but the object may be partially modified if it's malformed.
+ERet ApplyPatch( void * _o, const mxClass& _type, const void* _patch, UINT32 _size );
+
 }//namespace Reflection
 
 
@@ -0,0 +1,239 @@
+/*
+=============================================================================
+	File:	TWalker.h
+	Desc:	Static (compile-time) version of Walker2:
+			visitor callbacks are resolved at compile time and can be inlined.
+=============================================================================
+*/
+#pragma once
+
+#include <Base/Object/Reflection.h>
+#include <Base/Object/ArrayDescriptor.h>
+#include <Base/Object/PointerType.h>
+#include <Base/Object/UserPointerType.h>
+#include <Base/Object/ClassPlan.h>
+
+namespace Reflection
+{
+
+/*
+-----------------------------------------------------------------------------
+	StaticVisitorBase
+
+	default callbacks for visitors used with TWalker< VISITOR >:
+	derived visitors hide (not override!) the functions they need,
+	the signatures are the same as in AVisitor2.
+-----------------------------------------------------------------------------
+*/
+struct StaticVisitorBase
+{
+	typedef AVisitor2::Context Context;
+
+	// values of types which don't contain these (ETypeContents) are skipped
+	static UINT32 GetInterests() { return TypeHas_Everything; }
+
+	// EVisitorFlags, path tracking is disabled by default
+	static UINT32 GetFlags() { return 0; }
+
+	// return false to skip further processing
+	bool Visit_Field( void * _memory, const mxField& _field, const Context& _context )
+	{ return true; }
+
+	bool Visit_Class( void * _object, const mxClass& _type, const Context& _context )
+	{ return true; }
+
+	// return false to skip processing the array elements
+	bool Visit_Array( void * _array, const mxArray& _type, const Context& _context )
+	{ return true; }
+
+	// return true if all elements of the plain array have been processed
+	bool Visit_PODArray( void * _base, const mxType& _itemType, UINT32 _count, UINT32 _stride, const Context& _context )
+	{ return false; }
+
+	void Visit_POD( void * _memory, const mxType& _type, const Context& _context ) {}
+	void Visit_String( String & _string, const Context& _context ) {}
+	void Visit_TypeId( SClassId * _class, const Context& _context ) {}
+	void Visit_AssetId( AssetID & _assetId, const Context& _context ) {}
+
+	void Visit_Pointer( VoidPointer & _pointer, const mxPointerType& _type, const Context& _context ) {}
+	void Visit_UserPointer( void * _pointer, const mxUserPointerType& _type, const Context& _context ) {}
+};
+
+/*
+-----------------------------------------------------------------------------
+	TWalker
+
+	visits objects in the same order as Walker2,
+	but calls non-virtual member functions of the visitor.
+	Walker2 should be used when the visitor's type is not known at compile time.
+-----------------------------------------------------------------------------
+*/
+template< class VISITOR >
+struct TWalker
+{
+	typedef AVisitor2::Context Context;
+
+	static void Visit( void * _memory, const mxType& _type, VISITOR & _visitor, const Context& _context )
+	{
+		switch( _type.m_kind )
+		{
+		case ETypeKind::Type_Integer :
+		case ETypeKind::Type_Float :
+		case ETypeKind::Type_Bool :
+		case ETypeKind::Type_Enum :
+		case ETypeKind::Type_Flags :
+			_visitor.Visit_POD( _memory, _type, _context );
+			break;
+
+		case ETypeKind::Type_String :
+			_visitor.Visit_String( TPODCast< String >::GetNonConst( _memory ), _context );
+			break;
+
+		case ETypeKind::Type_Class :
+			VisitAggregate( _memory, _type.UpCast< mxClass >(), _visitor, _context );
+			break;
+
+		case ETypeKind::Type_Pointer :
+			_visitor.Visit_Pointer( *static_cast< VoidPointer* >( _memory ), _type.UpCast< mxPointerType >(), _context );
+			break;
+
+		case ETypeKind::Type_AssetId :
+			_visitor.Visit_AssetId( *static_cast< AssetID* >( _memory ), _context );
+			break;
+
+		case ETypeKind::Type_ClassId :
+			_visitor.Visit_TypeId( static_cast< SClassId* >( _memory ), _context );
+			break;
+
+		case ETypeKind::Type_UserData :
+			_visitor.Visit_UserPointer( _memory, _type.UpCast< mxUserPointerType >(), _context );
+			break;
+
+		case ETypeKind::Type_Blob :
+			Unimplemented;
+			break;
+
+		case ETypeKind::Type_Array :
+			VisitArray( _memory, _type.UpCast< mxArray >(), _visitor, _context );
+			break;
+
+			mxNO_SWITCH_DEFAULT;
+		}
+	}
+
+	static void Visit( void * _memory, const mxType& _type, VISITOR & _visitor, void *_userData = nil )
+	{
+		mxASSERT_PTR(_memory);
+
+		Context	context;
+		context.userData = _userData;
+
+		Visit( _memory, _type, _visitor, context );
+	}
+
+	static void VisitArray( void * _array, const mxArray& _type, VISITOR & _visitor, const Context& _context )
+	{
+		mxASSERT_PTR(_array);
+		if( _visitor.Visit_Array( _array, _type, _context ) )
+		{
+			const UINT numObjects = _type.Generic_Get_Count( _array );
+			void* arrayBase = _type.Generic_Get_Data( _array );
+
+			const mxType& itemType = _type.m_itemType;
+			const UINT32 itemStride = _type.m_itemSize;
+
+			if( CanSkipType( itemType, _visitor.GetInterests() ) ) {
+				return;
+			}
+
+			if( numObjects && IsPlainType( itemType )
+				&& _visitor.Visit_PODArray( arrayBase, itemType, numObjects, itemStride, _context ) )
+			{
+				return;
+			}
+
+			Context	itemContext( _context.depth + 1 );
+			itemContext.parent = &_context;
+			itemContext.userData = _context.userData;
+
+			for( UINT32 iObject = 0; iObject < numObjects; iObject++ )
+			{
+				Visit( mxAddByteOffset( arrayBase, iObject * itemStride ), itemType, _visitor, itemContext );
+			}
+		}
+	}
+
+	static void VisitAggregate( void * _struct, const mxClass& _type, VISITOR & _visitor, const Context& _context )
+	{
+		mxASSERT_PTR(_struct);
+		if( _visitor.Visit_Class( _struct, _type, _context ) )
+		{
+			// First recursively visit the parent classes.
+			const mxClass* parentType = _type.GetParent();
+			while( parentType != nil )
+			{
+				VisitStructFields( _struct, *parentType, _visitor, _context );
+				parentType = parentType->GetParent();
+			}
+
+			// Now visit the members of this class.
+			VisitStructFields( _struct, _type, _visitor, _context );
+		}
+	}
+
+	static void VisitStructFields( void * _struct, const mxClass& _type, VISITOR & _visitor, const Context& _context )
+	{
+		const bool trackPath = (_visitor.GetFlags() & Visitor_TrackPath) != 0;
+
+		const mxClassLayout& layout = _type.GetLayout();
+		for( UINT fieldIndex = 0 ; fieldIndex < layout.numFields; fieldIndex++ )
+		{
+			const mxField& field = layout.fields[ fieldIndex ];
+
+			if( CanSkipType( field.type, _visitor.GetInterests() ) ) {
+				continue;
+			}
+
+			if( !trackPath )
+			{
+				// the context is only used for passing userData
+				void* memberVarPtr = mxAddByteOffset( _struct, field.offset );
+				if( _visitor.Visit_Field( memberVarPtr, field, _context ) ) {
+					Visit( memberVarPtr, field.type, _visitor, _context );
+				}
+				continue;
+			}
+
+			Context	fieldContext( _context.depth + 1 );
+			fieldContext.parent = &_context;
+			fieldContext.member = &field;
+			fieldContext.userData = _context.userData;
+
+			void* memberVarPtr = mxAddByteOffset( _struct, field.offset );
+
+			if( _visitor.Visit_Field( memberVarPtr, field, fieldContext ) )
+			{
+				Visit( memberVarPtr, field.type, _visitor, fieldContext );
+			}
+		}
+	}
+};
+
+// deduces the type of the visitor
+template< class VISITOR >
+inline void StaticWalk( void * _memory, const mxType& _type, VISITOR & _visitor, void *_userData = nil )
+{
+	TWalker< VISITOR >::Visit( _memory, _type, _visitor, _userData );
+}
+
+template< class VISITOR >
+inline void StaticWalk( void * _memory, const mxType& _type, VISITOR & _visitor, const AVisitor2::Context& _context )
+{
+	TWalker< VISITOR >::Visit( _memory, _type, _visitor, _context );
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
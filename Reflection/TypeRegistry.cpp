@@ -12,6 +12,8 @@
 
 #include <Base/Object/BaseType.h>
 #include <Base/Object/TypeRegistry.h>
+#include <Base/Object/ClassPlan.h>
+#include <Base/Object/FieldIndex.h>
 
 /*
 -----------------------------------------------------------------------------
@@ -90,6 +92,10 @@ void TypeRegistry::Initialize()
 
 				gPtr->m_typesByName.Set( classNameStr, current );
 
+				// Flatten the class layout now so that it can be safely used from multiple threads.
+				Reflection::GetClassPlan( *current );
+				Reflection::GetFieldIndex( *current );
+
 				current = next;
 
 				classIndex++;
@@ -102,6 +108,14 @@ void TypeRegistry::Destroy()
 {
 	if ( nil != gPtr )
 	{
+		mxClass* current = mxClass::m_head;
+		while( PtrToBool(current) )
+		{
+			Reflection::ReleaseClassPlan( *current );
+			Reflection::ReleaseFieldIndex( *current );
+			current = current->m_next;
+		}
+
 		gPtr.Destruct();
 	}
 }
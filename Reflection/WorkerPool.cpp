@@ -0,0 +1,164 @@
+/*
+=============================================================================
+	File:	WorkerPool.cpp
+	Desc:	Persistent worker threads shared by the parallel walker and loaders.
+=============================================================================
+*/
+#include <Base/Base_PCH.h>
+#pragma hdrstop
+#include <Base/Base.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <Base/Object/WorkerPool.h>
+
+namespace Reflection
+{
+
+// runs one worker of a RunOnWorkers() call on a pool thread
+struct SWorkerJob
+{
+	WorkerFunction *	function;
+	void *				context;
+	UINT32				workerIndex;
+	UINT32 *			numPendingJobs;	// protected by the mutex of the worker pool
+};
+
+/*
+-----------------------------------------------------------------------------
+	WorkerPool
+	persistent threads shared by all RunOnWorkers() calls,
+	started on first use (the pool never shrinks) and joined at exit.
+-----------------------------------------------------------------------------
+*/
+class WorkerPool
+{
+	enum { MAX_QUEUED_JOBS = MAX_WORKERS * 4 };
+
+	std::mutex				m_mutex;
+	std::condition_variable	m_jobPosted;	// a job has been queued or the pool is shutting down
+	std::condition_variable	m_jobFinished;
+	SWorkerJob				m_jobs[ MAX_QUEUED_JOBS ];	// ring buffer
+	UINT32					m_firstJob;
+	UINT32					m_numJobs;
+	std::thread				m_threads[ MAX_WORKERS ];
+	UINT32					m_numThreads;
+	bool					m_quit;
+
+public:
+	WorkerPool()
+		: m_firstJob( 0 ), m_numJobs( 0 ), m_numThreads( 0 ), m_quit( false )
+	{}
+	~WorkerPool()
+	{
+		{
+			std::lock_guard< std::mutex >	lock( m_mutex );
+			m_quit = true;
+		}
+		m_jobPosted.notify_all();
+		for( UINT32 i = 0; i < m_numThreads; i++ ) {
+			m_threads[i].join();
+		}
+	}
+
+	void Reserve( UINT32 _numThreads )
+	{
+		std::lock_guard< std::mutex >	lock( m_mutex );
+		_numThreads = smallest( _numThreads, (UINT32)MAX_WORKERS );
+		while( m_numThreads < _numThreads ) {
+			m_threads[ m_numThreads++ ] = std::thread( &WorkerPool::ThreadMain, this );
+		}
+	}
+
+	// blocks while the queue is full (several callers can use the pool at once)
+	void Post( const SWorkerJob& _job )
+	{
+		std::unique_lock< std::mutex >	lock( m_mutex );
+		while( m_numJobs == MAX_QUEUED_JOBS ) {
+			m_jobFinished.wait( lock );
+		}
+		m_jobs[ (m_firstJob + m_numJobs) % MAX_QUEUED_JOBS ] = _job;
+		m_numJobs++;
+		(*_job.numPendingJobs)++;
+		lock.unlock();
+		m_jobPosted.notify_one();
+	}
+
+	void WaitForJobs( const UINT32& _numPendingJobs )
+	{
+		std::unique_lock< std::mutex >	lock( m_mutex );
+		while( _numPendingJobs ) {
+			m_jobFinished.wait( lock );
+		}
+	}
+
+private:
+	void ThreadMain()
+	{
+		std::unique_lock< std::mutex >	lock( m_mutex );
+		for(;;)
+		{
+			while( !m_numJobs && !m_quit ) {
+				m_jobPosted.wait( lock );
+			}
+			// the queued jobs are finished before quitting
+			if( !m_numJobs ) {
+				return;
+			}
+			const SWorkerJob job = m_jobs[ m_firstJob ];
+			m_firstJob = (m_firstJob + 1) % MAX_QUEUED_JOBS;
+			m_numJobs--;
+
+			lock.unlock();
+			(*job.function)( job.context, job.workerIndex );
+			lock.lock();
+
+			(*job.numPendingJobs)--;
+			m_jobFinished.notify_all();
+		}
+	}
+};
+
+static WorkerPool& GetWorkerPool()
+{
+	static WorkerPool pool;
+	return pool;
+}
+
+void RunOnWorkers( WorkerFunction* _function, void* _context, UINT32 _numWorkers )
+{
+	mxASSERT_PTR(_function);
+	mxASSERT(_numWorkers <= MAX_WORKERS);
+
+	UINT32	numPendingJobs = 0;
+
+	if( _numWorkers > 1 )
+	{
+		WorkerPool & pool = GetWorkerPool();
+		pool.Reserve( _numWorkers - 1 );
+
+		for( UINT32 i = 1; i < _numWorkers; i++ )
+		{
+			SWorkerJob	job;
+			job.function = _function;
+			job.context = _context;
+			job.workerIndex = i;
+			job.numPendingJobs = &numPendingJobs;
+			pool.Post( job );
+		}
+	}
+
+	(*_function)( _context, 0 );
+
+	if( _numWorkers > 1 ) {
+		GetWorkerPool().WaitForJobs( numPendingJobs );
+	}
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//
@@ -0,0 +1,48 @@
+/*
+=============================================================================
+	File:	WorkerPool.h
+	Desc:	Persistent worker threads shared by the parallel walker and loaders.
+=============================================================================
+*/
+#pragma once
+
+namespace Reflection
+{
+
+enum { MAX_WORKERS = 64 };	// including the calling thread
+
+typedef void WorkerFunction( void* _context, UINT32 _workerIndex );
+
+// calls '_function' with worker indices [0.._numWorkers) and returns when all calls have finished:
+// the calling thread is the first worker, the others run on a pool of persistent threads
+// (started on first use, the pool never shrinks and is joined at exit).
+// NOTE: must not be called from inside a worker function.
+void RunOnWorkers( WorkerFunction* _function, void* _context, UINT32 _numWorkers );
+
+template< class TASK >
+struct TWorkerThunk
+{
+	void	(*function)( TASK&, UINT32 );
+	TASK *	task;
+public:
+	static void Run( void* _context, UINT32 _workerIndex )
+	{
+		const TWorkerThunk& thunk = *static_cast< const TWorkerThunk* >( _context );
+		(*thunk.function)( *thunk.task, _workerIndex );
+	}
+};
+
+template< class TASK >
+inline void RunOnWorkers( void (*_function)( TASK&, UINT32 ), TASK & _task, UINT32 _numWorkers )
+{
+	TWorkerThunk< TASK >	thunk;
+	thunk.function = _function;
+	thunk.task = &_task;
+	RunOnWorkers( &TWorkerThunk< TASK >::Run, &thunk, _numWorkers );
+}
+
+}//namespace Reflection
+
+//--------------------------------------------------------------//
+//				End Of File.									//
+//--------------------------------------------------------------//